@@ -272,6 +272,13 @@ static const ALCfunction alcFunctions[] = {
 
     DECL(alBufferSubDataSOFT),
 
+    DECL(alBufferDataStaticSOFT),
+    DECL(alMapBufferSOFT),
+    DECL(alUnmapBufferSOFT),
+
+    DECL(alBufferDataAsyncSOFT),
+    DECL(alWaitBuffersSOFT),
+
     DECL(alBufferSamplesSOFT),
     DECL(alBufferSubSamplesSOFT),
     DECL(alGetBufferSamplesSOFT),
@@ -280,6 +287,19 @@ static const ALCfunction alcFunctions[] = {
     DECL(alDeferUpdatesSOFT),
     DECL(alProcessUpdatesSOFT),
 
+    DECL(alSourcePropsvSOFT),
+    DECL(alGetSourcePropsvSOFT),
+
+    DECL(alGetSourceHandleSOFT),
+    DECL(alReleaseSourceHandleSOFT),
+    DECL(alGetBufferHandleSOFT),
+    DECL(alReleaseBufferHandleSOFT),
+    DECL(alSourcefHandleSOFT),
+    DECL(alSource3fHandleSOFT),
+    DECL(alSourcePlayHandleSOFT),
+    DECL(alSourceStopHandleSOFT),
+    DECL(alSourceQueueBufferHandlesSOFT),
+
     DECL(alSourcedSOFT),
     DECL(alSource3dSOFT),
     DECL(alSourcedvSOFT),
@@ -538,6 +558,16 @@ static const ALCenums enumeration[] = {
     DECL(AL_SEC_LENGTH_SOFT),
     DECL(AL_UNPACK_BLOCK_ALIGNMENT_SOFT),
     DECL(AL_PACK_BLOCK_ALIGNMENT_SOFT),
+    DECL(AL_MAP_READ_BIT_SOFT),
+    DECL(AL_MAP_WRITE_BIT_SOFT),
+    DECL(AL_LOAD_PENDING_SOFT),
+    DECL(AL_PRERESAMPLE_SOFT),
+
+    DECL(AL_SOURCE_POSITION_BIT_SOFT),
+    DECL(AL_SOURCE_VELOCITY_BIT_SOFT),
+    DECL(AL_SOURCE_DIRECTION_BIT_SOFT),
+    DECL(AL_SOURCE_GAIN_BIT_SOFT),
+    DECL(AL_SOURCE_PITCH_BIT_SOFT),
 
     DECL(AL_UNUSED),
     DECL(AL_PENDING),
@@ -728,9 +758,11 @@ static const ALchar alExtList[] =
     "AL_EXT_ALAW AL_EXT_BFORMAT AL_EXT_DOUBLE AL_EXT_EXPONENT_DISTANCE "
     "AL_EXT_FLOAT32 AL_EXT_IMA4 AL_EXT_LINEAR_DISTANCE AL_EXT_MCFORMATS "
     "AL_EXT_MULAW AL_EXT_MULAW_BFORMAT AL_EXT_MULAW_MCFORMATS AL_EXT_OFFSET "
-    "AL_EXT_source_distance_model AL_LOKI_quadriphonic AL_SOFT_block_alignment "
-    "AL_SOFT_buffer_samples AL_SOFT_buffer_sub_data AL_SOFT_deferred_updates "
-    "AL_SOFT_direct_channels AL_SOFT_loop_points AL_SOFT_MSADPCM "
+    "AL_EXT_source_distance_model AL_LOKI_quadriphonic AL_SOFTX_async_buffer_data "
+    "AL_SOFT_block_alignment AL_SOFTX_buffer_preresample AL_SOFT_buffer_samples "
+    "AL_SOFT_buffer_sub_data AL_SOFT_deferred_updates AL_SOFT_direct_channels "
+    "AL_SOFTX_direct_handles AL_SOFTX_effect_chain AL_SOFT_loop_points "
+    "AL_SOFTX_map_buffer AL_SOFT_MSADPCM AL_SOFTX_source_batch "
     "AL_SOFT_source_latency AL_SOFT_source_length";
 
 static ATOMIC(ALCenum) LastNullDeviceError = ATOMIC_INIT_STATIC(ALC_NO_ERROR);
@@ -1035,6 +1067,8 @@ static void alc_initconfig(void)
 
     EmulateEAXReverb = GetConfigValueBool("reverb", "emulate-eax", AL_FALSE);
 
+    NativeADPCM = GetConfigValueBool(NULL, "native-adpcm", AL_FALSE);
+
     if(((devs=getenv("ALSOFT_DRIVERS")) && devs[0]) ||
        ConfigValueStr(NULL, "drivers", &devs))
     {
@@ -1607,9 +1641,19 @@ void ALCcontext_DeferUpdates(ALCcontext *context)
 
         context->DeferUpdates = AL_TRUE;
 
-        /* Make sure all pending updates are performed */
+        /* Make sure all pending updates are performed. Effect slots go
+         * first, since sources look at their effect type. */
         UpdateSources = ATOMIC_EXCHANGE(ALenum, &context->UpdateSources, AL_FALSE);
 
+        slot = VECTOR_ITER_BEGIN(context->ActiveAuxSlots);
+        slot_end = VECTOR_ITER_END(context->ActiveAuxSlots);
+        while(slot != slot_end)
+        {
+            if(ApplyEffectSlotUpdate(*slot, device))
+                UpdateSources = AL_TRUE;
+            slot++;
+        }
+
         voice = context->Voices;
         voice_end = voice + context->VoiceCount;
         while(voice != voice_end)
@@ -1628,15 +1672,6 @@ void ALCcontext_DeferUpdates(ALCcontext *context)
         next:
             voice++;
         }
-
-        slot = VECTOR_ITER_BEGIN(context->ActiveAuxSlots);
-        slot_end = VECTOR_ITER_END(context->ActiveAuxSlots);
-        while(slot != slot_end)
-        {
-            if(ATOMIC_EXCHANGE(ALenum, &(*slot)->NeedsUpdate, AL_FALSE))
-                V((*slot)->EffectState,update)(context->Device, *slot);
-            slot++;
-        }
     }
     V0(device->Backend,unlock)();
 
@@ -1726,6 +1761,7 @@ static inline void UpdateClockBase(ALCdevice *device)
  */
 static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 {
+    const struct Hrtf *oldHrtf;
     ALCcontext *context;
     enum DevFmtChannels oldChans;
     enum DevFmtType oldType;
@@ -1915,8 +1951,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         if(!FindHrtfFormat(&device->FmtChans, &device->Frequency))
             device->Flags &= ~DEVICE_HRTF_REQUEST;
         else
-            device->Flags |= DEVICE_CHANNELS_REQUEST | DEVICE_FREQUENCY_REQUEST |
-                             DEVICE_HRTF_REQUEST;
+            device->Flags |= DEVICE_CHANNELS_REQUEST | DEVICE_HRTF_REQUEST;
     }
     if(device->Type == Loopback && (device->Flags&DEVICE_HRTF_REQUEST))
     {
@@ -1975,6 +2010,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             WARN("NEON performs best with multiple of 4 update sizes (%u)\n", device->UpdateSize);
     }
 
+    oldHrtf = device->Hrtf;
     device->Hrtf = NULL;
     if(device->FmtChans != DevFmtStereo)
     {
@@ -2002,10 +2038,26 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             usehrtf = ((device->Flags&DEVICE_HRTF_REQUEST) || headphones);
 
         if(usehrtf)
-            device->Hrtf = GetHrtf(device->FmtChans, device->Frequency);
+        {
+            device->Hrtf_AdaptiveLength = GetConfigValueBool(NULL, "hrtf-adaptive-length", AL_FALSE);
+            device->Hrtf = GetHrtf(device->FmtChans, device->Frequency,
+                                   device->Hrtf_AdaptiveLength);
+        }
         if(device->Hrtf)
         {
-            TRACE("HRTF enabled\n");
+            device->Hrtf_Mode = HrtfFull;
+            if(ConfigValueStr(NULL, "hrtf-mode", &mode))
+            {
+                if(strcasecmp(mode, "ambi1") == 0)
+                    device->Hrtf_Mode = HrtfAmbi1;
+                else if(strcasecmp(mode, "ambi2") == 0)
+                    device->Hrtf_Mode = HrtfAmbi2;
+                else if(strcasecmp(mode, "full") != 0)
+                    ERR("Unexpected hrtf-mode: %s\n", mode);
+            }
+            device->Hrtf_NearField = GetConfigValueBool(NULL, "hrtf-near-field", AL_FALSE);
+            TRACE("HRTF enabled (%s)\n", (device->Hrtf_Mode == HrtfAmbi2) ? "2nd-order ambisonic" :
+                  (device->Hrtf_Mode == HrtfAmbi1) ? "1st-order ambisonic" : "full");
             free(device->Bs2b);
             device->Bs2b = NULL;
         }
@@ -2055,6 +2107,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
     SetMixerFPUMode(&oldMode);
     V0(device->Backend,lock)();
+    ATOMIC_ADD(ALuint, &device->ResetCount, 1);
     context = ATOMIC_LOAD(&device->ContextList);
     while(context)
     {
@@ -2066,6 +2119,11 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         {
             ALeffectslot *slot = context->EffectSlotMap.array[pos].value;
 
+            /* Take any pending effect change now, so its state gets set up
+             * for the new format too. */
+            ApplyEffectSlotUpdate(slot, device);
+            RetireEffectSlotFade(slot);
+            DeleteRetiredEffectStates(slot);
             if(V(slot->EffectState,deviceUpdate)(device) == AL_FALSE)
             {
                 UnlockUIntMapRead(&context->EffectSlotMap);
@@ -2108,6 +2166,13 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                 voice->Send[s].Counter = 0;
                 s++;
             }
+            /* The HRIR lengths and coefficients from a different data set
+             * can't be faded from. */
+            if(device->Hrtf != oldHrtf)
+            {
+                voice->Direct.Moving = AL_FALSE;
+                voice->Direct.Counter = 0;
+            }
 
             if(source)
             {
@@ -2122,6 +2187,9 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     {
         ALeffectslot *slot = device->DefaultSlot;
 
+        ApplyEffectSlotUpdate(slot, device);
+        RetireEffectSlotFade(slot);
+        DeleteRetiredEffectStates(slot);
         if(V(slot->EffectState,deviceUpdate)(device) == AL_FALSE)
         {
             V0(device->Backend,unlock)();
@@ -2162,21 +2230,24 @@ static ALCvoid FreeDevice(ALCdevice *device)
 
     if(device->DefaultSlot)
     {
-        ALeffectState *state = device->DefaultSlot->EffectState;
+        DeinitEffectSlot(device->DefaultSlot);
         device->DefaultSlot = NULL;
-        DELETE_OBJ(state);
     }
 
     if(device->DefaultSfont)
         ALsoundfont_deleteSoundfont(device->DefaultSfont, device);
     device->DefaultSfont = NULL;
 
+    /* Finish any pending buffer loads before the buffers go away. */
+    DestroyLoaderPool(ATOMIC_EXCHANGE(LoaderPool*, &device->BufferLoader, NULL));
+
     if(device->BufferMap.size > 0)
     {
         WARN("(%p) Deleting %d Buffer(s)\n", device, device->BufferMap.size);
         ReleaseALBuffers(device);
     }
     ResetUIntMap(&device->BufferMap);
+    ResetSlabPool(&device->BufferSlabs);
 
     if(device->EffectMap.size > 0)
     {
@@ -2184,6 +2255,7 @@ static ALCvoid FreeDevice(ALCdevice *device)
         ReleaseALEffects(device);
     }
     ResetUIntMap(&device->EffectMap);
+    ResetSlabPool(&device->EffectSlabs);
 
     if(device->FilterMap.size > 0)
     {
@@ -2191,6 +2263,7 @@ static ALCvoid FreeDevice(ALCdevice *device)
         ReleaseALFilters(device);
     }
     ResetUIntMap(&device->FilterMap);
+    ResetSlabPool(&device->FilterSlabs);
 
     if(device->SfontMap.size > 0)
     {
@@ -2216,6 +2289,9 @@ static ALCvoid FreeDevice(ALCdevice *device)
     free(device->Bs2b);
     device->Bs2b = NULL;
 
+    DestroyHrtfConvolver(device->Hrtf_Conv);
+    device->Hrtf_Conv = NULL;
+
     AL_STRING_DEINIT(device->DeviceName);
 
     al_free(device->DryBuffer);
@@ -2223,6 +2299,9 @@ static ALCvoid FreeDevice(ALCdevice *device)
 
     DestroyRingBuffer(device->loopback_ring);
 
+    DestroyMixerPool(device->EffectPool);
+    device->EffectPool = NULL;
+
     al_free(device);
 }
 
@@ -2294,6 +2373,8 @@ static ALvoid InitContext(ALCcontext *Context)
     ATOMIC_INIT(&Context->LastError, AL_NO_ERROR);
     ATOMIC_INIT(&Context->UpdateSources, AL_FALSE);
     InitUIntMap(&Context->SourceMap, Context->Device->MaxNoOfSources);
+    InitSlabPool(&Context->SourceSlabs, sizeof(ALsource));
+    InitSlabPool(&Context->BufferListSlabs, sizeof(ALbufferlistitem));
     InitUIntMap(&Context->EffectSlotMap, Context->Device->AuxiliaryEffectSlotMax);
 
     //Set globals
@@ -2323,6 +2404,8 @@ static void FreeContext(ALCcontext *context)
         ReleaseALSources(context);
     }
     ResetUIntMap(&context->SourceMap);
+    ResetSlabPool(&context->SourceSlabs);
+    ResetSlabPool(&context->BufferListSlabs);
 
     if(context->EffectSlotMap.size > 0)
     {
@@ -3250,6 +3333,7 @@ ALC_API ALCdevice* ALC_APIENTRY alcGetContextsDevice(ALCcontext *Context)
 ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
 {
     const ALCchar *fmt;
+    ALCuint effectThreads;
     ALCdevice *device;
     ALCenum err;
 
@@ -3276,9 +3360,11 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     device->Connected = ALC_TRUE;
     device->Type = Playback;
     ATOMIC_INIT(&device->LastError, ALC_NO_ERROR);
+    ATOMIC_INIT(&device->ResetCount, 0);
 
     device->Flags = 0;
     device->Bs2b = NULL;
+    device->Hrtf_Conv = NULL;
     AL_STRING_INIT(device->DeviceName);
     device->DryBuffer = NULL;
 
@@ -3294,6 +3380,9 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     InitUIntMap(&device->BufferMap, ~0);
     InitUIntMap(&device->EffectMap, ~0);
     InitUIntMap(&device->FilterMap, ~0);
+    InitSlabPool(&device->BufferSlabs, sizeof(ALbuffer));
+    InitSlabPool(&device->EffectSlabs, sizeof(ALeffect));
+    InitSlabPool(&device->FilterSlabs, sizeof(ALfilter));
     InitUIntMap(&device->SfontMap, ~0);
     InitUIntMap(&device->PresetMap, ~0);
     InitUIntMap(&device->FontsoundMap, ~0);
@@ -3307,6 +3396,8 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     device->UpdateSize = 1024;
 
     device->loopback_ring = CreateRingBuffer(1, BUFFERSIZE * 4);
+    device->EffectPool = NULL;
+    ATOMIC_INIT(&device->BufferLoader, NULL);
 
     if(!PlaybackBackend.getFactory)
         device->Backend = create_backend_wrapper(device, &PlaybackBackend.Funcs,
@@ -3428,6 +3519,10 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
         return NULL;
     }
 
+    if(ConfigValueUInt(NULL, "effect-threads", &effectThreads) && effectThreads > 0)
+        device->EffectPool = CreateMixerPool(minu(effectThreads, 16));
+    device->EffectBFormat = GetConfigValueBool(NULL, "effect-bformat", 0);
+
     if(DefaultEffect.type != AL_EFFECT_NULL)
     {
         device->DefaultSlot = (ALeffectslot*)device->_slot_mem;
@@ -3438,9 +3533,8 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
         }
         else if(InitializeEffect(device, device->DefaultSlot, &DefaultEffect) != AL_NO_ERROR)
         {
-            ALeffectState *state = device->DefaultSlot->EffectState;
+            DeinitEffectSlot(device->DefaultSlot);
             device->DefaultSlot = NULL;
-            DELETE_OBJ(state);
             ERR("Failed to initialize the default effect\n");
         }
     }
@@ -3550,6 +3644,9 @@ ALC_API ALCdevice* ALC_APIENTRY alcCaptureOpenDevice(const ALCchar *deviceName,
     InitUIntMap(&device->BufferMap, ~0);
     InitUIntMap(&device->EffectMap, ~0);
     InitUIntMap(&device->FilterMap, ~0);
+    InitSlabPool(&device->BufferSlabs, sizeof(ALbuffer));
+    InitSlabPool(&device->EffectSlabs, sizeof(ALeffect));
+    InitSlabPool(&device->FilterSlabs, sizeof(ALfilter));
     InitUIntMap(&device->SfontMap, ~0);
     InitUIntMap(&device->PresetMap, ~0);
     InitUIntMap(&device->FontsoundMap, ~0);
@@ -3719,6 +3816,7 @@ ALC_API void ALC_APIENTRY alcCaptureSamplesLoopback(ALCdevice *device, ALCvoid *
 ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceName)
 {
     ALCbackendFactory *factory;
+    ALCuint effectThreads;
     ALCdevice *device;
 
     DO_INITCONFIG();
@@ -3742,9 +3840,11 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
     device->Connected = ALC_TRUE;
     device->Type = Loopback;
     ATOMIC_INIT(&device->LastError, ALC_NO_ERROR);
+    ATOMIC_INIT(&device->ResetCount, 0);
 
     device->Flags = 0;
     device->Bs2b = NULL;
+    device->Hrtf_Conv = NULL;
     AL_STRING_INIT(device->DeviceName);
     device->DryBuffer = NULL;
 
@@ -3760,10 +3860,16 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
     InitUIntMap(&device->BufferMap, ~0);
     InitUIntMap(&device->EffectMap, ~0);
     InitUIntMap(&device->FilterMap, ~0);
+    InitSlabPool(&device->BufferSlabs, sizeof(ALbuffer));
+    InitSlabPool(&device->EffectSlabs, sizeof(ALeffect));
+    InitSlabPool(&device->FilterSlabs, sizeof(ALfilter));
     InitUIntMap(&device->SfontMap, ~0);
     InitUIntMap(&device->PresetMap, ~0);
     InitUIntMap(&device->FontsoundMap, ~0);
 
+    device->EffectPool = NULL;
+    ATOMIC_INIT(&device->BufferLoader, NULL);
+
     factory = ALCloopbackFactory_getFactory();
     device->Backend = V(factory,createBackend)(device, ALCbackend_Loopback);
     if(!device->Backend)
@@ -3803,6 +3909,10 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
         return NULL;
     }
 
+    if(ConfigValueUInt(NULL, "effect-threads", &effectThreads) && effectThreads > 0)
+        device->EffectPool = CreateMixerPool(minu(effectThreads, 16));
+    device->EffectBFormat = GetConfigValueBool(NULL, "effect-bformat", 0);
+
     // Open the "backend"
     V(device->Backend,open)("Loopback");
 
@@ -237,30 +237,93 @@ static void UpdateDryStepping(DirectParams *params, ALuint num_chans, ALuint ste
     params->Counter = steps;
 }
 
-static void UpdateWetStepping(SendParams *params, ALuint steps)
+static inline ALboolean FilterParamsEqual(const ALfilterState *a, const ALfilterState *b)
+{
+    return a->b[0] == b->b[0] && a->b[1] == b->b[1] && a->b[2] == b->b[2] &&
+           a->a[1] == b->a[1] && a->a[2] == b->a[2];
+}
+
+/* Checks if a send's filters for the given channel do the same thing as the
+ * direct path's, which is common when an app uses one filter everywhere. If
+ * they do, the send's filter history is synced to the direct path's so it can
+ * take the direct path's output from then on.
+ */
+static void CheckSharedFilters(const DirectParams *direct, SendParams *send, ALuint c)
+{
+    enum ActiveFilters type = send->Filters[c].ActiveType;
+
+    send->Filters[c].SameAsDirect = AL_FALSE;
+    if(type == AF_None || type != direct->Filters[c].ActiveType)
+        return;
+    if((type&AF_LowPass) && !FilterParamsEqual(&send->Filters[c].LowPass,
+                                               &direct->Filters[c].LowPass))
+        return;
+    if((type&AF_HighPass) && !FilterParamsEqual(&send->Filters[c].HighPass,
+                                                &direct->Filters[c].HighPass))
+        return;
+
+    send->Filters[c].SameAsDirect = AL_TRUE;
+    memcpy(send->Filters[c].LowPass.x, direct->Filters[c].LowPass.x, sizeof(ALfloat)*2);
+    memcpy(send->Filters[c].LowPass.y, direct->Filters[c].LowPass.y, sizeof(ALfloat)*2);
+    memcpy(send->Filters[c].HighPass.x, direct->Filters[c].HighPass.x, sizeof(ALfloat)*2);
+    memcpy(send->Filters[c].HighPass.y, direct->Filters[c].HighPass.y, sizeof(ALfloat)*2);
+}
+
+static void UpdateWetStepping(SendParams *params, ALuint num_chans, ALuint steps)
 {
     ALfloat delta;
+    ALuint i, j;
 
     if(steps < 2)
     {
-        params->Gain.Current = params->Gain.Target;
-        params->Gain.Step = 0.0f;
-
+        for(i = 0;i < num_chans;i++)
+        {
+            MixGains *gains = params->Gains[i];
+            for(j = 0;j < params->OutChannels;j++)
+            {
+                gains[j].Current = gains[j].Target;
+                gains[j].Step = 0.0f;
+            }
+        }
         params->Counter = 0;
         return;
     }
 
     delta = 1.0f / (ALfloat)steps;
+    for(i = 0;i < num_chans;i++)
     {
-        ALfloat diff = params->Gain.Target - params->Gain.Current;
-        if(fabs(diff) >= GAIN_SILENCE_THRESHOLD)
-            params->Gain.Step = diff * delta;
-        else
-            params->Gain.Step = 0.0f;
+        MixGains *gains = params->Gains[i];
+        for(j = 0;j < params->OutChannels;j++)
+        {
+            ALfloat diff = gains[j].Target - gains[j].Current;
+            if(fabs(diff) >= GAIN_SILENCE_THRESHOLD)
+                gains[j].Step = diff * delta;
+            else
+                gains[j].Step = 0.0f;
+        }
     }
     params->Counter = steps;
 }
 
+/* Sets the target gains for an input channel going to an effect slot, coming
+ * from the given direction (a vector no longer than 1 unit, relative to the
+ * listener). Mono slots just get the gain, while B-Format slots also get the
+ * directional components.
+ */
+static void SetSendGains(SendParams *params, ALuint chan, const ALfloat dir[3], ALfloat gain)
+{
+    MixGains *gains = params->Gains[chan];
+
+    gains[0].Target = gain;
+    if(params->OutChannels > 1)
+    {
+        /* B-Format X is forward, Y is left, and Z is up. */
+        gains[1].Target = -dir[2] * gain;
+        gains[2].Target = -dir[0] * gain;
+        gains[3].Target =  dir[1] * gain;
+    }
+}
+
 
 static ALvoid CalcListenerParams(ALlistener *Listener)
 {
@@ -358,6 +421,7 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
     ALuint num_channels = 0;
     ALboolean DirectChannels;
     ALboolean isbformat = AL_FALSE;
+    aluMatrix matrix;
     ALfloat Pitch;
     ALuint i, j, c;
 
@@ -384,9 +448,15 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
         if(!Slot && i == 0)
             Slot = Device->DefaultSlot;
         if(!Slot || Slot->EffectType == AL_EFFECT_NULL)
+        {
             voice->Send[i].OutBuffer = NULL;
+            voice->Send[i].OutChannels = 1;
+        }
         else
+        {
             voice->Send[i].OutBuffer = Slot->WetBuffer;
+            voice->Send[i].OutChannels = Slot->NumChannels;
+        }
     }
 
     /* Calculate the stepping value */
@@ -397,7 +467,11 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
         ALbuffer *ALBuffer;
         if((ALBuffer=BufferListItem->buffer) != NULL)
         {
-            Pitch = Pitch * ALBuffer->Frequency / Frequency;
+            /* Static sources may be playing the buffer's copy that's already
+             * at the output frequency. */
+            ALsizei BufferFreq = ALSource->Preresampled ? ALSource->Preresampled->Frequency :
+                                 ALBuffer->Frequency;
+            Pitch = Pitch * BufferFreq / Frequency;
             if(Pitch > (ALfloat)MAX_PITCH)
                 voice->Step = MAX_PITCH<<FRACTIONBITS;
             else
@@ -485,7 +559,6 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
     if(isbformat)
     {
         ALfloat N[3], V[3], U[3];
-        aluMatrix matrix;
 
         /* AT then UP */
         N[0] = ALSource->Orientation[0][0];
@@ -568,7 +641,7 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
 
         voice->IsHrtf = AL_FALSE;
     }
-    else if(Device->Hrtf)
+    else if(Device->Hrtf && Device->Hrtf_Mode == HrtfFull)
     {
         voice->Direct.OutBuffer += voice->Direct.OutChannels;
         voice->Direct.OutChannels = 2;
@@ -589,14 +662,16 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
             {
                 /* Get the static HRIR coefficients and delays for this
                  * channel. */
-                GetLerpedHrtfCoeffs(Device->Hrtf,
-                                    chans[c].elevation, chans[c].angle, 1.0f, DryGain,
+                GetLerpedHrtfCoeffs(Device->Hrtf, 0,
+                                    chans[c].elevation, chans[c].angle, 0.0f, 1.0f, DryGain,
                                     voice->Direct.Hrtf[c].Params.Coeffs,
                                     voice->Direct.Hrtf[c].Params.Delay);
             }
         }
         voice->Direct.Counter = 0;
         voice->Direct.Moving  = AL_TRUE;
+        voice->Direct.IrSize = GetHrtfIrSize(Device->Hrtf);
+        voice->Direct.TargetIrSize = voice->Direct.IrSize;
 
         voice->IsHrtf = AL_TRUE;
     }
@@ -618,7 +693,8 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
                 continue;
             }
 
-            ComputeAngleGains(Device, chans[c].angle, chans[c].elevation, DryGain, Target);
+            ComputeAngleGains(Device, chans[c].angle, chans[c].elevation,
+                              Device->Hrtf ? DryGain*2.0f : DryGain, Target);
             for(i = 0;i < MAX_OUTPUT_CHANNELS;i++)
                 gains[i].Target = Target[i];
         }
@@ -629,9 +705,34 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
     }
     for(i = 0;i < NumSends;i++)
     {
-        voice->Send[i].Gain.Target = WetGain[i];
-        UpdateWetStepping(&voice->Send[i], (voice->Send[i].Moving ? 64 : 0));
-        voice->Send[i].Moving = AL_TRUE;
+        SendParams *send = &voice->Send[i];
+
+        if(isbformat)
+        {
+            /* The source's W channel already has the 3dB boost to match
+             * mono. X, Y, and Z need to be rotated to listener space, but
+             * otherwise pass through. */
+            for(c = 0;c < num_channels;c++)
+            {
+                MixGains *gains = send->Gains[c];
+                gains[0].Target = matrix.m[c][0] * WetGain[i];
+                for(j = 1;j < send->OutChannels;j++)
+                    gains[j].Target = matrix.m[c][j] * WetGain[i] / 1.4142f;
+            }
+        }
+        else for(c = 0;c < num_channels;c++)
+        {
+            ALfloat dir[3] = { 0.0f, 0.0f, 0.0f };
+            if(chans[c].channel != LFE)
+            {
+                dir[0] =  sinf(chans[c].angle) * cosf(chans[c].elevation);
+                dir[1] =  sinf(chans[c].elevation);
+                dir[2] = -cosf(chans[c].angle) * cosf(chans[c].elevation);
+            }
+            SetSendGains(send, c, dir, WetGain[i]);
+        }
+        UpdateWetStepping(send, num_channels, (send->Moving ? 64 : 0));
+        send->Moving = AL_TRUE;
     }
 
     {
@@ -673,6 +774,7 @@ ALvoid CalcNonAttnSourceParams(ALvoice *voice, const ALsource *ALSource, const A
                 &voice->Send[i].Filters[c].HighPass, ALfilterType_LowShelf, gainlf,
                 lfscale, 0.0f
             );
+            CheckSharedFilters(&voice->Direct, &voice->Send[i], c);
         }
     }
 }
@@ -786,9 +888,15 @@ ALvoid CalcSourceParams(ALvoice *voice, const ALsource *ALSource, const ALCconte
         }
 
         if(!Slot || Slot->EffectType == AL_EFFECT_NULL)
+        {
             voice->Send[i].OutBuffer = NULL;
+            voice->Send[i].OutChannels = 1;
+        }
         else
+        {
             voice->Send[i].OutBuffer = Slot->WetBuffer;
+            voice->Send[i].OutChannels = Slot->NumChannels;
+        }
     }
 
     /* Transform source to listener space (convert to head relative) */
@@ -988,8 +1096,11 @@ ALvoid CalcSourceParams(ALvoice *voice, const ALsource *ALSource, const ALCconte
         if((ALBuffer=BufferListItem->buffer) != NULL)
         {
             /* Calculate fixed-point stepping value, based on the pitch, buffer
-             * frequency, and output frequency. */
-            Pitch = Pitch * ALBuffer->Frequency / Frequency;
+             * frequency (or that of the buffer's pre-resampled copy), and
+             * output frequency. */
+            ALsizei BufferFreq = ALSource->Preresampled ? ALSource->Preresampled->Frequency :
+                                 ALBuffer->Frequency;
+            Pitch = Pitch * BufferFreq / Frequency;
             if(Pitch > (ALfloat)MAX_PITCH)
                 voice->Step = MAX_PITCH<<FRACTIONBITS;
             else
@@ -1004,13 +1115,16 @@ ALvoid CalcSourceParams(ALvoice *voice, const ALsource *ALSource, const ALCconte
         BufferListItem = BufferListItem->next;
     }
 
-    if(Device->Hrtf)
+    if(Device->Hrtf && Device->Hrtf_Mode == HrtfFull)
     {
         /* Use a binaural HRTF algorithm for stereo headphone playback */
         aluVector dir = {{ 0.0f, 0.0f, -1.0f, 0.0f }};
         ALfloat ev = 0.0f, az = 0.0f;
         ALfloat radius = ALSource->Radius;
         ALfloat dirfact = 1.0f;
+        ALfloat nfdist = 0.0f;
+        ALuint level = 0;
+        ALuint irsize;
 
         voice->Direct.OutBuffer += voice->Direct.OutChannels;
         voice->Direct.OutChannels = 2;
@@ -1031,37 +1145,85 @@ ALvoid CalcSourceParams(ALvoice *voice, const ALsource *ALSource, const ALCconte
         }
         if(radius > Distance)
             dirfact *= Distance / radius;
+        if(Device->Hrtf_NearField)
+            nfdist = Distance * MetersPerUnit;
+
+        /* Quieter sources can use shorter HRIRs, since the truncated tail
+         * would be well under the louder sources' output (-12dB and -24dB
+         * for the first two cut-offs).
+         */
+        if(Device->Hrtf_AdaptiveLength)
+        {
+            if(DryGain < 0.0625f)
+                level = 2;
+            else if(DryGain < 0.25f)
+                level = 1;
+        }
+        irsize = GetHrtfLevelIrSize(Device->Hrtf, level);
 
         /* Check to see if the HRIR is already moving. */
         if(voice->Direct.Moving)
         {
             ALfloat delta;
+
+            /* Once the last fade is done, the coefficients past the target's
+             * length are all 0 and don't need to be mixed. */
+            if(voice->Direct.Counter == 0)
+                voice->Direct.IrSize = voice->Direct.TargetIrSize;
+
             delta = CalcFadeTime(voice->Direct.LastGain, DryGain,
                                  &voice->Direct.LastDir, &dir);
+            /* A change in distance alone also changes the near-field
+             * compensation, when either distance is within its range. Fade
+             * for the change in the compensation's gain. */
+            if(nfdist != voice->Direct.LastDistance)
+            {
+                ALfloat oldnf = GetHrtfNearFieldGain(Device->Hrtf, voice->Direct.LastDistance);
+                ALfloat newnf = GetHrtfNearFieldGain(Device->Hrtf, nfdist);
+                if(oldnf != newnf)
+                    delta = maxf(delta, CalcFadeTime(oldnf, newnf, &dir, &dir));
+            }
             /* If the delta is large enough, get the moving HRIR target
              * coefficients, target delays, steppping values, and counter. */
             if(delta > 0.000015f)
             {
-                ALuint counter = GetMovingHrtfCoeffs(Device->Hrtf,
-                    ev, az, dirfact, DryGain, delta, voice->Direct.Counter,
+                ALuint counter;
+
+                /* Clear the history of the taps being added, so they start
+                 * accumulating from silence. */
+                while(voice->Direct.IrSize < irsize)
+                {
+                    ALuint idx = (voice->Offset+voice->Direct.IrSize) & HRIR_MASK;
+                    voice->Direct.Hrtf[0].State.Values[idx][0] = 0.0f;
+                    voice->Direct.Hrtf[0].State.Values[idx][1] = 0.0f;
+                    voice->Direct.IrSize++;
+                }
+
+                counter = GetMovingHrtfCoeffs(Device->Hrtf, level,
+                    ev, az, nfdist, dirfact, DryGain, delta, voice->Direct.Counter,
                     voice->Direct.Hrtf[0].Params.Coeffs, voice->Direct.Hrtf[0].Params.Delay,
                     voice->Direct.Hrtf[0].Params.CoeffStep, voice->Direct.Hrtf[0].Params.DelayStep
                 );
                 voice->Direct.Counter = counter;
                 voice->Direct.LastGain = DryGain;
                 voice->Direct.LastDir = dir;
+                voice->Direct.LastDistance = nfdist;
+                voice->Direct.TargetIrSize = irsize;
             }
         }
         else
         {
             /* Get the initial (static) HRIR coefficients and delays. */
-            GetLerpedHrtfCoeffs(Device->Hrtf, ev, az, dirfact, DryGain,
+            GetLerpedHrtfCoeffs(Device->Hrtf, level, ev, az, nfdist, dirfact, DryGain,
                                 voice->Direct.Hrtf[0].Params.Coeffs,
                                 voice->Direct.Hrtf[0].Params.Delay);
             voice->Direct.Counter = 0;
             voice->Direct.Moving  = AL_TRUE;
+            voice->Direct.IrSize = irsize;
+            voice->Direct.TargetIrSize = irsize;
             voice->Direct.LastGain = DryGain;
             voice->Direct.LastDir = dir;
+            voice->Direct.LastDistance = nfdist;
         }
 
         voice->IsHrtf = AL_TRUE;
@@ -1081,7 +1243,9 @@ ALvoid CalcSourceParams(ALvoice *voice, const ALsource *ALSource, const ALCconte
             dir[1] = Position.v[1] * invlen;
             dir[2] = Position.v[2] * invlen * ZScale;
         }
-        ComputeDirectionalGains(Device, dir, DryGain, Target);
+        /* The HRTF B-Format decode halves the level (from the W channel's
+         * scaling), so make up for it to match full HRTF rendering. */
+        ComputeDirectionalGains(Device, dir, Device->Hrtf ? DryGain*2.0f : DryGain, Target);
 
         for(j = 0;j < MAX_OUTPUT_CHANNELS;j++)
             gains[j].Target = Target[j];
@@ -1090,11 +1254,25 @@ ALvoid CalcSourceParams(ALvoice *voice, const ALsource *ALSource, const ALCconte
 
         voice->IsHrtf = AL_FALSE;
     }
-    for(i = 0;i < NumSends;i++)
     {
-        voice->Send[i].Gain.Target = WetGain[i];
-        UpdateWetStepping(&voice->Send[i], (voice->Send[i].Moving ? 64 : 0));
-        voice->Send[i].Moving = AL_TRUE;
+        ALfloat dir[3] = { 0.0f, 0.0f, 0.0f };
+        ALfloat radius = ALSource->Radius;
+
+        /* Sources within their radius get less directional as they approach
+         * the listener, the same as the dry path. */
+        if(Distance > FLT_EPSILON || radius > FLT_EPSILON)
+        {
+            ALfloat invlen = 1.0f/maxf(Distance, radius);
+            dir[0] = Position.v[0] * invlen;
+            dir[1] = Position.v[1] * invlen;
+            dir[2] = Position.v[2] * invlen * ZScale;
+        }
+        for(i = 0;i < NumSends;i++)
+        {
+            SetSendGains(&voice->Send[i], 0, dir, WetGain[i]);
+            UpdateWetStepping(&voice->Send[i], 1, (voice->Send[i].Moving ? 64 : 0));
+            voice->Send[i].Moving = AL_TRUE;
+        }
     }
 
     {
@@ -1131,6 +1309,7 @@ ALvoid CalcSourceParams(ALvoice *voice, const ALsource *ALSource, const ALCconte
             &voice->Send[i].Filters[0].HighPass, ALfilterType_LowShelf, gainlf,
             lfscale, 0.0f
         );
+        CheckSharedFilters(&voice->Direct, &voice->Send[i], 0);
     }
 }
 
@@ -1184,6 +1363,202 @@ DECL_TEMPLATE(ALbyte, aluF2B)
 #undef DECL_TEMPLATE
 
 
+/* Checks if an effect slot has anything to process. Slots that have had no
+ * input for longer than the effect's tail are left sleeping, until a send
+ * becomes active again.
+ */
+static ALboolean EffectSlotIsActive(ALeffectslot *slot, ALuint frequency, ALuint SamplesToDo)
+{
+    ALfloat (*restrict WetBuffer)[BUFFERSIZE] = slot->WetBuffer;
+    ALfloat peak = 0.0f;
+    ALuint i, c;
+
+    for(c = 0;c < slot->NumChannels;c++)
+    {
+        for(i = 0;i < SamplesToDo;i++)
+            peak = maxf(peak, fabsf(WetBuffer[c][i]));
+    }
+
+    if(peak > GAIN_SILENCE_THRESHOLD)
+        slot->SilentSamples = 0;
+    else
+    {
+        /* The tail length is recalculated while the effect rings out, so
+         * property changes in the meantime are taken into account. */
+        ALuint tail = GetEffectSlotTailLength(slot, frequency);
+        if(tail != UINT_MAX)
+        {
+            if(slot->SilentSamples >= tail)
+            {
+                if(peak > 0.0f)
+                {
+                    for(c = 0;c < slot->NumChannels;c++)
+                        memset(WetBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+                }
+                return AL_FALSE;
+            }
+            slot->SilentSamples += minu(SamplesToDo, tail-slot->SilentSamples);
+        }
+    }
+    return AL_TRUE;
+}
+
+/* Processes an effect slot's input into the given output, and clears the
+ * input for the next update. If the slot's effect was just switched, the old
+ * state keeps processing while it's faded out and the new one faded in.
+ */
+static void ProcessEffectSlot(ALeffectslot *slot, ALuint SamplesToDo,
+                              ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALuint OutChannels)
+{
+    ALuint c, i;
+
+    if(!slot->FadeState)
+        V(slot->EffectState,process)(SamplesToDo, slot->WetBuffer, OutBuffer, OutChannels);
+    else
+    {
+        ALfloat (*restrict OldOut)[BUFFERSIZE] = slot->FadeBuffer;
+        ALfloat (*restrict NewOut)[BUFFERSIZE] = slot->FadeBuffer + MAX_OUTPUT_CHANNELS;
+        ALuint todo = minu(SamplesToDo, slot->FadeCount);
+        ALfloat step = 1.0f / EFFECT_FADE_SAMPLES;
+
+        for(c = 0;c < OutChannels;c++)
+        {
+            memset(OldOut[c], 0, todo*sizeof(ALfloat));
+            memset(NewOut[c], 0, todo*sizeof(ALfloat));
+        }
+        /* Only the start of the new state's output is faded, the rest can go
+         * straight to the output. */
+        V(slot->FadeState,process)(todo, slot->WetBuffer, OldOut, OutChannels);
+        V(slot->EffectState,process)(todo, slot->WetBuffer, NewOut, OutChannels);
+        if(todo < SamplesToDo)
+        {
+            const ALfloat (*restrict RestIn)[BUFFERSIZE];
+            ALfloat (*restrict RestOut)[BUFFERSIZE];
+
+            /* Each channel is a row of BUFFERSIZE samples, so offsetting the
+             * start of the buffers offsets every channel together. */
+            RestIn = (const ALfloat(*)[BUFFERSIZE])&slot->WetBuffer[0][todo];
+            RestOut = (ALfloat(*)[BUFFERSIZE])&OutBuffer[0][todo];
+            V(slot->EffectState,process)(SamplesToDo-todo, RestIn, RestOut, OutChannels);
+        }
+
+        for(c = 0;c < OutChannels;c++)
+        {
+            ALfloat gain = (ALfloat)(EFFECT_FADE_SAMPLES - slot->FadeCount) * step;
+            for(i = 0;i < todo;i++)
+            {
+                gain += step;
+                OutBuffer[c][i] += OldOut[c][i]*(1.0f-gain) + NewOut[c][i]*gain;
+            }
+        }
+
+        slot->FadeCount -= todo;
+        if(slot->FadeCount == 0)
+            RetireEffectSlotFade(slot);
+    }
+    for(c = 0;c < slot->NumChannels;c++)
+        memset(slot->WetBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+}
+
+
+/* Adds an effect slot's accumulated output to its target's input, or to the
+ * dry buffer if it has no target. Effects render in the device's channel
+ * layout, so output for a target is mixed back down to mono using the same
+ * gains non-directional sound is panned with.
+ */
+static void MixEffectSlotOutput(const ALeffectslot *slot, ALCdevice *device, ALuint SamplesToDo)
+{
+    ALfloat (*restrict MixBuffer)[BUFFERSIZE] = slot->MixBuffer;
+    ALuint NumChannels = device->NumChannels;
+    ALuint c, i;
+
+    if(!slot->Target)
+    {
+        ALfloat (*restrict DryBuffer)[BUFFERSIZE] = device->DryBuffer;
+        for(c = 0;c < NumChannels;c++)
+        {
+            for(i = 0;i < SamplesToDo;i++)
+                DryBuffer[c][i] += MixBuffer[c][i];
+        }
+    }
+    else
+    {
+        ALfloat *restrict WetBuffer = slot->Target->WetBuffer[0];
+        ALfloat gains[MAX_OUTPUT_CHANNELS];
+        ALfloat norm = 0.0f;
+
+        ComputeAmbientGains(device, 1.0f, gains);
+        for(c = 0;c < NumChannels;c++)
+            norm += gains[c]*gains[c];
+        if(!(norm > 0.0f))
+            return;
+        for(c = 0;c < NumChannels;c++)
+        {
+            ALfloat gain = gains[c] / norm;
+            if(!(gain > GAIN_SILENCE_THRESHOLD))
+                continue;
+            for(i = 0;i < SamplesToDo;i++)
+                WetBuffer[i] += MixBuffer[c][i] * gain;
+        }
+    }
+}
+
+typedef struct EffectSlotBatch {
+    ALeffectslot **Slots;
+    ALuint NumChannels;
+    ALuint Frequency;
+    ALuint SamplesToDo;
+} EffectSlotBatch;
+
+static void ProcessEffectSlotJob(void *arg, ALuint idx)
+{
+    const EffectSlotBatch *batch = arg;
+    ALeffectslot *slot = batch->Slots[idx];
+    ALuint c;
+
+    slot->MixActive = EffectSlotIsActive(slot, batch->Frequency, batch->SamplesToDo);
+    if(!slot->MixActive)
+        return;
+
+    for(c = 0;c < batch->NumChannels;c++)
+        memset(slot->MixBuffer[c], 0, batch->SamplesToDo*sizeof(ALfloat));
+    ProcessEffectSlot(slot, batch->SamplesToDo, slot->MixBuffer, batch->NumChannels);
+}
+
+/* Processes a context's active effect slots on the device's effect pool. The
+ * slots are sorted by their distance from the output, and each group at the
+ * same distance is processed as one batch. Each slot renders into its own
+ * accumulator, which are then added to their targets in slot order so the
+ * result doesn't depend on thread scheduling.
+ */
+static void ProcessEffectSlotsParallel(ALCdevice *device, ALeffectslot **slots, ALuint count,
+                                       ALuint SamplesToDo)
+{
+    EffectSlotBatch batch;
+    ALuint start, end, s;
+
+    batch.NumChannels = device->NumChannels;
+    batch.Frequency = device->Frequency;
+    batch.SamplesToDo = SamplesToDo;
+    for(start = 0;start < count;start = end)
+    {
+        for(end = start+1;end < count;end++)
+        {
+            if(slots[end]->ChainDepth != slots[start]->ChainDepth)
+                break;
+        }
+
+        batch.Slots = slots + start;
+        RunMixerPool(device->EffectPool, ProcessEffectSlotJob, &batch, end-start);
+
+        for(s = start;s < end;s++)
+        {
+            if(slots[s]->MixActive)
+                MixEffectSlotOutput(slots[s], device, SamplesToDo);
+        }
+    }
+}
+
 ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
 {
     ALuint SamplesToDo;
@@ -1228,8 +1603,20 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
             ALenum UpdateSources = AL_FALSE;
 
             if(!DeferUpdates)
+            {
                 UpdateSources = ATOMIC_EXCHANGE(ALenum, &ctx->UpdateSources, AL_FALSE);
 
+                /* Pick up effect changes before sources are updated, since
+                 * they depend on the slot's effect type. */
+                slot = VECTOR_ITER_BEGIN(ctx->ActiveAuxSlots);
+                slot_end = VECTOR_ITER_END(ctx->ActiveAuxSlots);
+                for(;slot != slot_end;slot++)
+                {
+                    if(ApplyEffectSlotUpdate(*slot, device))
+                        UpdateSources = AL_TRUE;
+                }
+            }
+
             if(UpdateSources)
                 CalcListenerParams(ctx->Listener);
 
@@ -1260,18 +1647,23 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
             /* effect slot processing */
             slot = VECTOR_ITER_BEGIN(ctx->ActiveAuxSlots);
             slot_end = VECTOR_ITER_END(ctx->ActiveAuxSlots);
-            while(slot != slot_end)
+            if(device->EffectPool && slot_end-slot > 1)
+                ProcessEffectSlotsParallel(device, slot, (ALuint)(slot_end-slot), SamplesToDo);
+            else for(;slot != slot_end;slot++)
             {
-                if(!DeferUpdates && ATOMIC_EXCHANGE(ALenum, &(*slot)->NeedsUpdate, AL_FALSE))
-                    V((*slot)->EffectState,update)(device, *slot);
-
-                V((*slot)->EffectState,process)(SamplesToDo, (*slot)->WetBuffer[0],
-                                                device->DryBuffer, device->NumChannels);
-
-                for(i = 0;i < SamplesToDo;i++)
-                    (*slot)->WetBuffer[0][i] = 0.0f;
-
-                slot++;
+                if(!EffectSlotIsActive(*slot, device->Frequency, SamplesToDo))
+                    continue;
+                if(!(*slot)->Target)
+                    ProcessEffectSlot(*slot, SamplesToDo, device->DryBuffer, device->NumChannels);
+                else
+                {
+                    /* Slots are ordered so this slot's target is processed
+                     * after it. */
+                    for(c = 0;c < device->NumChannels;c++)
+                        memset((*slot)->MixBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+                    ProcessEffectSlot(*slot, SamplesToDo, (*slot)->MixBuffer, device->NumChannels);
+                    MixEffectSlotOutput(*slot, device, SamplesToDo);
+                }
             }
 
             ctx = ctx->next;
@@ -1280,14 +1672,10 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
         slot = &device->DefaultSlot;
         if(*slot != NULL)
         {
-            if(ATOMIC_EXCHANGE(ALenum, &(*slot)->NeedsUpdate, AL_FALSE))
-                V((*slot)->EffectState,update)(device, *slot);
+            ApplyEffectSlotUpdate(*slot, device);
 
-            V((*slot)->EffectState,process)(SamplesToDo, (*slot)->WetBuffer[0],
-                                            device->DryBuffer, device->NumChannels);
-
-            for(i = 0;i < SamplesToDo;i++)
-                (*slot)->WetBuffer[0][i] = 0.0f;
+            if(EffectSlotIsActive(*slot, device->Frequency, SamplesToDo))
+                ProcessEffectSlot(*slot, SamplesToDo, device->DryBuffer, device->NumChannels);
         }
 
         /* Increment the clock time. Every second's worth of samples is
@@ -1303,11 +1691,17 @@ ALvoid aluMixData(ALCdevice *device, ALvoid *buffer, ALsizei size)
         {
             HrtfMixerFunc HrtfMix = SelectHrtfMixer();
             ALuint irsize = GetHrtfIrSize(device->Hrtf);
+            /* With the convolver handling the tail, only mix the head block
+             * here. */
+            if(device->Hrtf_Conv)
+                irsize = minu(irsize, HRTF_CONV_BLOCK_SIZE);
             for(c = 0;c < device->NumChannels;c++)
                 HrtfMix(OutBuffer, device->DryBuffer[c], 0, device->Hrtf_Offset,
                     0, irsize, &device->Hrtf_Params[c], &device->Hrtf_State[c],
                     SamplesToDo
                 );
+            if(device->Hrtf_Conv)
+                MixHrtfConvolver(device->Hrtf_Conv, OutBuffer, device->DryBuffer, SamplesToDo);
             device->Hrtf_Offset += SamplesToDo;
         }
         else if(device->Bs2b)
@@ -0,0 +1,179 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "alMain.h"
+#include "threads.h"
+
+
+/* A pool of background threads for loading buffer data, so the application's
+ * thread doesn't have to wait on long conversions. Unlike the mixer pool,
+ * jobs are independent and nobody waits for a whole batch; they're run in the
+ * order they're queued, and each job's Pending flag is cleared once it's
+ * finished.
+ */
+struct LoaderPool {
+    althrd_t *threads;
+    ALuint num_threads;
+
+    almtx_t mtx;
+    /* Signaled when a job is queued, or when quitting. */
+    alcnd_t work_cnd;
+    /* Signaled whenever a job is finished. */
+    alcnd_t done_cnd;
+
+    LoaderJob *head;
+    LoaderJob *tail;
+
+    ALboolean quit;
+};
+
+
+static int LoaderPoolProc(void *ptr)
+{
+    LoaderPool *pool = ptr;
+
+    althrd_setname(althrd_current(), LOADER_THREAD_NAME);
+
+    almtx_lock(&pool->mtx);
+    while(1)
+    {
+        LoaderJob *job = pool->head;
+        if(job)
+        {
+            pool->head = job->next;
+            if(!pool->head)
+                pool->tail = NULL;
+
+            almtx_unlock(&pool->mtx);
+            job->Process(job);
+            almtx_lock(&pool->mtx);
+
+            ATOMIC_STORE(&job->Pending, AL_FALSE);
+            alcnd_broadcast(&pool->done_cnd);
+            continue;
+        }
+        /* Queued jobs are finished before quitting, since the objects they
+         * load into are about to be freed. */
+        if(pool->quit)
+            break;
+        alcnd_wait(&pool->work_cnd, &pool->mtx);
+    }
+    almtx_unlock(&pool->mtx);
+
+    return 0;
+}
+
+
+LoaderPool *CreateLoaderPool(ALuint num_threads)
+{
+    LoaderPool *pool;
+    ALuint i;
+
+    if(num_threads == 0)
+        return NULL;
+
+    pool = calloc(1, sizeof(*pool) + num_threads*sizeof(pool->threads[0]));
+    if(!pool) return NULL;
+
+    pool->threads = (althrd_t*)(pool+1);
+    pool->num_threads = 0;
+    almtx_init(&pool->mtx, almtx_plain);
+    alcnd_init(&pool->work_cnd);
+    alcnd_init(&pool->done_cnd);
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->quit = AL_FALSE;
+
+    for(i = 0;i < num_threads;i++)
+    {
+        if(althrd_create(&pool->threads[i], LoaderPoolProc, pool) != althrd_success)
+        {
+            ERR("Failed to start loader pool thread %u\n", i);
+            break;
+        }
+        pool->num_threads++;
+    }
+    if(pool->num_threads == 0)
+    {
+        DestroyLoaderPool(pool);
+        return NULL;
+    }
+
+    TRACE("Created loader pool with %u thread%s\n", pool->num_threads,
+          (pool->num_threads == 1) ? "" : "s");
+    return pool;
+}
+
+/* Finishes any queued jobs, then stops the pool's threads. */
+void DestroyLoaderPool(LoaderPool *pool)
+{
+    ALuint i;
+
+    if(!pool) return;
+
+    almtx_lock(&pool->mtx);
+    pool->quit = AL_TRUE;
+    alcnd_broadcast(&pool->work_cnd);
+    almtx_unlock(&pool->mtx);
+
+    for(i = 0;i < pool->num_threads;i++)
+    {
+        int res;
+        althrd_join(pool->threads[i], &res);
+    }
+
+    alcnd_destroy(&pool->done_cnd);
+    alcnd_destroy(&pool->work_cnd);
+    almtx_destroy(&pool->mtx);
+    free(pool);
+}
+
+/* Queues the job to be processed by one of the pool's threads. The job must
+ * remain valid until its Pending flag is cleared. */
+void QueueLoaderJob(LoaderPool *pool, LoaderJob *job)
+{
+    ATOMIC_STORE(&job->Pending, AL_TRUE);
+    job->next = NULL;
+
+    almtx_lock(&pool->mtx);
+    if(pool->tail)
+        pool->tail->next = job;
+    else
+        pool->head = job;
+    pool->tail = job;
+    alcnd_signal(&pool->work_cnd);
+    almtx_unlock(&pool->mtx);
+}
+
+/* Waits for the job to finish, if it's pending. */
+void WaitLoaderJob(LoaderPool *pool, LoaderJob *job)
+{
+    if(!ATOMIC_LOAD(&job->Pending))
+        return;
+
+    almtx_lock(&pool->mtx);
+    while(ATOMIC_LOAD(&job->Pending))
+        alcnd_wait(&pool->done_cnd, &pool->mtx);
+    almtx_unlock(&pool->mtx);
+}
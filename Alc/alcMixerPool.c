@@ -0,0 +1,201 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "alMain.h"
+#include "threads.h"
+
+
+/* A small pool of worker threads, used to spread independent pieces of the
+ * mix (such as effect slots) across cores. The mixer thread hands out a batch
+ * of jobs and works on them itself as well, returning once every job in the
+ * batch is finished. Jobs are expected to be fairly coarse, so they're handed
+ * out under the pool's mutex.
+ */
+struct MixerPool {
+    althrd_t *threads;
+    ALuint num_threads;
+
+    almtx_t mtx;
+    /* Signaled when a new batch of jobs is available, or when quitting. */
+    alcnd_t work_cnd;
+    /* Signaled when the last outstanding job of a batch is finished. */
+    alcnd_t done_cnd;
+
+    MixerPoolFunc func;
+    void *arg;
+    ALuint count;
+    ALuint next_job;
+    ALuint pending;
+
+    ALboolean quit;
+};
+
+
+static int MixerPoolProc(void *ptr)
+{
+    MixerPool *pool = ptr;
+    FPUCtl oldMode;
+
+    SetRTPriority();
+    althrd_setname(althrd_current(), MIXER_THREAD_NAME);
+    /* The pool threads only ever run mixing jobs, so keep the mixer's FPU
+     * mode set for the life of the thread. */
+    SetMixerFPUMode(&oldMode);
+
+    almtx_lock(&pool->mtx);
+    while(!pool->quit)
+    {
+        if(pool->next_job < pool->count)
+        {
+            MixerPoolFunc func = pool->func;
+            void *arg = pool->arg;
+            ALuint idx = pool->next_job++;
+
+            almtx_unlock(&pool->mtx);
+            func(arg, idx);
+            almtx_lock(&pool->mtx);
+
+            if(--pool->pending == 0)
+                alcnd_signal(&pool->done_cnd);
+            continue;
+        }
+        alcnd_wait(&pool->work_cnd, &pool->mtx);
+    }
+    almtx_unlock(&pool->mtx);
+
+    RestoreFPUMode(&oldMode);
+    return 0;
+}
+
+
+MixerPool *CreateMixerPool(ALuint num_threads)
+{
+    MixerPool *pool;
+    ALuint i;
+
+    if(num_threads == 0)
+        return NULL;
+
+    pool = calloc(1, sizeof(*pool) + num_threads*sizeof(pool->threads[0]));
+    if(!pool) return NULL;
+
+    pool->threads = (althrd_t*)(pool+1);
+    pool->num_threads = 0;
+    almtx_init(&pool->mtx, almtx_plain);
+    alcnd_init(&pool->work_cnd);
+    alcnd_init(&pool->done_cnd);
+    pool->func = NULL;
+    pool->arg = NULL;
+    pool->count = 0;
+    pool->next_job = 0;
+    pool->pending = 0;
+    pool->quit = AL_FALSE;
+
+    for(i = 0;i < num_threads;i++)
+    {
+        if(althrd_create(&pool->threads[i], MixerPoolProc, pool) != althrd_success)
+        {
+            ERR("Failed to start mixer pool thread %u\n", i);
+            break;
+        }
+        pool->num_threads++;
+    }
+    if(pool->num_threads == 0)
+    {
+        DestroyMixerPool(pool);
+        return NULL;
+    }
+
+    TRACE("Created mixer pool with %u thread%s\n", pool->num_threads,
+          (pool->num_threads == 1) ? "" : "s");
+    return pool;
+}
+
+void DestroyMixerPool(MixerPool *pool)
+{
+    ALuint i;
+
+    if(!pool) return;
+
+    almtx_lock(&pool->mtx);
+    pool->quit = AL_TRUE;
+    alcnd_broadcast(&pool->work_cnd);
+    almtx_unlock(&pool->mtx);
+
+    for(i = 0;i < pool->num_threads;i++)
+    {
+        int res;
+        althrd_join(pool->threads[i], &res);
+    }
+
+    alcnd_destroy(&pool->done_cnd);
+    alcnd_destroy(&pool->work_cnd);
+    almtx_destroy(&pool->mtx);
+    free(pool);
+}
+
+ALuint MixerPoolSize(const MixerPool *pool)
+{
+    return pool ? pool->num_threads : 0;
+}
+
+/* Calls func(arg, idx) for each idx in [0, count), using the pool's threads
+ * as well as the calling thread. Returns once all calls have completed. */
+void RunMixerPool(MixerPool *pool, MixerPoolFunc func, void *arg, ALuint count)
+{
+    if(count <= 1)
+    {
+        /* Not worth waking the pool for. */
+        if(count == 1)
+            func(arg, 0);
+        return;
+    }
+
+    almtx_lock(&pool->mtx);
+    pool->func = func;
+    pool->arg = arg;
+    pool->count = count;
+    pool->next_job = 0;
+    pool->pending = count;
+    alcnd_broadcast(&pool->work_cnd);
+
+    while(pool->next_job < pool->count)
+    {
+        ALuint idx = pool->next_job++;
+
+        almtx_unlock(&pool->mtx);
+        func(arg, idx);
+        almtx_lock(&pool->mtx);
+
+        --pool->pending;
+    }
+    while(pool->pending > 0)
+        alcnd_wait(&pool->done_cnd, &pool->mtx);
+
+    pool->func = NULL;
+    pool->arg = NULL;
+    pool->count = 0;
+    pool->next_job = 0;
+    almtx_unlock(&pool->mtx);
+}
@@ -0,0 +1,186 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "alMain.h"
+
+
+/* A pool of same-sized objects, kept in slabs that are only freed along with
+ * the pool. Slab n holds SLAB_BASE_COUNT<<n objects, so the pool doubles in
+ * size each time it grows, and an object's slot index stays the same for the
+ * pool's lifetime. IDs are the slot index plus one.
+ *
+ * Each slab starts with a bitmask of its free slots, one bit per object.
+ * Objects are claimed and released by atomically clearing and setting their
+ * bit, so allocating and freeing don't lock. Only adding a slab does.
+ */
+
+#define SLAB_SLOT_COUNT(n)  ((ALuint)SLAB_BASE_COUNT<<(n))
+#define SLAB_FIRST_SLOT(n)  (SLAB_BASE_COUNT*((1u<<(n))-1))
+#define SLAB_MASK_COUNT(n)  (SLAB_SLOT_COUNT(n)/32)
+/* The objects follow the masks, 16-byte aligned. */
+#define SLAB_OBJ_OFFSET(n)  ((SLAB_MASK_COUNT(n)*sizeof(ATOMIC(ALuint)) + 15) & ~(size_t)15)
+
+static_assert((SLAB_BASE_COUNT%32) == 0, "Slab size must be a multiple of 32");
+
+
+static ALuint FindFirstBit(ALuint mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    ALuint bit = 0;
+    while(!(mask&1))
+    {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+
+void InitSlabPool(SlabPool *pool, size_t objsize)
+{
+    ALuint i;
+
+    pool->ObjSize = (objsize+15) & ~(size_t)15;
+    for(i = 0;i < SLAB_MAX_SLABS;i++)
+        ATOMIC_INIT(&pool->Slabs[i], NULL);
+    RWLockInit(&pool->GrowLock);
+}
+
+/* Frees all the pool's slabs. Any objects still allocated from it are freed
+ * along with them. */
+void ResetSlabPool(SlabPool *pool)
+{
+    ALuint i;
+
+    for(i = 0;i < SLAB_MAX_SLABS;i++)
+    {
+        ALvoid *slab = ATOMIC_EXCHANGE(ALvoid*, &pool->Slabs[i], NULL);
+        al_free(slab);
+    }
+}
+
+
+/* Returns slab n, adding it if it doesn't exist yet. */
+static ALubyte *GetSlab(SlabPool *pool, ALuint n)
+{
+    ATOMIC(ALuint) *masks;
+    ALubyte *slab;
+    ALuint i;
+
+    slab = ATOMIC_LOAD(&pool->Slabs[n]);
+    if(slab) return slab;
+
+    /* Check again with the lock held, since another thread may have added it
+     * while this one was waiting. */
+    WriteLock(&pool->GrowLock);
+    slab = ATOMIC_LOAD(&pool->Slabs[n]);
+    if(!slab)
+    {
+        slab = al_calloc(16, SLAB_OBJ_OFFSET(n) + SLAB_SLOT_COUNT(n)*pool->ObjSize);
+        if(slab)
+        {
+            masks = (ATOMIC(ALuint)*)slab;
+            for(i = 0;i < SLAB_MASK_COUNT(n);i++)
+                ATOMIC_INIT(&masks[i], ~0u);
+            ATOMIC_STORE(&pool->Slabs[n], slab);
+        }
+        else
+            ERR("Failed to allocate slab of %u objects\n", SLAB_SLOT_COUNT(n));
+    }
+    WriteUnlock(&pool->GrowLock);
+
+    return slab;
+}
+
+/* Allocates a zeroed object from the pool, and gives its ID if id isn't NULL.
+ * Returns NULL if the pool is full or out of memory. */
+ALvoid *SlabAlloc(SlabPool *pool, ALuint *id)
+{
+    ALuint n, i;
+
+    for(n = 0;n < SLAB_MAX_SLABS;n++)
+    {
+        ALubyte *slab = GetSlab(pool, n);
+        ATOMIC(ALuint) *masks;
+
+        if(!slab) return NULL;
+        masks = (ATOMIC(ALuint)*)slab;
+        for(i = 0;i < SLAB_MASK_COUNT(n);i++)
+        {
+            ALuint mask = ATOMIC_LOAD(&masks[i]);
+            while(mask != 0)
+            {
+                ALuint bit = FindFirstBit(mask);
+                if(ATOMIC_COMPARE_EXCHANGE_WEAK(ALuint, &masks[i], &mask, mask&~(1u<<bit)))
+                {
+                    ALuint slot = i*32 + bit;
+                    ALvoid *obj = slab + SLAB_OBJ_OFFSET(n) + slot*pool->ObjSize;
+
+                    memset(obj, 0, pool->ObjSize);
+                    if(id) *id = SLAB_FIRST_SLOT(n) + slot + 1;
+                    return obj;
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* Returns an object to the pool. It must not be used after this, since its
+ * slot may be given out again right away. */
+void SlabFree(SlabPool *pool, ALvoid *obj)
+{
+    ALuint n;
+
+    if(!obj) return;
+
+    for(n = 0;n < SLAB_MAX_SLABS;n++)
+    {
+        ALubyte *slab = ATOMIC_LOAD(&pool->Slabs[n]);
+        ALubyte *start, *end;
+
+        if(!slab) break;
+        start = slab + SLAB_OBJ_OFFSET(n);
+        end = start + SLAB_SLOT_COUNT(n)*pool->ObjSize;
+        if((ALubyte*)obj >= start && (ALubyte*)obj < end)
+        {
+            ATOMIC(ALuint) *masks = (ATOMIC(ALuint)*)slab;
+            ALuint slot = (ALuint)(((ALubyte*)obj - start) / pool->ObjSize);
+            ALuint mask = ATOMIC_LOAD(&masks[slot/32]);
+
+            while(!ATOMIC_COMPARE_EXCHANGE_WEAK(ALuint, &masks[slot/32], &mask,
+                                                mask|(1u<<(slot%32))))
+            {
+            }
+            return;
+        }
+    }
+
+    ERR("Object %p isn't from slab pool %p\n", obj, pool);
+}
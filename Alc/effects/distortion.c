@@ -84,7 +84,7 @@ static ALvoid ALdistortionState_update(ALdistortionState *state, ALCdevice *Devi
     ComputeAmbientGains(Device, Slot->Gain, state->Gain);
 }
 
-static ALvoid ALdistortionState_process(ALdistortionState *state, ALuint SamplesToDo, const ALfloat *restrict SamplesIn, ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
+static ALvoid ALdistortionState_process(ALdistortionState *state, ALuint SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
 {
     const ALfloat fc = state->edge_coeff;
     ALuint base;
@@ -106,7 +106,7 @@ static ALvoid ALdistortionState_process(ALdistortionState *state, ALuint Samples
         /* Fill oversample buffer using zero stuffing */
         for(it = 0;it < td;it++)
         {
-            oversample_buffer[it][0] = SamplesIn[it+base];
+            oversample_buffer[it][0] = SamplesIn[0][it+base];
             oversample_buffer[it][1] = 0.0f;
             oversample_buffer[it][2] = 0.0f;
             oversample_buffer[it][3] = 0.0f;
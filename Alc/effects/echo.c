@@ -33,6 +33,9 @@
 typedef struct ALechoState {
     DERIVE_FROM_TYPE(ALeffectState);
 
+    /* Two delay lines of BufferLength samples each. Only the first is used
+     * with mono input. With B-Format input, each tap reads from its own line,
+     * fed from the side of the input that tap is panned to. */
     ALfloat *SampleBuffer;
     ALuint BufferLength;
 
@@ -47,7 +50,13 @@ typedef struct ALechoState {
 
     ALfloat FeedGain;
 
+    /* Set when the input is B-Format, along with the gain applied to the Y
+     * (left) input channel for each tap's line. */
+    ALboolean IsBFormat;
+    ALfloat SideGain[2];
+
     ALfilterState Filter;
+    ALfilterState SideFilter;
 } ALechoState;
 
 static ALvoid ALechoState_Destruct(ALechoState *state)
@@ -70,12 +79,12 @@ static ALboolean ALechoState_deviceUpdate(ALechoState *state, ALCdevice *Device)
     {
         void *temp;
 
-        temp = realloc(state->SampleBuffer, maxlen * sizeof(ALfloat));
+        temp = realloc(state->SampleBuffer, maxlen * 2 * sizeof(ALfloat));
         if(!temp) return AL_FALSE;
         state->SampleBuffer = temp;
         state->BufferLength = maxlen;
     }
-    for(i = 0;i < state->BufferLength;i++)
+    for(i = 0;i < state->BufferLength*2;i++)
         state->SampleBuffer[i] = 0.0f;
 
     return AL_TRUE;
@@ -99,6 +108,16 @@ static ALvoid ALechoState_update(ALechoState *state, ALCdevice *Device, const AL
     ALfilterState_setParams(&state->Filter, ALfilterType_HighShelf,
                             1.0f - Slot->EffectProps.Echo.Damping,
                             LOWPASSFREQREF/frequency, 0.0f);
+    ALfilterState_setParams(&state->SideFilter, ALfilterType_HighShelf,
+                            1.0f - Slot->EffectProps.Echo.Damping,
+                            LOWPASSFREQREF/frequency, 0.0f);
+
+    /* The first tap is panned to -lrpan on the X axis, which is +lrpan on the
+     * B-Format Y axis. Input on that side is favored for its line, and
+     * vice-versa for the second tap. */
+    state->IsBFormat = (Slot->NumChannels >= 4);
+    state->SideGain[0] =  lrpan;
+    state->SideGain[1] = -lrpan;
 
     /* First tap panning */
     pandir[0] = -lrpan;
@@ -109,11 +128,13 @@ static ALvoid ALechoState_update(ALechoState *state, ALCdevice *Device, const AL
     ComputeDirectionalGains(Device, pandir, gain, state->Gain[1]);
 }
 
-static ALvoid ALechoState_process(ALechoState *state, ALuint SamplesToDo, const ALfloat *restrict SamplesIn, ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
+static ALvoid ALechoState_process(ALechoState *state, ALuint SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
 {
     const ALuint mask = state->BufferLength-1;
     const ALuint tap1 = state->Tap[0].delay;
     const ALuint tap2 = state->Tap[1].delay;
+    ALfloat *restrict line0 = state->SampleBuffer;
+    ALfloat *restrict line1 = state->SampleBuffer + state->BufferLength;
     ALuint offset = state->Offset;
     ALfloat smp;
     ALuint base;
@@ -124,18 +145,45 @@ static ALvoid ALechoState_process(ALechoState *state, ALuint SamplesToDo, const
         ALfloat temps[128][2];
         ALuint td = minu(128, SamplesToDo-base);
 
-        for(i = 0;i < td;i++)
+        if(!state->IsBFormat)
+        {
+            for(i = 0;i < td;i++)
+            {
+                /* First tap */
+                temps[i][0] = line0[(offset-tap1) & mask];
+                /* Second tap */
+                temps[i][1] = line0[(offset-tap2) & mask];
+
+                // Apply damping and feedback gain to the second tap, and mix in
+                // the new sample
+                smp = ALfilterState_processSingle(&state->Filter, temps[i][1]+SamplesIn[0][i+base]);
+                line0[offset&mask] = smp * state->FeedGain;
+                offset++;
+            }
+        }
+        else
         {
-            /* First tap */
-            temps[i][0] = state->SampleBuffer[(offset-tap1) & mask];
-            /* Second tap */
-            temps[i][1] = state->SampleBuffer[(offset-tap2) & mask];
-
-            // Apply damping and feedback gain to the second tap, and mix in the
-            // new sample
-            smp = ALfilterState_processSingle(&state->Filter, temps[i][1]+SamplesIn[i+base]);
-            state->SampleBuffer[offset&mask] = smp * state->FeedGain;
-            offset++;
+            const ALfloat *restrict inW = SamplesIn[0] + base;
+            const ALfloat *restrict inY = SamplesIn[2] + base;
+
+            for(i = 0;i < td;i++)
+            {
+                /* First tap, from the first line */
+                temps[i][0] = line1[(offset-tap1) & mask];
+                /* Second tap, from the main line */
+                temps[i][1] = line0[(offset-tap2) & mask];
+
+                /* Both lines get the second tap fed back, so they stay the
+                 * same given centered input. */
+                smp = inW[i] + inY[i]*state->SideGain[1];
+                smp = ALfilterState_processSingle(&state->Filter, temps[i][1]+smp);
+                line0[offset&mask] = smp * state->FeedGain;
+
+                smp = inW[i] + inY[i]*state->SideGain[0];
+                smp = ALfilterState_processSingle(&state->SideFilter, temps[i][1]+smp);
+                line1[offset&mask] = smp * state->FeedGain;
+                offset++;
+            }
         }
 
         for(k = 0;k < NumChannels;k++)
@@ -185,7 +233,12 @@ ALeffectState *ALechoStateFactory_create(ALechoStateFactory *UNUSED(factory))
     state->Tap[1].delay = 0;
     state->Offset = 0;
 
+    state->IsBFormat = AL_FALSE;
+    state->SideGain[0] = 0.0f;
+    state->SideGain[1] = 0.0f;
+
     ALfilterState_clear(&state->Filter);
+    ALfilterState_clear(&state->SideFilter);
 
     return STATIC_CAST(ALeffectState, state);
 }
@@ -89,6 +89,20 @@ typedef struct ALreverbState {
         ALfloat   PanGain[MAX_OUTPUT_CHANNELS];
     } Early;
 
+    // Directional (X, Y, Z) input, used when the slot is fed B-Format. It's
+    // filtered and delayed along with the early reflections, then decoded to
+    // the output so the first reflections come from around the source.
+    struct {
+        ALboolean Enabled;
+
+        ALfilterState LpFilter[3];
+        ALfilterState HpFilter[3]; // EAX only
+
+        DelayLine Delay[3];
+
+        ALfloat Gain[3][MAX_OUTPUT_CHANNELS];
+    } Dir;
+
     // Decorrelator delay line.
     DelayLine Decorrelator;
     // There are actually 4 decorrelator taps, but the first occurs at the
@@ -159,9 +173,22 @@ typedef struct ALreverbState {
     // Late.PanGain)
     ALfloat *Gain;
 
+    // The output gains actually applied when processing. After an update,
+    // these move from their old values to the new ones set above over the
+    // next FadeCount samples, so level and panning changes don't click.
+    struct {
+        ALfloat EarlyGain;
+        ALfloat LateGain;
+        ALfloat EarlyPan[MAX_OUTPUT_CHANNELS];
+        ALfloat LatePan[MAX_OUTPUT_CHANNELS];
+        ALfloat DirPan[3][MAX_OUTPUT_CHANNELS];
+    } Current;
+    ALuint FadeCount;
+
     /* Temporary storage used when processing, before deinterlacing. */
     ALfloat ReverbSamples[BUFFERSIZE][4];
     ALfloat EarlySamples[BUFFERSIZE][4];
+    ALfloat DirSamples[BUFFERSIZE];
 } ALreverbState;
 
 /* This is a user config option for modifying the overall output of the reverb
@@ -341,10 +368,10 @@ static inline ALvoid EarlyReflection(ALreverbState *State, ALfloat in, ALfloat *
     DelayLineIn(&State->Early.Delay[3], State->Offset, f[3]);
 
     // Output the results of the junction for all four channels.
-    out[0] = State->Early.Gain * f[0];
-    out[1] = State->Early.Gain * f[1];
-    out[2] = State->Early.Gain * f[2];
-    out[3] = State->Early.Gain * f[3];
+    out[0] = State->Current.EarlyGain * f[0];
+    out[1] = State->Current.EarlyGain * f[1];
+    out[2] = State->Current.EarlyGain * f[2];
+    out[3] = State->Current.EarlyGain * f[3];
 }
 
 // All-pass input/output routine for late reverb.
@@ -431,10 +458,10 @@ static inline ALvoid LateReverb(ALreverbState *State, const ALfloat *restrict in
 
     // Output the results of the matrix for all four channels, attenuated by
     // the late reverb gain (which is attenuated by the 'x' mix coefficient).
-    out[0] = State->Late.Gain * f[0];
-    out[1] = State->Late.Gain * f[1];
-    out[2] = State->Late.Gain * f[2];
-    out[3] = State->Late.Gain * f[3];
+    out[0] = State->Current.LateGain * f[0];
+    out[1] = State->Current.LateGain * f[1];
+    out[2] = State->Current.LateGain * f[2];
+    out[3] = State->Current.LateGain * f[3];
 
     // Re-feed the cyclical delay lines.
     DelayLineIn(&State->Late.Delay[0], State->Offset, f[0]);
@@ -479,7 +506,7 @@ static inline ALvoid EAXEcho(ALreverbState *State, ALfloat in, ALfloat *restrict
 
 // Perform the non-EAX reverb pass on a given input sample, resulting in
 // four-channel output.
-static inline ALvoid VerbPass(ALreverbState *State, ALfloat in, ALfloat *restrict out)
+static ALvoid VerbPass(ALreverbState *State, ALfloat in, ALfloat *restrict out)
 {
     ALfloat feed, late[4], taps[4];
 
@@ -518,7 +545,7 @@ static inline ALvoid VerbPass(ALreverbState *State, ALfloat in, ALfloat *restric
 
 // Perform the EAX reverb pass on a given input sample, resulting in four-
 // channel output.
-static inline ALvoid EAXVerbPass(ALreverbState *State, ALfloat in, ALfloat *restrict early, ALfloat *restrict late)
+static ALvoid EAXVerbPass(ALreverbState *State, ALfloat in, ALfloat *restrict early, ALfloat *restrict late)
 {
     ALfloat feed, taps[4];
 
@@ -556,61 +583,130 @@ static inline ALvoid EAXVerbPass(ALreverbState *State, ALfloat in, ALfloat *rest
     State->Offset++;
 }
 
-static ALvoid ALreverbState_processStandard(ALreverbState *State, ALuint SamplesToDo, const ALfloat *restrict SamplesIn, ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
+// Mixes one channel of reverb output, with the given stride between input
+// samples. The gain moves from its current value to the target over the first
+// 'fade' samples, out of 'count' samples left in the whole fade.
+static inline ALvoid MixChannel(ALfloat *restrict out, const ALfloat *restrict in, ALuint stride, ALfloat *restrict current, ALfloat target, ALuint fade, ALuint count, ALuint SamplesToDo)
 {
-    ALfloat (*restrict out)[4] = State->ReverbSamples;
-    ALuint index, c;
+    ALfloat gain = *current;
+    ALuint index = 0;
 
-    /* Process reverb for these samples. */
-    for(index = 0;index < SamplesToDo;index++)
-        VerbPass(State, SamplesIn[index], out[index]);
+    if(fade > 0)
+    {
+        ALfloat step = (target - gain) / count;
+        for(;index < fade;index++)
+        {
+            gain += step;
+            out[index] += gain * in[index*stride];
+        }
+        if(fade == count)
+            gain = target;
+        *current = gain;
+    }
 
-    for(c = 0;c < NumChannels;c++)
+    if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
+        return;
+    for(;index < SamplesToDo;index++)
+        out[index] += gain * in[index*stride];
+}
+
+// Filter and delay the directional part of B-Format input, and mix it to the
+// output with the early reflections. Must be called before the main pass, so
+// the delay line offset matches.
+static ALvoid DirectionalPass(ALreverbState *State, ALuint SamplesToDo, ALuint fade, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
+{
+    ALfloat *restrict out = State->DirSamples;
+    ALuint index, c, k;
+
+    for(k = 0;k < 3;k++)
     {
-        ALfloat gain = State->Gain[c];
-        if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
-            continue;
+        const ALfloat *restrict in = SamplesIn[k+1];
+        DelayLine *Delay = &State->Dir.Delay[k];
+        ALuint offset = State->Offset;
 
         for(index = 0;index < SamplesToDo;index++)
-            SamplesOut[c][index] += gain * out[index][c&3];
+        {
+            ALfloat smp = ALfilterState_processSingle(&State->Dir.LpFilter[k], in[index]);
+            if(State->IsEax)
+                smp = ALfilterState_processSingle(&State->Dir.HpFilter[k], smp);
+
+            DelayLineIn(Delay, offset, smp);
+            out[index] = DelayLineOut(Delay, offset - State->DelayTap[0]);
+            offset++;
+        }
+
+        for(c = 0;c < NumChannels;c++)
+            MixChannel(SamplesOut[c], out, 1, &State->Current.DirPan[k][c],
+                       State->Dir.Gain[k][c], fade, State->FadeCount, SamplesToDo);
     }
 }
 
-static ALvoid ALreverbState_processEax(ALreverbState *State, ALuint SamplesToDo, const ALfloat *restrict SamplesIn, ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
+// Moves the early and late gains one step closer to their targets, for the
+// given number of steps left in the fade.
+static inline ALvoid StepVerbGains(ALreverbState *State, ALuint count)
+{
+    State->Current.EarlyGain += (State->Early.Gain - State->Current.EarlyGain) / count;
+    State->Current.LateGain += (State->Late.Gain - State->Current.LateGain) / count;
+}
+
+static ALvoid ALreverbState_processStandard(ALreverbState *State, ALuint SamplesToDo, ALuint fade, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
+{
+    ALfloat (*restrict out)[4] = State->ReverbSamples;
+    ALuint index, c;
+
+    if(State->Dir.Enabled)
+        DirectionalPass(State, SamplesToDo, fade, SamplesIn, SamplesOut, NumChannels);
+
+    /* Process reverb for these samples. */
+    for(index = 0;index < fade;index++)
+    {
+        StepVerbGains(State, State->FadeCount-index);
+        VerbPass(State, SamplesIn[0][index], out[index]);
+    }
+    for(;index < SamplesToDo;index++)
+        VerbPass(State, SamplesIn[0][index], out[index]);
+
+    for(c = 0;c < NumChannels;c++)
+        MixChannel(SamplesOut[c], &out[0][c&3], 4, &State->Current.LatePan[c],
+                   State->Gain[c], fade, State->FadeCount, SamplesToDo);
+}
+
+static ALvoid ALreverbState_processEax(ALreverbState *State, ALuint SamplesToDo, ALuint fade, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
 {
     ALfloat (*restrict early)[4] = State->EarlySamples;
     ALfloat (*restrict late)[4] = State->ReverbSamples;
     ALuint index, c;
 
+    if(State->Dir.Enabled)
+        DirectionalPass(State, SamplesToDo, fade, SamplesIn, SamplesOut, NumChannels);
+
     /* Process reverb for these samples. */
-    for(index = 0;index < SamplesToDo;index++)
-        EAXVerbPass(State, SamplesIn[index], early[index], late[index]);
+    for(index = 0;index < fade;index++)
+    {
+        StepVerbGains(State, State->FadeCount-index);
+        EAXVerbPass(State, SamplesIn[0][index], early[index], late[index]);
+    }
+    for(;index < SamplesToDo;index++)
+        EAXVerbPass(State, SamplesIn[0][index], early[index], late[index]);
 
     for(c = 0;c < NumChannels;c++)
     {
-        ALfloat earlyGain, lateGain;
-
-        earlyGain = State->Early.PanGain[c];
-        if(fabsf(earlyGain) > GAIN_SILENCE_THRESHOLD)
-        {
-            for(index = 0;index < SamplesToDo;index++)
-                SamplesOut[c][index] += earlyGain*early[index][c&3];
-        }
-        lateGain = State->Late.PanGain[c];
-        if(fabsf(lateGain) > GAIN_SILENCE_THRESHOLD)
-        {
-            for(index = 0;index < SamplesToDo;index++)
-                SamplesOut[c][index] += lateGain*late[index][c&3];
-        }
+        MixChannel(SamplesOut[c], &early[0][c&3], 4, &State->Current.EarlyPan[c],
+                   State->Early.PanGain[c], fade, State->FadeCount, SamplesToDo);
+        MixChannel(SamplesOut[c], &late[0][c&3], 4, &State->Current.LatePan[c],
+                   State->Late.PanGain[c], fade, State->FadeCount, SamplesToDo);
     }
 }
 
-static ALvoid ALreverbState_process(ALreverbState *State, ALuint SamplesToDo, const ALfloat *restrict SamplesIn, ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
+static ALvoid ALreverbState_process(ALreverbState *State, ALuint SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALuint NumChannels)
 {
+    ALuint fade = minu(SamplesToDo, State->FadeCount);
+
     if(State->IsEax)
-        ALreverbState_processEax(State, SamplesToDo, SamplesIn, SamplesOut, NumChannels);
+        ALreverbState_processEax(State, SamplesToDo, fade, SamplesIn, SamplesOut, NumChannels);
     else
-        ALreverbState_processStandard(State, SamplesToDo, SamplesIn, SamplesOut, NumChannels);
+        ALreverbState_processStandard(State, SamplesToDo, fade, SamplesIn, SamplesOut, NumChannels);
+    State->FadeCount -= fade;
 }
 
 // Given the allocated sample buffer, this function updates each delay line
@@ -671,6 +767,11 @@ static ALboolean AllocLines(ALuint frequency, ALreverbState *State)
         totalSamples += CalcLineLength(EARLY_LINE_LENGTH[index], totalSamples,
                                        frequency, &State->Early.Delay[index]);
 
+    // The directional input lines only need to cover the reflections delay.
+    for(index = 0;index < 3;index++)
+        totalSamples += CalcLineLength(AL_EAXREVERB_MAX_REFLECTIONS_DELAY, totalSamples,
+                                       frequency, &State->Dir.Delay[index]);
+
     // The decorrelator line is calculated from the lowest reverb density (a
     // parameter value of 1).
     length = (DECO_FRACTION * DECO_MULTIPLIER * DECO_MULTIPLIER) *
@@ -716,6 +817,8 @@ static ALboolean AllocLines(ALuint frequency, ALreverbState *State)
         RealizeLineOffset(State->SampleBuffer, &State->Late.ApDelay[index]);
         RealizeLineOffset(State->SampleBuffer, &State->Late.Delay[index]);
     }
+    for(index = 0;index < 3;index++)
+        RealizeLineOffset(State->SampleBuffer, &State->Dir.Delay[index]);
     RealizeLineOffset(State->SampleBuffer, &State->Mod.Delay);
     RealizeLineOffset(State->SampleBuffer, &State->Echo.ApDelay);
     RealizeLineOffset(State->SampleBuffer, &State->Echo.Delay);
@@ -1110,6 +1213,23 @@ static ALvoid ALreverbState_update(ALreverbState *State, ALCdevice *Device, cons
                                 hfscale, 0.0f);
     }
 
+    // The directional input gets the same master filters.
+    State->Dir.Enabled = (Slot->NumChannels >= 4);
+    if(State->Dir.Enabled)
+    {
+        ALuint k;
+        for(k = 0;k < 3;k++)
+        {
+            ALfilterState_setParams(&State->Dir.LpFilter[k], ALfilterType_HighShelf,
+                                    Slot->EffectProps.Reverb.GainHF, hfscale, 0.0f);
+            if(State->IsEax)
+                ALfilterState_setParams(&State->Dir.HpFilter[k], ALfilterType_LowShelf,
+                                        Slot->EffectProps.Reverb.GainLF,
+                                        Slot->EffectProps.Reverb.LFReference / frequency,
+                                        0.0f);
+        }
+    }
+
     if(State->IsEax)
     {
         // Update the modulator line.
@@ -1169,6 +1289,27 @@ static ALvoid ALreverbState_update(ALreverbState *State, ALCdevice *Device, cons
         /* Update channel gains */
         ComputeAmbientGains(Device, Slot->Gain*1.4142f, State->Gain);
     }
+
+    if(State->Dir.Enabled)
+    {
+        /* Decode the X, Y, and Z input at the level of the first
+         * reflections. */
+        static const ALfloat DirMatrix[3][4] = {
+            { 0.0f, 1.0f, 0.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f, 0.0f },
+            { 0.0f, 0.0f, 0.0f, 1.0f }
+        };
+        ALfloat gain = State->Early.Gain * Slot->Gain;
+        ALuint k;
+
+        if(State->IsEax)
+            gain *= ReverbBoost;
+        for(k = 0;k < 3;k++)
+            ComputeBFormatGains(Device, DirMatrix[k], gain, State->Dir.Gain[k]);
+    }
+
+    // Fade to the new output gains rather than jumping to them.
+    State->FadeCount = EFFECT_FADE_SAMPLES;
 }
 
 
@@ -1224,6 +1365,19 @@ static ALeffectState *ALreverbStateFactory_create(ALreverbStateFactory* UNUSED(f
         state->Early.Offset[index] = 0;
     }
 
+    state->Dir.Enabled = AL_FALSE;
+    for(index = 0;index < 3;index++)
+    {
+        ALuint c;
+
+        ALfilterState_clear(&state->Dir.LpFilter[index]);
+        ALfilterState_clear(&state->Dir.HpFilter[index]);
+        state->Dir.Delay[index].Mask = 0;
+        state->Dir.Delay[index].Line = NULL;
+        for(c = 0;c < MAX_OUTPUT_CHANNELS;c++)
+            state->Dir.Gain[index][c] = 0.0f;
+    }
+
     state->Decorrelator.Mask = 0;
     state->Decorrelator.Line = NULL;
     state->DecoTap[0] = 0;
@@ -1275,6 +1429,18 @@ static ALeffectState *ALreverbStateFactory_create(ALreverbStateFactory* UNUSED(f
 
     state->Gain = state->Late.PanGain;
 
+    state->Current.EarlyGain = 0.0f;
+    state->Current.LateGain = 0.0f;
+    for(index = 0;index < MAX_OUTPUT_CHANNELS;index++)
+    {
+        state->Current.EarlyPan[index] = 0.0f;
+        state->Current.LatePan[index] = 0.0f;
+        state->Current.DirPan[0][index] = 0.0f;
+        state->Current.DirPan[1][index] = 0.0f;
+        state->Current.DirPan[2][index] = 0.0f;
+    }
+    state->FadeCount = 0;
+
     return STATIC_CAST(ALeffectState, state);
 }
 
@@ -78,6 +78,13 @@ DEFINE_PROPERTYKEY(PKEY_AudioEndpoint_FormFactor, 0x1da5d803, 0xd492, 0x4edd, 0x
 #ifdef HAVE_SYS_SYSCONF_H
 #include <sys/sysconf.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_IO_H
+#include <io.h>
+#endif
 #ifdef HAVE_FLOAT_H
 #include <float.h>
 #endif
@@ -529,6 +536,42 @@ FILE *OpenDataFile(const char *fname, const char *subdir)
     return NULL;
 }
 
+
+void *MapFileToMem(FILE *f, size_t *size)
+{
+    HANDLE file, fmap;
+    LARGE_INTEGER fsize;
+    void *ptr;
+
+    file = (HANDLE)_get_osfhandle(_fileno(f));
+    if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fsize) ||
+       fsize.QuadPart <= 0 || (ULONGLONG)fsize.QuadPart > (size_t)-1)
+        return NULL;
+
+    fmap = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!fmap)
+    {
+        WARN("CreateFileMapping failed: %lu\n", GetLastError());
+        return NULL;
+    }
+    /* The view keeps its own reference to the mapping object. */
+    ptr = MapViewOfFile(fmap, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(fmap);
+    if(!ptr)
+    {
+        WARN("MapViewOfFile failed: %lu\n", GetLastError());
+        return NULL;
+    }
+
+    *size = (size_t)fsize.QuadPart;
+    return ptr;
+}
+
+void UnmapFileMem(void *ptr, size_t UNUSED(size))
+{
+    UnmapViewOfFile(ptr);
+}
+
 #else
 
 #ifdef HAVE_DLFCN_H
@@ -646,6 +689,49 @@ FILE *OpenDataFile(const char *fname, const char *subdir)
     return NULL;
 }
 
+
+#ifdef HAVE_SYS_MMAN_H
+
+void *MapFileToMem(FILE *f, size_t *size)
+{
+    struct stat st;
+    void *ptr;
+    int fd;
+
+    fd = fileno(f);
+    if(fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0 ||
+       (unsigned long long)st.st_size > (size_t)-1)
+        return NULL;
+
+    ptr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if(ptr == MAP_FAILED)
+    {
+        WARN("mmap failed: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    *size = st.st_size;
+    return ptr;
+}
+
+void UnmapFileMem(void *ptr, size_t size)
+{
+    munmap(ptr, size);
+}
+
+#else
+
+void *MapFileToMem(FILE *UNUSED(f), size_t *UNUSED(size))
+{
+    return NULL;
+}
+
+void UnmapFileMem(void *UNUSED(ptr), size_t UNUSED(size))
+{
+}
+
+#endif /* HAVE_SYS_MMAN_H */
+
 #endif
 
 
@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <ctype.h>
+#include <math.h>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -30,6 +31,13 @@
 #include "alu.h"
 #include "hrtf.h"
 
+#include "threads.h"
+
+
+#ifndef M_PI
+#define M_PI  3.14159265358979323846
+#endif
+
 
 /* Current data set limits defined by the makehrtf utility. */
 #define MIN_IR_SIZE                  (8)
@@ -42,6 +50,17 @@
 #define MIN_AZ_COUNT                 (1)
 #define MAX_AZ_COUNT                 (128)
 
+/* HRIRs pre-interpolated for a regular grid of directions. The elevations go
+ * from -90 to +90 degrees inclusive, and the azimuths around from the front.
+ */
+struct HrtfCache {
+    ALuint evCount;
+    ALuint azCount;
+    ALfloat *delays;
+    ALfloat *coeffs[HRTF_IR_LEVELS];
+    alignas(16) ALfloat data[];
+};
+
 struct Hrtf {
     ALuint sampleRate;
     ALuint irSize;
@@ -49,20 +68,81 @@ struct Hrtf {
 
     const ALubyte *azCount;
     const ALushort *evOffset;
-    const ALshort *coeffs;
+    const ALfloat *coeffs;
     const ALubyte *delays;
 
+    /* Set when the tables above point into a single block (mapped from the
+     * data set file, or read into memory), rather than separate allocations.
+     */
+    void *data;
+    size_t dataSize;
+    ALboolean mapped;
+    /* Set for data sets resampled from another one at load time. */
+    ALboolean resampled;
+
+    /* Distance the HRIRs were measured at (in meters). */
+    ALfloat distance;
+
+    /* The direction cache and its resolution (in degrees, 0 for none). */
+    struct HrtfCache *cache;
+    ALfloat cacheResolution;
+
+    /* The HRIR length and coefficients for each level. The first is the full
+     * data set, and the rest are made from it by truncating the HRIRs.
+     */
+    ALuint levelSize[HRTF_IR_LEVELS];
+    const ALfloat *levelCoeffs[HRTF_IR_LEVELS];
+    ALfloat *truncData;
+    /* Set when the levels past the first are truncated, for devices using
+     * adaptive HRIR lengths. Otherwise they're all the full length.
+     */
+    ALboolean adaptive;
+
+    /* Set for variants of a loaded data set, which borrow its tables and only
+     * own their cache.
+     */
+    const struct Hrtf *parent;
+
     struct Hrtf *next;
 };
 
 static const ALchar magicMarker00[8] = "MinPHR00";
 static const ALchar magicMarker01[8] = "MinPHR01";
+static const ALchar magicMarker02[8] = "MinPHR02";
+
+/* The v2 data set header. The elevation tables follow it, then the float
+ * coefficients and the delays at the given (16-byte aligned) offsets.
+ */
+#define MHR02_HEADER_SIZE  (32)
+#define MHR02_ALIGNMENT    (16)
+
+/* Number of samples resampled HRIRs start before the original ones. */
+#define HRIR_RESAMPLE_LEAD (8)
+
+/* The measurement distance assumed for data sets that don't specify one (in
+ * meters). This is the distance of the MIT KEMAR measurements used for the
+ * default data sets.
+ */
+#define DEFAULT_HRTF_DISTANCE (1.4f)
+/* The closest measurement distance accepted from a data set (in meters), the
+ * same as makehrtf's. The near-field model needs it well outside the head. */
+#define MIN_HRTF_DISTANCE     (0.5f)
+
+/* The head radius of the near-field model, and the closest distance it's
+ * used for (in meters). */
+#define NFC_HEAD_RADIUS    (0.09f)
+#define NFC_MIN_DISTANCE   (0.15f)
 
 /* First value for pass-through coefficients (remaining are 0), used for omni-
  * directional sounds. */
-static const ALfloat PassthruCoeff = 32767.0f * 0.707106781187f/*sqrt(0.5)*/;
+static const ALfloat PassthruCoeff = 0.707106781187f/*sqrt(0.5)*/;
 
+/* The loaded data sets, with their variants. Devices are reset from multiple
+ * threads, so the list is only looked up or added to with the lock held.
+ */
 static struct Hrtf *LoadedHrtfs = NULL;
+static almtx_t HrtfLock;
+static alonce_flag HrtfLockOnce = AL_ONCE_FLAG_INIT;
 
 /* Calculate the elevation indices given the polar elevation in radians.
  * This will return two indices between 0 and (evcount - 1) and an
@@ -88,13 +168,14 @@ static void CalcAzIndices(ALuint azcount, ALfloat az, ALuint *azidx, ALfloat *az
     *azmu = az - floorf(az);
 }
 
-/* Calculates static HRIR coefficients and delays for the given polar
- * elevation and azimuth in radians.  Linear interpolation is used to
- * increase the apparent resolution of the HRIR data set.  The coefficients
- * are also normalized and attenuated by the specified gain.
+/* Calculates the HRIR coefficients (interleaved left and right) and delays for
+ * the given polar elevation and azimuth in radians.  Linear interpolation is
+ * used to increase the apparent resolution of the HRIR data set.
  */
-void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat dirfact, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays)
+static void CalcLerpedHrir(const struct Hrtf *Hrtf, ALuint level, ALfloat elevation, ALfloat azimuth, ALfloat *coeffs, ALfloat *delays)
 {
+    const ALfloat *hrirs = Hrtf->levelCoeffs[level];
+    const ALuint irSize = Hrtf->levelSize[level];
     ALuint evidx[2], lidx[4], ridx[4];
     ALfloat mu[3], blend[4];
     ALuint i;
@@ -125,183 +206,271 @@ void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azi
     blend[3] = (     mu[1]) * (     mu[2]);
 
     /* Calculate the HRIR delays using linear interpolation. */
-    delays[0] = fastf2u((Hrtf->delays[lidx[0]]*blend[0] + Hrtf->delays[lidx[1]]*blend[1] +
-                         Hrtf->delays[lidx[2]]*blend[2] + Hrtf->delays[lidx[3]]*blend[3]) *
-                        dirfact + 0.5f) << HRTFDELAY_BITS;
-    delays[1] = fastf2u((Hrtf->delays[ridx[0]]*blend[0] + Hrtf->delays[ridx[1]]*blend[1] +
-                         Hrtf->delays[ridx[2]]*blend[2] + Hrtf->delays[ridx[3]]*blend[3]) *
-                        dirfact + 0.5f) << HRTFDELAY_BITS;
+    delays[0] = Hrtf->delays[lidx[0]]*blend[0] + Hrtf->delays[lidx[1]]*blend[1] +
+                Hrtf->delays[lidx[2]]*blend[2] + Hrtf->delays[lidx[3]]*blend[3];
+    delays[1] = Hrtf->delays[ridx[0]]*blend[0] + Hrtf->delays[ridx[1]]*blend[1] +
+                Hrtf->delays[ridx[2]]*blend[2] + Hrtf->delays[ridx[3]]*blend[3];
 
     /* Calculate the sample offsets for the HRIR indices. */
-    lidx[0] *= Hrtf->irSize;
-    lidx[1] *= Hrtf->irSize;
-    lidx[2] *= Hrtf->irSize;
-    lidx[3] *= Hrtf->irSize;
-    ridx[0] *= Hrtf->irSize;
-    ridx[1] *= Hrtf->irSize;
-    ridx[2] *= Hrtf->irSize;
-    ridx[3] *= Hrtf->irSize;
-
-    /* Calculate the normalized and attenuated HRIR coefficients using linear
-     * interpolation when there is enough gain to warrant it.  Zero the
-     * coefficients if gain is too low.
+    lidx[0] *= irSize;
+    lidx[1] *= irSize;
+    lidx[2] *= irSize;
+    lidx[3] *= irSize;
+    ridx[0] *= irSize;
+    ridx[1] *= irSize;
+    ridx[2] *= irSize;
+    ridx[3] *= irSize;
+
+    for(i = 0;i < irSize;i++)
+    {
+        coeffs[i*2 + 0] = hrirs[lidx[0]+i]*blend[0] + hrirs[lidx[1]+i]*blend[1] +
+                          hrirs[lidx[2]+i]*blend[2] + hrirs[lidx[3]+i]*blend[3];
+        coeffs[i*2 + 1] = hrirs[ridx[0]+i]*blend[0] + hrirs[ridx[1]+i]*blend[1] +
+                          hrirs[ridx[2]+i]*blend[2] + hrirs[ridx[3]+i]*blend[3];
+    }
+}
+
+/* Gets the HRIR coefficients and delays for the given direction and level.
+ * With a direction cache, this returns the nearest cached entry. Otherwise,
+ * the HRIR is interpolated into the given buffer.
+ */
+static const ALfloat *GetHrir(const struct Hrtf *Hrtf, ALuint level, ALfloat elevation, ALfloat azimuth, ALfloat *buffer, ALfloat *delays)
+{
+    const struct HrtfCache *cache = Hrtf->cache;
+    ALuint evidx, azidx, idx;
+
+    if(!cache)
+    {
+        CalcLerpedHrir(Hrtf, level, elevation, azimuth, buffer, delays);
+        return buffer;
+    }
+
+    evidx = fastf2u((F_PI_2 + elevation) * (cache->evCount-1) / F_PI + 0.5f);
+    azidx = fastf2u((F_2PI + azimuth) * cache->azCount / F_2PI + 0.5f) % cache->azCount;
+    idx = minu(evidx, cache->evCount-1)*cache->azCount + azidx;
+
+    delays[0] = cache->delays[idx*2 + 0];
+    delays[1] = cache->delays[idx*2 + 1];
+    return &cache->coeffs[level][idx * Hrtf->levelSize[level]*2];
+}
+
+/* Calculates the length of the path from a point source to an ear on a
+ * spherical head, given the source distance and the cosine of the angle
+ * between the source and ear directions. The path goes around the head when
+ * the ear can't be seen from the source.
+ */
+static ALfloat CalcEarPath(ALfloat distance, ALfloat cosangle)
+{
+    const ALfloat a = NFC_HEAD_RADIUS;
+    ALfloat angle = acosf(clampf(cosangle, -1.0f, 1.0f));
+    ALfloat tangent = acosf(a / distance);
+
+    if(angle <= tangent)
+        return sqrtf(distance*distance + a*a - 2.0f*a*distance*cosangle);
+    return sqrtf(distance*distance - a*a) + a*(angle - tangent);
+}
+
+/* Applies near-field compensation to the given HRIRs (interleaved left and
+ * right) and delays, for a source closer than the data set's measurement
+ * distance. Using a rigid spherical head model, the low frequency gain of
+ * each ear follows the change in the source-to-ear distance relative to the
+ * source-to-head distance, which makes the level difference between the ears
+ * grow for close sources. The head shadow at higher frequencies is left to the
+ * measured HRIRs. The gain is applied with a first-order low-shelf, whose
+ * corner is where the head starts to shadow the far ear. This filters the
+ * HRIR taps when the coefficients are calculated, so it costs nothing extra
+ * to mix, and changes are faded in with the rest of the coefficients. The
+ * interaural delay is also adjusted for the change in path lengths. The
+ * compensation is applied in full; the callers blend it by the directional
+ * factor along with the rest of the HRIR.
+ */
+static void ApplyNearField(const struct Hrtf *Hrtf, ALfloat distance, ALfloat elevation, ALfloat azimuth, ALuint irSize, ALfloat *coeffs, ALfloat *delays)
+{
+    const ALfloat refdist = Hrtf->distance;
+    const ALfloat cutoff = SPEEDOFSOUNDMETRESPERSEC / (F_2PI*NFC_HEAD_RADIUS);
+    const ALfloat coeff = 1.0f - expf(-F_2PI * cutoff / Hrtf->sampleRate);
+    ALfloat cosangle[2];
+    ALuint c, i;
+
+    distance = maxf(distance, NFC_MIN_DISTANCE);
+    cosangle[1] = cosf(elevation) * sinf(azimuth);
+    cosangle[0] = -cosangle[1];
+    for(c = 0;c < 2;c++)
+    {
+        ALfloat path = CalcEarPath(distance, cosangle[c]);
+        ALfloat refpath = CalcEarPath(refdist, cosangle[c]);
+        ALfloat gain = (distance/path) / (refdist/refpath);
+        ALfloat delay = ((path-distance) - (refpath-refdist)) * Hrtf->sampleRate /
+                        SPEEDOFSOUNDMETRESPERSEC;
+        ALfloat lp = 0.0f;
+
+        gain -= 1.0f;
+        for(i = 0;i < irSize;i++)
+        {
+            lp += coeff * (coeffs[i*2 + c] - lp);
+            coeffs[i*2 + c] += gain * lp;
+        }
+        delays[c] = clampf(delays[c] + delay, 0.0f, (ALfloat)(HRTF_HISTORY_LENGTH-1));
+    }
+}
+
+/* Returns the largest low frequency gain near-field compensation applies for
+ * the given distance (in meters), which is for the ear facing the source. This
+ * is 1 outside of the compensation range.
+ */
+ALfloat GetHrtfNearFieldGain(const struct Hrtf *Hrtf, ALfloat distance)
+{
+    const ALfloat refdist = Hrtf->distance;
+
+    if(!(distance > 0.0f && distance < refdist))
+        return 1.0f;
+    distance = maxf(distance, NFC_MIN_DISTANCE);
+    return (distance/CalcEarPath(distance, 1.0f)) / (refdist/CalcEarPath(refdist, 1.0f));
+}
+
+/* Gets the HRIR coefficients and delays for the given direction, level and
+ * distance (0 for no near-field compensation). When compensated, the HRIR is
+ * always returned in the given buffer.
+ */
+static const ALfloat *GetNearFieldHrir(const struct Hrtf *Hrtf, ALuint level, ALfloat elevation, ALfloat azimuth, ALfloat distance, ALfloat *buffer, ALfloat *delays)
+{
+    const ALfloat *hrir = GetHrir(Hrtf, level, elevation, azimuth, buffer, delays);
+
+    if(!(distance > 0.0f && distance < Hrtf->distance))
+        return hrir;
+    if(hrir != buffer)
+        memcpy(buffer, hrir, Hrtf->levelSize[level]*2*sizeof(buffer[0]));
+    ApplyNearField(Hrtf, distance, elevation, azimuth, Hrtf->levelSize[level], buffer, delays);
+    return buffer;
+}
+
+/* Calculates static HRIR coefficients and delays for the given polar
+ * elevation and azimuth in radians, using the HRIRs of the given level.  The
+ * coefficients are also normalized and attenuated by the specified gain.
+ * Coefficients past the level's HRIR length (up to the full length) are
+ * zeroed.  A non-0 distance (in meters) applies near-field compensation.
+ */
+void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALuint level, ALfloat elevation, ALfloat azimuth, ALfloat distance, ALfloat dirfact, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays)
+{
+    alignas(16) ALfloat buffer[HRIR_LENGTH*2];
+    const ALuint irSize = Hrtf->levelSize[level];
+    const ALfloat *hrir;
+    ALfloat hrirDelays[2];
+    ALuint i;
+
+    hrir = GetNearFieldHrir(Hrtf, level, elevation, azimuth, distance, buffer, hrirDelays);
+
+    delays[0] = fastf2u(hrirDelays[0]*dirfact + 0.5f) << HRTFDELAY_BITS;
+    delays[1] = fastf2u(hrirDelays[1]*dirfact + 0.5f) << HRTFDELAY_BITS;
+
+    /* Calculate the normalized and attenuated HRIR coefficients when there
+     * is enough gain to warrant it.  Zero the coefficients if gain is too
+     * low.
      */
     if(gain > 0.0001f)
     {
-        ALfloat c;
-
         i = 0;
-        c = (Hrtf->coeffs[lidx[0]+i]*blend[0] + Hrtf->coeffs[lidx[1]+i]*blend[1] +
-             Hrtf->coeffs[lidx[2]+i]*blend[2] + Hrtf->coeffs[lidx[3]+i]*blend[3]);
-        coeffs[i][0] = lerp(PassthruCoeff, c, dirfact) * gain * (1.0f/32767.0f);
-        c = (Hrtf->coeffs[ridx[0]+i]*blend[0] + Hrtf->coeffs[ridx[1]+i]*blend[1] +
-             Hrtf->coeffs[ridx[2]+i]*blend[2] + Hrtf->coeffs[ridx[3]+i]*blend[3]);
-        coeffs[i][1] = lerp(PassthruCoeff, c, dirfact) * gain * (1.0f/32767.0f);
+        coeffs[i][0] = lerp(PassthruCoeff, hrir[i*2 + 0], dirfact) * gain;
+        coeffs[i][1] = lerp(PassthruCoeff, hrir[i*2 + 1], dirfact) * gain;
 
-        for(i = 1;i < Hrtf->irSize;i++)
+        for(i = 1;i < irSize;i++)
         {
-            c = (Hrtf->coeffs[lidx[0]+i]*blend[0] + Hrtf->coeffs[lidx[1]+i]*blend[1] +
-                 Hrtf->coeffs[lidx[2]+i]*blend[2] + Hrtf->coeffs[lidx[3]+i]*blend[3]);
-            coeffs[i][0] = lerp(0.0f, c, dirfact) * gain * (1.0f/32767.0f);
-            c = (Hrtf->coeffs[ridx[0]+i]*blend[0] + Hrtf->coeffs[ridx[1]+i]*blend[1] +
-                 Hrtf->coeffs[ridx[2]+i]*blend[2] + Hrtf->coeffs[ridx[3]+i]*blend[3]);
-            coeffs[i][1] = lerp(0.0f, c, dirfact) * gain * (1.0f/32767.0f);
+            coeffs[i][0] = lerp(0.0f, hrir[i*2 + 0], dirfact) * gain;
+            coeffs[i][1] = lerp(0.0f, hrir[i*2 + 1], dirfact) * gain;
         }
     }
     else
     {
-        for(i = 0;i < Hrtf->irSize;i++)
+        for(i = 0;i < irSize;i++)
         {
             coeffs[i][0] = 0.0f;
             coeffs[i][1] = 0.0f;
         }
     }
+    for(i = irSize;i < Hrtf->irSize;i++)
+    {
+        coeffs[i][0] = 0.0f;
+        coeffs[i][1] = 0.0f;
+    }
 }
 
 /* Calculates the moving HRIR target coefficients, target delays, and
- * stepping values for the given polar elevation and azimuth in radians.
- * Linear interpolation is used to increase the apparent resolution of the
- * HRIR data set.  The coefficients are also normalized and attenuated by the
- * specified gain.  Stepping resolution and count is determined using the
- * given delta factor between 0.0 and 1.0.
+ * stepping values for the given polar elevation and azimuth in radians,
+ * using the HRIRs of the given level.  The coefficients are also normalized
+ * and attenuated by the specified gain, and those past the level's HRIR
+ * length fade to zero.  A non-0 distance (in meters) applies near-field
+ * compensation.  Stepping resolution and count is determined using the given
+ * delta factor between 0.0 and 1.0.
  */
-ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat dirfact, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep)
+ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALuint level, ALfloat elevation, ALfloat azimuth, ALfloat distance, ALfloat dirfact, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep)
 {
-    ALuint evidx[2], lidx[4], ridx[4];
-    ALfloat mu[3], blend[4];
+    alignas(16) ALfloat buffer[HRIR_LENGTH*2];
+    const ALuint irSize = Hrtf->levelSize[level];
+    const ALfloat *hrir;
+    ALfloat hrirDelays[2];
     ALfloat left, right;
     ALfloat steps;
     ALuint i;
 
-    /* Claculate elevation indices and interpolation factor. */
-    CalcEvIndices(Hrtf->evCount, elevation, evidx, &mu[2]);
-
-    for(i = 0;i < 2;i++)
-    {
-        ALuint azcount = Hrtf->azCount[evidx[i]];
-        ALuint evoffset = Hrtf->evOffset[evidx[i]];
-        ALuint azidx[2];
-
-        /* Calculate azimuth indices and interpolation factor for this elevation. */
-        CalcAzIndices(azcount, azimuth, azidx, &mu[i]);
-
-        /* Calculate a set of linear HRIR indices for left and right channels. */
-        lidx[i*2 + 0] = evoffset + azidx[0];
-        lidx[i*2 + 1] = evoffset + azidx[1];
-        ridx[i*2 + 0] = evoffset + ((azcount-azidx[0]) % azcount);
-        ridx[i*2 + 1] = evoffset + ((azcount-azidx[1]) % azcount);
-    }
+    hrir = GetNearFieldHrir(Hrtf, level, elevation, azimuth, distance, buffer, hrirDelays);
 
     // Calculate the stepping parameters.
     steps = maxf(floorf(delta*Hrtf->sampleRate + 0.5f), 1.0f);
     delta = 1.0f / steps;
 
-    /* Calculate 4 blending weights for 2D bilinear interpolation. */
-    blend[0] = (1.0f-mu[0]) * (1.0f-mu[2]);
-    blend[1] = (     mu[0]) * (1.0f-mu[2]);
-    blend[2] = (1.0f-mu[1]) * (     mu[2]);
-    blend[3] = (     mu[1]) * (     mu[2]);
-
-    /* Calculate the HRIR delays using linear interpolation.  Then calculate
-     * the delay stepping values using the target and previous running
-     * delays.
+    /* Calculate the target HRIR delays, then the delay stepping values using
+     * the target and previous running delays.
      */
     left = (ALfloat)(delays[0] - (delayStep[0] * counter));
     right = (ALfloat)(delays[1] - (delayStep[1] * counter));
 
-    delays[0] = fastf2u((Hrtf->delays[lidx[0]]*blend[0] + Hrtf->delays[lidx[1]]*blend[1] +
-                         Hrtf->delays[lidx[2]]*blend[2] + Hrtf->delays[lidx[3]]*blend[3]) *
-                        dirfact + 0.5f) << HRTFDELAY_BITS;
-    delays[1] = fastf2u((Hrtf->delays[ridx[0]]*blend[0] + Hrtf->delays[ridx[1]]*blend[1] +
-                         Hrtf->delays[ridx[2]]*blend[2] + Hrtf->delays[ridx[3]]*blend[3]) *
-                        dirfact + 0.5f) << HRTFDELAY_BITS;
+    delays[0] = fastf2u(hrirDelays[0]*dirfact + 0.5f) << HRTFDELAY_BITS;
+    delays[1] = fastf2u(hrirDelays[1]*dirfact + 0.5f) << HRTFDELAY_BITS;
 
     delayStep[0] = fastf2i(delta * (delays[0] - left));
     delayStep[1] = fastf2i(delta * (delays[1] - right));
 
-    /* Calculate the sample offsets for the HRIR indices. */
-    lidx[0] *= Hrtf->irSize;
-    lidx[1] *= Hrtf->irSize;
-    lidx[2] *= Hrtf->irSize;
-    lidx[3] *= Hrtf->irSize;
-    ridx[0] *= Hrtf->irSize;
-    ridx[1] *= Hrtf->irSize;
-    ridx[2] *= Hrtf->irSize;
-    ridx[3] *= Hrtf->irSize;
-
-    /* Calculate the normalized and attenuated target HRIR coefficients using
-     * linear interpolation when there is enough gain to warrant it.  Zero
-     * the target coefficients if gain is too low.  Then calculate the
-     * coefficient stepping values using the target and previous running
-     * coefficients.
+    /* Calculate the normalized and attenuated target HRIR coefficients when
+     * there is enough gain to warrant it.  Zero the target coefficients if
+     * gain is too low.  Then calculate the coefficient stepping values using
+     * the target and previous running coefficients.
      */
     if(gain > 0.0001f)
     {
-        ALfloat c;
-
         i = 0;
         left = coeffs[i][0] - (coeffStep[i][0] * counter);
         right = coeffs[i][1] - (coeffStep[i][1] * counter);
 
-        c = (Hrtf->coeffs[lidx[0]+i]*blend[0] + Hrtf->coeffs[lidx[1]+i]*blend[1] +
-             Hrtf->coeffs[lidx[2]+i]*blend[2] + Hrtf->coeffs[lidx[3]+i]*blend[3]);
-        coeffs[i][0] = lerp(PassthruCoeff, c, dirfact) * gain * (1.0f/32767.0f);
-        c = (Hrtf->coeffs[ridx[0]+i]*blend[0] + Hrtf->coeffs[ridx[1]+i]*blend[1] +
-             Hrtf->coeffs[ridx[2]+i]*blend[2] + Hrtf->coeffs[ridx[3]+i]*blend[3]);
-        coeffs[i][1] = lerp(PassthruCoeff, c, dirfact) * gain * (1.0f/32767.0f);
+        coeffs[i][0] = lerp(PassthruCoeff, hrir[i*2 + 0], dirfact) * gain;
+        coeffs[i][1] = lerp(PassthruCoeff, hrir[i*2 + 1], dirfact) * gain;
 
         coeffStep[i][0] = delta * (coeffs[i][0] - left);
         coeffStep[i][1] = delta * (coeffs[i][1] - right);
 
-        for(i = 1;i < Hrtf->irSize;i++)
+        for(i = 1;i < irSize;i++)
         {
             left = coeffs[i][0] - (coeffStep[i][0] * counter);
             right = coeffs[i][1] - (coeffStep[i][1] * counter);
 
-            c = (Hrtf->coeffs[lidx[0]+i]*blend[0] + Hrtf->coeffs[lidx[1]+i]*blend[1] +
-                 Hrtf->coeffs[lidx[2]+i]*blend[2] + Hrtf->coeffs[lidx[3]+i]*blend[3]);
-            coeffs[i][0] = lerp(0.0f, c, dirfact) * gain * (1.0f/32767.0f);
-            c = (Hrtf->coeffs[ridx[0]+i]*blend[0] + Hrtf->coeffs[ridx[1]+i]*blend[1] +
-                 Hrtf->coeffs[ridx[2]+i]*blend[2] + Hrtf->coeffs[ridx[3]+i]*blend[3]);
-            coeffs[i][1] = lerp(0.0f, c, dirfact) * gain * (1.0f/32767.0f);
+            coeffs[i][0] = lerp(0.0f, hrir[i*2 + 0], dirfact) * gain;
+            coeffs[i][1] = lerp(0.0f, hrir[i*2 + 1], dirfact) * gain;
 
             coeffStep[i][0] = delta * (coeffs[i][0] - left);
             coeffStep[i][1] = delta * (coeffs[i][1] - right);
         }
     }
     else
+        i = 0;
+    for(;i < Hrtf->irSize;i++)
     {
-        for(i = 0;i < Hrtf->irSize;i++)
-        {
-            left = coeffs[i][0] - (coeffStep[i][0] * counter);
-            right = coeffs[i][1] - (coeffStep[i][1] * counter);
+        left = coeffs[i][0] - (coeffStep[i][0] * counter);
+        right = coeffs[i][1] - (coeffStep[i][1] * counter);
 
-            coeffs[i][0] = 0.0f;
-            coeffs[i][1] = 0.0f;
+        coeffs[i][0] = 0.0f;
+        coeffs[i][1] = 0.0f;
 
-            coeffStep[i][0] = delta * -left;
-            coeffStep[i][1] = delta * -right;
-        }
+        coeffStep[i][0] = delta * -left;
+        coeffStep[i][1] = delta * -right;
     }
 
     /* The stepping count is the number of samples necessary for the HRIR to
@@ -312,8 +481,11 @@ ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat a
 }
 
 
-/* Calculates HRTF coefficients for a B-Format channel (first order only). */
-void GetBFormatHrtfCoeffs(const struct Hrtf *Hrtf, const ALfloat ambi_coeffs[4], ALfloat (*coeffs)[2], ALuint *delays)
+/* Calculates the HRIR coefficients for a B-Format channel. The ambisonic
+ * coefficients are in the same order as a ChannelConfig's HOACoeff, though only
+ * first-order and the horizontal second-order (U and V) coefficients are used.
+ */
+void GetBFormatHrtfCoeffs(const struct Hrtf *Hrtf, const ALfloat *ambi_coeffs, ALfloat (*coeffs)[2], ALuint *delays)
 {
     ALuint elev_idx, azi_idx;
     ALfloat scale;
@@ -368,6 +540,8 @@ void GetBFormatHrtfCoeffs(const struct Hrtf *Hrtf, const ALfloat ambi_coeffs[4],
             gain += ambi_coeffs[1]*x; /* X */
             gain += ambi_coeffs[2]*y; /* Y */
             gain += ambi_coeffs[3]*z; /* Z */
+            gain += ambi_coeffs[7]*(x*x - y*y); /* U */
+            gain += ambi_coeffs[8]*2.0f*x*y; /* V */
 
             if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
                 continue;
@@ -376,8 +550,8 @@ void GetBFormatHrtfCoeffs(const struct Hrtf *Hrtf, const ALfloat ambi_coeffs[4],
             ridx *= Hrtf->irSize;
             for(i = 0;i < Hrtf->irSize;i++)
             {
-                coeffs[i][0] += Hrtf->coeffs[lidx + i]*(1.0f/32767.0f) * gain;
-                coeffs[i][1] += Hrtf->coeffs[ridx + i]*(1.0f/32767.0f) * gain;
+                coeffs[i][0] += Hrtf->coeffs[lidx + i]*gain;
+                coeffs[i][1] += Hrtf->coeffs[ridx + i]*gain;
             }
         }
     }
@@ -404,7 +578,7 @@ static struct Hrtf *LoadHrtf00(FILE *f, ALuint deviceRate)
     ALubyte evCount = 0;
     ALubyte *azCount = NULL;
     ALushort *evOffset = NULL;
-    ALshort *coeffs = NULL;
+    ALfloat *coeffs = NULL;
     ALubyte *delays = NULL;
     ALuint i, j;
 
@@ -510,7 +684,7 @@ static struct Hrtf *LoadHrtf00(FILE *f, ALuint deviceRate)
                 ALshort coeff;
                 coeff  = fgetc(f);
                 coeff |= fgetc(f)<<8;
-                coeffs[i+j] = coeff;
+                coeffs[i+j] = coeff * (1.0f/32767.0f);
             }
         }
         for(i = 0;i < irCount;i++)
@@ -549,6 +723,16 @@ static struct Hrtf *LoadHrtf00(FILE *f, ALuint deviceRate)
         Hrtf->evOffset = evOffset;
         Hrtf->coeffs = coeffs;
         Hrtf->delays = delays;
+        Hrtf->data = NULL;
+        Hrtf->dataSize = 0;
+        Hrtf->mapped = AL_FALSE;
+        Hrtf->resampled = AL_FALSE;
+        Hrtf->distance = DEFAULT_HRTF_DISTANCE;
+        Hrtf->cache = NULL;
+        Hrtf->cacheResolution = 0.0f;
+        Hrtf->truncData = NULL;
+        Hrtf->adaptive = AL_FALSE;
+        Hrtf->parent = NULL;
         Hrtf->next = NULL;
         return Hrtf;
     }
@@ -570,7 +754,7 @@ static struct Hrtf *LoadHrtf01(FILE *f, ALuint deviceRate)
     ALubyte irSize = 0, evCount = 0;
     ALubyte *azCount = NULL;
     ALushort *evOffset = NULL;
-    ALshort *coeffs = NULL;
+    ALfloat *coeffs = NULL;
     ALubyte *delays = NULL;
     ALuint i, j;
 
@@ -655,7 +839,7 @@ static struct Hrtf *LoadHrtf01(FILE *f, ALuint deviceRate)
                 ALshort coeff;
                 coeff  = fgetc(f);
                 coeff |= fgetc(f)<<8;
-                coeffs[i+j] = coeff;
+                coeffs[i+j] = coeff * (1.0f/32767.0f);
             }
         }
         for(i = 0;i < irCount;i++)
@@ -694,6 +878,16 @@ static struct Hrtf *LoadHrtf01(FILE *f, ALuint deviceRate)
         Hrtf->evOffset = evOffset;
         Hrtf->coeffs = coeffs;
         Hrtf->delays = delays;
+        Hrtf->data = NULL;
+        Hrtf->dataSize = 0;
+        Hrtf->mapped = AL_FALSE;
+        Hrtf->resampled = AL_FALSE;
+        Hrtf->distance = DEFAULT_HRTF_DISTANCE;
+        Hrtf->cache = NULL;
+        Hrtf->cacheResolution = 0.0f;
+        Hrtf->truncData = NULL;
+        Hrtf->adaptive = AL_FALSE;
+        Hrtf->parent = NULL;
         Hrtf->next = NULL;
         return Hrtf;
     }
@@ -706,6 +900,295 @@ static struct Hrtf *LoadHrtf01(FILE *f, ALuint deviceRate)
 }
 
 
+static inline ALuint ReadLE32(const ALubyte *ptr)
+{ return ptr[0] | (ptr[1]<<8) | (ptr[2]<<16) | ((ALuint)ptr[3]<<24); }
+static inline ALuint ReadLE16(const ALubyte *ptr)
+{ return ptr[0] | (ptr[1]<<8); }
+
+/* Loads a v2 data set. Its tables are stored in the file the way they're used,
+ * so on little-endian systems the file is simply mapped into memory and
+ * checked, and every process using it shares the same pages. Otherwise it's
+ * read into memory and byte-swapped.
+ */
+static struct Hrtf *LoadHrtf02(FILE *f, ALuint deviceRate)
+{
+    const ALubyte maxDelay = HRTF_HISTORY_LENGTH-1;
+    struct Hrtf *Hrtf = NULL;
+    ALboolean failed = AL_FALSE;
+    ALboolean mapped = AL_FALSE;
+    ALuint rate = 0, irCount = 0, irSize = 0, evCount = 0;
+    ALuint evOffsetPos = 0, coeffPos = 0, delayPos = 0;
+    ALuint distance = 0;
+    const ALubyte *azCount = NULL;
+    const ALushort *evOffset = NULL;
+    const ALubyte *delays = NULL;
+    ALubyte *data = NULL;
+    size_t size = 0;
+    ALuint i, count;
+
+    if(IS_LITTLE_ENDIAN)
+        data = MapFileToMem(f, &size);
+    if(data != NULL)
+        mapped = AL_TRUE;
+    else
+    {
+        long fsize;
+
+        if(fseek(f, 0, SEEK_END) != 0 || (fsize=ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0)
+        {
+            ERR("Failed to get the data set size\n");
+            return NULL;
+        }
+        size = fsize;
+        data = al_malloc(MHR02_ALIGNMENT, size ? size : 1);
+        if(data == NULL)
+        {
+            ERR("Out of memory.\n");
+            return NULL;
+        }
+        if(fread(data, 1, size, f) != size)
+        {
+            ERR("Premature end of data\n");
+            failed = AL_TRUE;
+        }
+    }
+
+    if(!failed && size < MHR02_HEADER_SIZE)
+    {
+        ERR("Premature end of data\n");
+        failed = AL_TRUE;
+    }
+    if(!failed)
+    {
+        rate = ReadLE32(data+8);
+        irSize = ReadLE16(data+12);
+        evCount = data[14];
+        irCount = ReadLE32(data+16);
+        coeffPos = ReadLE32(data+20);
+        delayPos = ReadLE32(data+24);
+        distance = ReadLE32(data+28);
+
+        if(rate != deviceRate)
+        {
+            ERR("HRIR rate does not match device rate: rate=%d (%d)\n",
+                rate, deviceRate);
+            failed = AL_TRUE;
+        }
+        if(irSize < MIN_IR_SIZE || irSize > MAX_IR_SIZE || (irSize%MOD_IR_SIZE))
+        {
+            ERR("Unsupported HRIR size: irSize=%d (%d to %d by %d)\n",
+                irSize, MIN_IR_SIZE, MAX_IR_SIZE, MOD_IR_SIZE);
+            failed = AL_TRUE;
+        }
+        if(evCount < MIN_EV_COUNT || evCount > MAX_EV_COUNT)
+        {
+            ERR("Unsupported elevation count: evCount=%d (%d to %d)\n",
+                evCount, MIN_EV_COUNT, MAX_EV_COUNT);
+            failed = AL_TRUE;
+        }
+        if(irCount > MAX_EV_COUNT*MAX_AZ_COUNT)
+        {
+            ERR("Unsupported HRIR count: irCount=%d\n", irCount);
+            failed = AL_TRUE;
+        }
+        if(distance != 0 && distance < (ALuint)(MIN_HRTF_DISTANCE*1000.0f))
+        {
+            ERR("Unsupported measurement distance: distance=%umm (min %umm)\n",
+                distance, (ALuint)(MIN_HRTF_DISTANCE*1000.0f));
+            failed = AL_TRUE;
+        }
+        if(data[15] != 0)
+        {
+            ERR("Unsupported reserved field: reserved0=%d\n", data[15]);
+            failed = AL_TRUE;
+        }
+    }
+
+    if(!failed)
+    {
+        /* The elevation offsets are 2-byte aligned after the azimuth counts,
+         * and the coefficients must be suitably aligned for the mixer. */
+        evOffsetPos = (MHR02_HEADER_SIZE + evCount + 1) & ~1u;
+        if((coeffPos%MHR02_ALIGNMENT) != 0 || coeffPos < evOffsetPos + evCount*2 ||
+           coeffPos > size || delayPos < coeffPos + (size_t)irCount*irSize*sizeof(ALfloat) ||
+           delayPos > size || size-delayPos < irCount)
+        {
+            ERR("Invalid data offsets: coeffs=%u, delays=%u (size=%lu)\n",
+                coeffPos, delayPos, (unsigned long)size);
+            failed = AL_TRUE;
+        }
+    }
+
+    if(!failed && !IS_LITTLE_ENDIAN)
+    {
+        ALubyte *ptr, tmp;
+
+        ptr = data + evOffsetPos;
+        for(i = 0;i < evCount;i++,ptr+=2)
+        {
+            tmp = ptr[0]; ptr[0] = ptr[1]; ptr[1] = tmp;
+        }
+        ptr = data + coeffPos;
+        for(i = 0;i < irCount*irSize;i++,ptr+=4)
+        {
+            tmp = ptr[0]; ptr[0] = ptr[3]; ptr[3] = tmp;
+            tmp = ptr[1]; ptr[1] = ptr[2]; ptr[2] = tmp;
+        }
+    }
+
+    if(!failed)
+    {
+        azCount = data + MHR02_HEADER_SIZE;
+        evOffset = (const ALushort*)(data + evOffsetPos);
+        delays = data + delayPos;
+
+        count = 0;
+        for(i = 0;i < evCount;i++)
+        {
+            if(azCount[i] < MIN_AZ_COUNT || azCount[i] > MAX_AZ_COUNT)
+            {
+                ERR("Unsupported azimuth count: azCount[%d]=%d (%d to %d)\n",
+                    i, azCount[i], MIN_AZ_COUNT, MAX_AZ_COUNT);
+                failed = AL_TRUE;
+            }
+            if(evOffset[i] != count)
+            {
+                ERR("Invalid evOffset: evOffset[%d]=%d (expected %d)\n",
+                    i, evOffset[i], count);
+                failed = AL_TRUE;
+            }
+            count += azCount[i];
+        }
+        if(count != irCount)
+        {
+            ERR("Invalid HRIR count: irCount=%d (expected %d)\n", irCount, count);
+            failed = AL_TRUE;
+        }
+
+        for(i = 0;i < irCount;i++)
+        {
+            if(delays[i] > maxDelay)
+            {
+                ERR("Invalid delays[%d]: %d (%d)\n", i, delays[i], maxDelay);
+                failed = AL_TRUE;
+            }
+        }
+    }
+
+    if(!failed)
+    {
+        Hrtf = malloc(sizeof(struct Hrtf));
+        if(Hrtf == NULL)
+        {
+            ERR("Out of memory.\n");
+            failed = AL_TRUE;
+        }
+    }
+
+    if(!failed)
+    {
+        Hrtf->sampleRate = rate;
+        Hrtf->irSize = irSize;
+        Hrtf->evCount = evCount;
+        Hrtf->azCount = azCount;
+        Hrtf->evOffset = evOffset;
+        Hrtf->coeffs = (const ALfloat*)(data + coeffPos);
+        Hrtf->delays = delays;
+        Hrtf->data = data;
+        Hrtf->dataSize = size;
+        Hrtf->mapped = mapped;
+        Hrtf->resampled = AL_FALSE;
+        Hrtf->distance = distance ? distance/1000.0f : DEFAULT_HRTF_DISTANCE;
+        Hrtf->cache = NULL;
+        Hrtf->cacheResolution = 0.0f;
+        Hrtf->truncData = NULL;
+        Hrtf->adaptive = AL_FALSE;
+        Hrtf->parent = NULL;
+        Hrtf->next = NULL;
+        return Hrtf;
+    }
+
+    if(mapped)
+        UnmapFileMem(data, size);
+    else
+        al_free(data);
+    return NULL;
+}
+
+
+/* Sets up the data set's HRIR levels. The first level is the full data set,
+ * and each following one truncates the HRIRs of the first to half the length
+ * of the previous, rounded up to a multiple of MOD_IR_SIZE. The last quarter
+ * of each truncated HRIR is faded out with a half-cosine. The HRIRs are
+ * minimum-phase, so most of their energy is in the first few taps. Without
+ * adaptive lengths, only the full data set is used, so every level is left as
+ * the first.
+ *
+ * Note that the truncated HRIRs aren't renormalized. The tails mostly cancel
+ * some of the low frequency response, so truncating raises the bass a little
+ * (about 2.5dB at 100hz for half-length HRIRs with the default data sets),
+ * and scaling to the full HRIR's energy or DC gain was measured to be worse.
+ */
+static void MakeHrtfLevels(struct Hrtf *Hrtf, ALboolean adaptive)
+{
+    ALuint irCount, total, size;
+    ALuint lvl, i, j;
+    ALfloat *coeffs;
+
+    Hrtf->levelSize[0] = Hrtf->irSize;
+    Hrtf->levelCoeffs[0] = Hrtf->coeffs;
+    Hrtf->truncData = NULL;
+    Hrtf->adaptive = AL_FALSE;
+
+    total = 0;
+    for(lvl = 1;lvl < HRTF_IR_LEVELS;lvl++)
+    {
+        size = (Hrtf->levelSize[lvl-1]/2 + MOD_IR_SIZE-1) / MOD_IR_SIZE * MOD_IR_SIZE;
+        Hrtf->levelSize[lvl] = maxu(size, MIN_IR_SIZE);
+        if(adaptive && Hrtf->levelSize[lvl] < Hrtf->levelSize[lvl-1])
+            total += Hrtf->levelSize[lvl];
+    }
+
+    irCount = Hrtf->evOffset[Hrtf->evCount-1] + Hrtf->azCount[Hrtf->evCount-1];
+    coeffs = NULL;
+    if(total > 0)
+    {
+        coeffs = al_calloc(16, sizeof(coeffs[0])*total*irCount);
+        if(!coeffs)
+            ERR("Failed to allocate %u truncated HRIR coefficients\n", total*irCount);
+    }
+    Hrtf->truncData = coeffs;
+    Hrtf->adaptive = adaptive;
+
+    for(lvl = 1;lvl < HRTF_IR_LEVELS;lvl++)
+    {
+        ALuint fade;
+
+        size = Hrtf->levelSize[lvl];
+        if(!coeffs || size >= Hrtf->levelSize[lvl-1])
+        {
+            Hrtf->levelSize[lvl] = Hrtf->levelSize[lvl-1];
+            Hrtf->levelCoeffs[lvl] = Hrtf->levelCoeffs[lvl-1];
+            continue;
+        }
+
+        fade = size / 4;
+        for(i = 0;i < irCount;i++)
+        {
+            const ALfloat *src = &Hrtf->coeffs[i*Hrtf->irSize];
+            ALfloat *dst = &coeffs[i*size];
+
+            for(j = 0;j < size-fade;j++)
+                dst[j] = src[j];
+            for(;j < size;j++)
+                dst[j] = src[j] * (0.5f + 0.5f*cosf(F_PI * (j-(size-fade)+1) / (fade+1)));
+        }
+
+        Hrtf->levelCoeffs[lvl] = coeffs;
+        coeffs += size*irCount;
+    }
+}
+
 static struct Hrtf *LoadHrtf(ALuint deviceRate)
 {
     const char *fnamelist = "default-%r.mhr";
@@ -781,6 +1264,11 @@ static struct Hrtf *LoadHrtf(ALuint deviceRate)
                 TRACE("Detected data set format v1\n");
                 Hrtf = LoadHrtf01(f, deviceRate);
             }
+            else if(memcmp(magic, magicMarker02, sizeof(magicMarker02)) == 0)
+            {
+                TRACE("Detected data set format v2\n");
+                Hrtf = LoadHrtf02(f, deviceRate);
+            }
             else
                 ERR("Invalid header in %s: \"%.8s\"\n", fname, magic);
         }
@@ -790,6 +1278,7 @@ static struct Hrtf *LoadHrtf(ALuint deviceRate)
 
         if(Hrtf)
         {
+            MakeHrtfLevels(Hrtf, AL_FALSE);
             Hrtf->next = LoadedHrtfs;
             LoadedHrtfs = Hrtf;
             TRACE("Loaded HRTF support for format: %s %uhz\n",
@@ -803,44 +1292,421 @@ static struct Hrtf *LoadHrtf(ALuint deviceRate)
     return NULL;
 }
 
-const struct Hrtf *GetHrtf(enum DevFmtChannels chans, ALCuint srate)
+/* The Kaiser-windowed sinc filter used to resample HRIRs, following the design
+ * of makehrtf's resampler. See that utility for the derivations.
+ */
+static double Sinc(double x)
+{
+    if(fabs(x) < 1e-15)
+        return 1.0;
+    return sin(M_PI * x) / (M_PI * x);
+}
+
+static double BesselI_0(double x)
 {
-    if(chans == DevFmtStereo)
+    double term, sum, x2, y, last_sum;
+    int k;
+
+    term = 1.0;
+    sum = 1.0;
+    x2 = x / 2.0;
+    k = 1;
+    do {
+        y = x2 / k;
+        k++;
+        last_sum = sum;
+        term *= y * y;
+        sum += term;
+    } while(sum != last_sum);
+    return sum;
+}
+
+static double Kaiser(double b, double k)
+{
+    if(!(k >= -1.0 && k <= 1.0))
+        return 0.0;
+    return BesselI_0(b * sqrt(1.0 - k*k)) / BesselI_0(b);
+}
+
+static ALuint Gcd(ALuint x, ALuint y)
+{
+    while(y > 0)
+    {
+        ALuint z = y;
+        y = x % y;
+        x = z;
+    }
+    return x;
+}
+
+static ALuint CalcKaiserOrder(double rejection, double transition)
+{
+    double w_t = 2.0 * M_PI * transition;
+    if(rejection > 21.0)
+        return (ALuint)ceil((rejection - 7.95) / (2.285 * w_t));
+    return (ALuint)ceil(5.79 / w_t);
+}
+
+static double CalcKaiserBeta(double rejection)
+{
+    if(rejection > 50.0)
+        return 0.1102 * (rejection - 8.7);
+    if(rejection >= 21.0)
+        return (0.5842 * pow(rejection - 21.0, 0.4)) +
+               (0.07886 * (rejection - 21.0));
+    return 0.0;
+}
+
+static double SincFilter(ALuint l, double b, double gain, double cutoff, ALuint64 i)
+{
+    double x = (double)i - (double)l;
+    return Kaiser(b, x / l) * 2.0 * gain * cutoff * Sinc(2.0 * cutoff * x);
+}
+
+/* Creates a copy of the given data set resampled to a new rate. The polyphase
+ * filter for odd rate ratios can get very long, but since each HRIR is only a
+ * handful of samples, only the taps that actually touch the input are needed.
+ * These are evaluated once as a matrix that maps the input points to each
+ * output point, and applied to every HRIR.
+ *
+ * The resampled HRIRs start a few samples early. The HRIRs are minimum-phase,
+ * so most of their energy is at the start, and cutting off the filter's
+ * ringing before it would noticeably change their response.
+ */
+static struct Hrtf *ResampleHrtf(const struct Hrtf *src, ALuint dstRate)
+{
+    const ALubyte maxDelay = HRTF_HISTORY_LENGTH-1;
+    ALuint irCount, irSize, evOffsetPos, coeffPos, delayPos;
+    ALuint p, q, gcd, l, m, i, j, k;
+    double cutoff, width, beta, gain;
+    struct Hrtf *Hrtf = NULL;
+    ALubyte *data = NULL;
+    double *filter = NULL;
+    ALfloat *coeffs;
+    ALubyte *delays;
+    size_t size;
+    ALuint clipped;
+
+    irCount = src->evOffset[src->evCount-1] + src->azCount[src->evCount-1];
+    /* Keep the HRIRs covering the same length of time. */
+    irSize = (ALuint)ceil((double)src->irSize * dstRate / src->sampleRate);
+    irSize = (irSize+MOD_IR_SIZE-1) / MOD_IR_SIZE * MOD_IR_SIZE + HRIR_RESAMPLE_LEAD;
+    irSize = clampu(irSize, MIN_IR_SIZE, MAX_IR_SIZE);
+
+    gcd = Gcd(src->sampleRate, dstRate);
+    p = dstRate / gcd;
+    q = src->sampleRate / gcd;
+    cutoff = 0.45 / maxu(p, q);
+    width = 0.1 / maxu(p, q);
+    l = CalcKaiserOrder(180.0, width) / 2;
+    beta = CalcKaiserBeta(180.0);
+    m = 2*l + 1;
+    /* The filter's gain of p makes up for the upsampling, which keeps the
+     * sample values. Scaling by the rate ratio (q/p) instead keeps the
+     * impulse responses' frequency response. */
+    gain = (double)q;
+
+    evOffsetPos = (src->evCount + 1) & ~1u;
+    coeffPos = (evOffsetPos + src->evCount*2 + MHR02_ALIGNMENT-1) & ~(MHR02_ALIGNMENT-1);
+    delayPos = coeffPos + irCount*irSize*sizeof(ALfloat);
+    size = delayPos + irCount;
+
+    filter = malloc(sizeof(filter[0]) * irSize * src->irSize);
+    data = al_calloc(MHR02_ALIGNMENT, size);
+    Hrtf = malloc(sizeof(*Hrtf));
+    if(!filter || !data || !Hrtf)
+    {
+        ERR("Out of memory.\n");
+        free(filter);
+        al_free(data);
+        free(Hrtf);
+        return NULL;
+    }
+
+    for(i = 0;i < irSize;i++)
+    {
+        ALuint64 pos = l + (ALuint64)q*i - (ALuint64)q*HRIR_RESAMPLE_LEAD;
+        ALuint64 j_f = pos % p;
+        ALuint64 j_s = pos / p;
+
+        for(j = 0;j < src->irSize;j++)
+        {
+            ALuint64 idx = j_f + p*(j_s - j);
+            if(j <= j_s && idx < m)
+                filter[i*src->irSize + j] = SincFilter(l, beta, gain, cutoff, idx);
+            else
+                filter[i*src->irSize + j] = 0.0;
+        }
+    }
+
+    memcpy(data, src->azCount, src->evCount);
+    memcpy(data+evOffsetPos, src->evOffset, src->evCount*2);
+    coeffs = (ALfloat*)(data + coeffPos);
+    delays = data + delayPos;
+    clipped = 0;
+    for(k = 0;k < irCount;k++)
     {
-        struct Hrtf *Hrtf = LoadedHrtfs;
-        while(Hrtf != NULL)
+        const ALfloat *in = &src->coeffs[k*src->irSize];
+        ALuint delay;
+
+        for(i = 0;i < irSize;i++)
         {
-            if(srate == Hrtf->sampleRate)
-                return Hrtf;
-            Hrtf = Hrtf->next;
+            double r = 0.0;
+            for(j = 0;j < src->irSize;j++)
+                r += filter[i*src->irSize + j] * in[j];
+            coeffs[k*irSize + i] = (ALfloat)r;
         }
 
-        Hrtf = LoadHrtf(srate);
-        if(Hrtf != NULL)
+        delay = (src->delays[k]*dstRate + src->sampleRate/2) / src->sampleRate;
+        if(delay > maxDelay)
+        {
+            delay = maxDelay;
+            clipped++;
+        }
+        delays[k] = delay;
+    }
+    free(filter);
+
+    if(clipped > 0)
+        WARN("Clamped %u HRIR delays to %u samples\n", clipped, maxDelay);
+
+    Hrtf->sampleRate = dstRate;
+    Hrtf->irSize = irSize;
+    Hrtf->evCount = src->evCount;
+    Hrtf->azCount = data;
+    Hrtf->evOffset = (const ALushort*)(data + evOffsetPos);
+    Hrtf->coeffs = coeffs;
+    Hrtf->delays = delays;
+    Hrtf->data = data;
+    Hrtf->dataSize = size;
+    Hrtf->mapped = AL_FALSE;
+    Hrtf->resampled = AL_TRUE;
+    Hrtf->distance = src->distance;
+    Hrtf->cache = NULL;
+    Hrtf->cacheResolution = 0.0f;
+    Hrtf->truncData = NULL;
+    Hrtf->adaptive = AL_FALSE;
+    Hrtf->parent = NULL;
+    Hrtf->next = NULL;
+    return Hrtf;
+}
+
+/* Gets a data set for the given rate. If there's no data set file for it, one
+ * is resampled from the loaded set with the simplest rate ratio (loading the
+ * sets for the common rates first, if needed). Resampled sets are kept with
+ * the loaded ones, so each rate is only resampled once.
+ */
+static struct Hrtf *FindHrtf(ALuint srate)
+{
+    static const ALuint BaseRates[] = { 44100, 48000 };
+    struct Hrtf *Hrtf, *src;
+    ALuint i;
+
+    for(Hrtf = LoadedHrtfs;Hrtf != NULL;Hrtf = Hrtf->next)
+    {
+        if(!Hrtf->parent && Hrtf->sampleRate == srate)
             return Hrtf;
     }
-    ERR("Incompatible format: %s %uhz\n", DevFmtChannelsString(chans), srate);
-    return NULL;
+
+    if((Hrtf=LoadHrtf(srate)) != NULL)
+        return Hrtf;
+
+    for(i = 0;i < COUNTOF(BaseRates);i++)
+    {
+        for(Hrtf = LoadedHrtfs;Hrtf != NULL;Hrtf = Hrtf->next)
+        {
+            if(!Hrtf->parent && Hrtf->sampleRate == BaseRates[i])
+                break;
+        }
+        if(!Hrtf && BaseRates[i] != srate)
+            LoadHrtf(BaseRates[i]);
+    }
+
+    src = NULL;
+    for(Hrtf = LoadedHrtfs;Hrtf != NULL;Hrtf = Hrtf->next)
+    {
+        if(Hrtf->parent || Hrtf->resampled)
+            continue;
+        if(!src || Gcd(Hrtf->sampleRate, srate) > Gcd(src->sampleRate, srate))
+            src = Hrtf;
+    }
+    if(!src)
+        return NULL;
+
+    TRACE("Resampling %uhz HRTF data set to %uhz\n", src->sampleRate, srate);
+    Hrtf = ResampleHrtf(src, srate);
+    if(Hrtf)
+    {
+        MakeHrtfLevels(Hrtf, AL_FALSE);
+        Hrtf->next = LoadedHrtfs;
+        LoadedHrtfs = Hrtf;
+        TRACE("Resampled HRTF support for format: %s %uhz (%u-point HRIRs)\n",
+              DevFmtChannelsString(DevFmtStereo), Hrtf->sampleRate, Hrtf->irSize);
+    }
+    return Hrtf;
 }
 
-ALCboolean FindHrtfFormat(enum DevFmtChannels *chans, ALCuint *srate)
+/* Fills a data set's direction cache, with the given angle between entries
+ * (in degrees).
+ */
+static void MakeHrtfCache(struct Hrtf *Hrtf, ALfloat resolution)
 {
-    const struct Hrtf *hrtf = LoadedHrtfs;
-    while(hrtf != NULL)
+    struct HrtfCache *cache;
+    ALuint evCount, azCount;
+    ALuint ev, az, idx, lvl;
+    ALfloat delays[2];
+    size_t total;
+    size_t size;
+
+    evCount = fastf2u(180.0f/resolution + 0.5f) + 1;
+    azCount = fastf2u(360.0f/resolution + 0.5f);
+    total = 0;
+    for(lvl = 0;lvl < HRTF_IR_LEVELS;lvl++)
     {
-        if(*srate == hrtf->sampleRate)
-            break;
-        hrtf = hrtf->next;
+        if(lvl == 0 || Hrtf->levelCoeffs[lvl] != Hrtf->levelCoeffs[lvl-1])
+            total += evCount*azCount*Hrtf->levelSize[lvl]*2;
+    }
+    size = sizeof(*cache) + sizeof(cache->data[0])*total +
+           sizeof(cache->delays[0])*evCount*azCount*2;
+    cache = al_calloc(16, size);
+    if(!cache)
+    {
+        ERR("Failed to allocate %lu bytes for the HRTF cache\n", (unsigned long)size);
+        return;
     }
 
-    if(hrtf == NULL)
+    cache->evCount = evCount;
+    cache->azCount = azCount;
+    total = 0;
+    for(lvl = 0;lvl < HRTF_IR_LEVELS;lvl++)
+    {
+        if(lvl > 0 && Hrtf->levelCoeffs[lvl] == Hrtf->levelCoeffs[lvl-1])
+            cache->coeffs[lvl] = cache->coeffs[lvl-1];
+        else
+        {
+            cache->coeffs[lvl] = &cache->data[total];
+            total += evCount*azCount*Hrtf->levelSize[lvl]*2;
+        }
+    }
+    cache->delays = &cache->data[total];
+    for(ev = 0;ev < evCount;ev++)
     {
-        hrtf = LoadHrtf(*srate);
-        if(hrtf == NULL) return ALC_FALSE;
+        ALfloat elev = (ALfloat)ev/(ALfloat)(evCount-1)*F_PI - F_PI_2;
+        for(az = 0;az < azCount;az++)
+        {
+            ALfloat azim = (ALfloat)az/(ALfloat)azCount*F_2PI;
+            idx = ev*azCount + az;
+            CalcLerpedHrir(Hrtf, 0, elev, azim, &cache->coeffs[0][idx*Hrtf->irSize*2],
+                           &cache->delays[idx*2]);
+            for(lvl = 1;lvl < HRTF_IR_LEVELS;lvl++)
+            {
+                if(cache->coeffs[lvl] == cache->coeffs[lvl-1])
+                    continue;
+                CalcLerpedHrir(Hrtf, lvl, elev, azim,
+                               &cache->coeffs[lvl][idx*Hrtf->levelSize[lvl]*2], delays);
+            }
+        }
     }
 
+    TRACE("Made %ux%u HRTF cache (%.1f degrees, %lu bytes)\n", evCount, azCount,
+          resolution, (unsigned long)size);
+    Hrtf->cache = cache;
+    Hrtf->cacheResolution = resolution;
+}
+
+/* Gets the variant of a loaded data set with a direction cache of the given
+ * resolution (0 for none) and, for adaptive HRIR lengths, truncated levels,
+ * making it if needed. Variants are kept with the loaded data sets, so devices
+ * using the same settings share them, and they never change while in use.
+ * Falls back to the plain data set on failure.
+ */
+static struct Hrtf *FindHrtfVariant(struct Hrtf *parent, ALfloat resolution, ALboolean adaptive)
+{
+    struct Hrtf *Hrtf;
+
+    if(resolution <= 0.0f && !adaptive)
+        return parent;
+
+    for(Hrtf = LoadedHrtfs;Hrtf != NULL;Hrtf = Hrtf->next)
+    {
+        if(Hrtf->parent == parent && Hrtf->cacheResolution == resolution &&
+           Hrtf->adaptive == adaptive)
+            return Hrtf;
+    }
+
+    Hrtf = malloc(sizeof(*Hrtf));
+    if(!Hrtf)
+    {
+        ERR("Out of memory.\n");
+        return parent;
+    }
+    *Hrtf = *parent;
+    Hrtf->cache = NULL;
+    Hrtf->truncData = NULL;
+    Hrtf->cacheResolution = 0.0f;
+    Hrtf->parent = parent;
+
+    MakeHrtfLevels(Hrtf, adaptive);
+    if(resolution > 0.0f)
+        MakeHrtfCache(Hrtf, resolution);
+    if(Hrtf->adaptive != adaptive || Hrtf->cacheResolution != resolution)
+    {
+        al_free(Hrtf->cache);
+        al_free(Hrtf->truncData);
+        free(Hrtf);
+        return parent;
+    }
+
+    Hrtf->next = LoadedHrtfs;
+    LoadedHrtfs = Hrtf;
+    return Hrtf;
+}
+
+static void InitHrtfLock(void)
+{
+    almtx_init(&HrtfLock, almtx_plain);
+}
+
+const struct Hrtf *GetHrtf(enum DevFmtChannels chans, ALCuint srate, ALboolean adaptive)
+{
+    if(chans == DevFmtStereo)
+    {
+        ALfloat resolution = 0.0f;
+        struct Hrtf *Hrtf;
+
+        if(ConfigValueFloat(NULL, "hrtf-resolution", &resolution) && resolution > 0.0f)
+            resolution = clampf(resolution, 0.5f, 45.0f);
+        else
+            resolution = 0.0f;
+
+        alcall_once(&HrtfLockOnce, InitHrtfLock);
+        almtx_lock(&HrtfLock);
+        Hrtf = FindHrtf(srate);
+        if(Hrtf != NULL)
+            Hrtf = FindHrtfVariant(Hrtf, resolution, adaptive);
+        almtx_unlock(&HrtfLock);
+        if(Hrtf != NULL)
+            return Hrtf;
+    }
+    ERR("Incompatible format: %s %uhz\n", DevFmtChannelsString(chans), srate);
+    return NULL;
+}
+
+/* Since any loaded data set can be resampled for the device, only the channel
+ * configuration needs to change, and the rate is left as-is.
+ */
+ALCboolean FindHrtfFormat(enum DevFmtChannels *chans, ALCuint *srate)
+{
+    ALboolean found;
+
+    alcall_once(&HrtfLockOnce, InitHrtfLock);
+    almtx_lock(&HrtfLock);
+    found = (LoadedHrtfs != NULL || FindHrtf(*srate) != NULL);
+    almtx_unlock(&HrtfLock);
+    if(!found)
+        return ALC_FALSE;
+
     *chans = DevFmtStereo;
-    *srate = hrtf->sampleRate;
     return ALC_TRUE;
 }
 
@@ -851,10 +1717,23 @@ void FreeHrtfs(void)
     while((Hrtf=LoadedHrtfs) != NULL)
     {
         LoadedHrtfs = Hrtf->next;
-        free((void*)Hrtf->azCount);
-        free((void*)Hrtf->evOffset);
-        free((void*)Hrtf->coeffs);
-        free((void*)Hrtf->delays);
+        al_free(Hrtf->cache);
+        al_free(Hrtf->truncData);
+        /* Variants borrow their tables from the parent. */
+        if(!Hrtf->parent)
+        {
+            if(Hrtf->mapped)
+                UnmapFileMem(Hrtf->data, Hrtf->dataSize);
+            else if(Hrtf->data)
+                al_free(Hrtf->data);
+            else
+            {
+                free((void*)Hrtf->azCount);
+                free((void*)Hrtf->evOffset);
+                free((void*)Hrtf->coeffs);
+                free((void*)Hrtf->delays);
+            }
+        }
         free(Hrtf);
     }
 }
@@ -863,3 +1742,8 @@ ALuint GetHrtfIrSize (const struct Hrtf *Hrtf)
 {
     return Hrtf->irSize;
 }
+
+ALuint GetHrtfLevelIrSize(const struct Hrtf *Hrtf, ALuint level)
+{
+    return Hrtf->levelSize[level];
+}
@@ -15,14 +15,21 @@ struct Hrtf;
 #define HRTFDELAY_FRACONE (1<<HRTFDELAY_BITS)
 #define HRTFDELAY_MASK    (HRTFDELAY_FRACONE-1)
 
-const struct Hrtf *GetHrtf(enum DevFmtChannels chans, ALCuint srate);
+/* Number of HRIR lengths available per data set. Level 0 is the full length,
+ * and each following level is half the previous (with a minimum of 8 taps).
+ */
+#define HRTF_IR_LEVELS    (3)
+
+const struct Hrtf *GetHrtf(enum DevFmtChannels chans, ALCuint srate, ALboolean adaptive);
 ALCboolean FindHrtfFormat(enum DevFmtChannels *chans, ALCuint *srate);
 
 void FreeHrtfs(void);
 
 ALuint GetHrtfIrSize(const struct Hrtf *Hrtf);
-void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat dirfact, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays);
-ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat dirfact, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep);
-void GetBFormatHrtfCoeffs(const struct Hrtf *Hrtf, const ALfloat ambi_coeffs[4], ALfloat (*coeffs)[2], ALuint *delays);
+ALuint GetHrtfLevelIrSize(const struct Hrtf *Hrtf, ALuint level);
+ALfloat GetHrtfNearFieldGain(const struct Hrtf *Hrtf, ALfloat distance);
+void GetLerpedHrtfCoeffs(const struct Hrtf *Hrtf, ALuint level, ALfloat elevation, ALfloat azimuth, ALfloat distance, ALfloat dirfact, ALfloat gain, ALfloat (*coeffs)[2], ALuint *delays);
+ALuint GetMovingHrtfCoeffs(const struct Hrtf *Hrtf, ALuint level, ALfloat elevation, ALfloat azimuth, ALfloat distance, ALfloat dirfact, ALfloat gain, ALfloat delta, ALint counter, ALfloat (*coeffs)[2], ALuint *delays, ALfloat (*coeffStep)[2], ALint *delayStep);
+void GetBFormatHrtfCoeffs(const struct Hrtf *Hrtf, const ALfloat *ambi_coeffs, ALfloat (*coeffs)[2], ALuint *delays);
 
 #endif /* ALC_HRTF_H */
@@ -0,0 +1,366 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2014 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "alMain.h"
+#include "alu.h"
+#include "align.h"
+
+#include "mixer_defs.h"
+
+
+/* Partitioned FFT convolution of the device's virtual HRTF channels.
+ *
+ * The virtual channels use fixed coefficients, so rather than running every
+ * tap of every channel through the time-domain mixer, only the first
+ * HRTF_CONV_BLOCK_SIZE taps ("the head") are mixed in the time domain and the
+ * rest are applied here with a uniformly partitioned overlap-save convolver.
+ * The tail starts a full block after the input, so each of its output blocks
+ * only depends on input blocks that are already complete, and it adds no
+ * latency over the time-domain path. The channels' spectra are summed per ear
+ * in the frequency domain, so only one inverse transform is needed per block
+ * regardless of the channel count.
+ */
+
+#define CONV_FFT_SIZE  (HRTF_CONV_BLOCK_SIZE*2)
+#define CONV_BINS      (HRTF_CONV_BLOCK_SIZE+1)
+/* Spectra are padded to a multiple of 4 bins for the SIMD kernels. */
+#define CONV_BINS_PAD  ((CONV_BINS+3)&~3)
+/* The longest tail is the longest HRIR at the longest delay, minus the head
+ * block. */
+#define CONV_MAX_PARTS ((HRTF_HISTORY_LENGTH-1 + HRIR_LENGTH-1) / HRTF_CONV_BLOCK_SIZE)
+
+typedef struct ConvSpectrum {
+    alignas(16) ALfloat Real[CONV_BINS_PAD];
+    alignas(16) ALfloat Imag[CONV_BINS_PAD];
+} ConvSpectrum;
+
+struct HrtfConvolver {
+    ALuint NumChannels;
+    ALuint NumParts;
+
+    /* Position in the current input block, and the delay line's newest
+     * spectrum. */
+    ALuint BlockPos;
+    ALuint Current;
+
+    FftPassFunc FftPass;
+    ComplexMulAddFunc MulAdd;
+
+    /* The previous and current input blocks for each channel. */
+    alignas(16) ALfloat Input[MAX_OUTPUT_CHANNELS][CONV_FFT_SIZE];
+    /* The tail output for the current block. */
+    alignas(16) ALfloat Output[2][HRTF_CONV_BLOCK_SIZE];
+
+    /* Twiddle factors for the forward and inverse transforms. The factors for
+     * the pass combining pairs of length 'half' start at index 'half'. */
+    alignas(16) ALfloat Twiddle[2][2][CONV_FFT_SIZE];
+    ALubyte BitReverse[CONV_FFT_SIZE];
+
+    /* Per-channel, per-partition, per-ear tail spectra, and per-channel
+     * frequency-domain delay lines of input block spectra. */
+    ConvSpectrum Filter[MAX_OUTPUT_CHANNELS][CONV_MAX_PARTS][2];
+    ConvSpectrum History[MAX_OUTPUT_CHANNELS][CONV_MAX_PARTS];
+};
+
+
+static inline FftPassFunc SelectFftPass(void)
+{
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return FftPass_SSE;
+#endif
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return FftPass_Neon;
+#endif
+
+    return FftPass_C;
+}
+
+static inline ComplexMulAddFunc SelectComplexMulAdd(void)
+{
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return ComplexMulAdd_SSE;
+#endif
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return ComplexMulAdd_Neon;
+#endif
+
+    return ComplexMulAdd_C;
+}
+
+
+/* In-place radix-2 complex FFT, on input that's already in bit-reversed order.
+ * The inverse is unscaled. */
+static void FftTransform(const HrtfConvolver *conv, ALfloat *restrict re, ALfloat *restrict im,
+                         ALboolean inverse)
+{
+    const ALfloat (*restrict twiddle)[CONV_FFT_SIZE] = conv->Twiddle[inverse ? 1 : 0];
+    /* The single non-trivial twiddle factor of the second pass, +/-i. */
+    const ALfloat w = twiddle[1][3];
+    ALuint half, i;
+
+    /* The first two passes don't need any multiplies, so do them together. */
+    for(i = 0;i < CONV_FFT_SIZE;i += 4)
+    {
+        ALfloat ar = re[i  ] + re[i+1], ai = im[i  ] + im[i+1];
+        ALfloat br = re[i  ] - re[i+1], bi = im[i  ] - im[i+1];
+        ALfloat cr = re[i+2] + re[i+3], ci = im[i+2] + im[i+3];
+        ALfloat dr = re[i+2] - re[i+3], di = im[i+2] - im[i+3];
+        ALfloat tr = -di*w, ti = dr*w;
+
+        re[i  ] = ar + cr; im[i  ] = ai + ci;
+        re[i+2] = ar - cr; im[i+2] = ai - ci;
+        re[i+1] = br + tr; im[i+1] = bi + ti;
+        re[i+3] = br - tr; im[i+3] = bi - ti;
+    }
+    for(half = 4;half < CONV_FFT_SIZE;half <<= 1)
+        conv->FftPass(re, im, &twiddle[0][half], &twiddle[1][half], half, CONV_FFT_SIZE);
+}
+
+/* Transforms one time-domain partition (zero-padded to the FFT size) and
+ * stores the non-redundant half of its spectrum, scaled for the unscaled
+ * inverse. */
+static void ConvTransformPartition(const HrtfConvolver *conv, const ALfloat *partition, ConvSpectrum *spectrum)
+{
+    alignas(16) ALfloat re[CONV_FFT_SIZE];
+    alignas(16) ALfloat im[CONV_FFT_SIZE];
+    ALuint i;
+
+    for(i = 0;i < CONV_FFT_SIZE;i++)
+    {
+        re[conv->BitReverse[i]] = (i < HRTF_CONV_BLOCK_SIZE) ? partition[i] : 0.0f;
+        im[i] = 0.0f;
+    }
+    FftTransform(conv, re, im, AL_FALSE);
+
+    for(i = 0;i < CONV_BINS;i++)
+    {
+        spectrum->Real[i] = re[i] * (1.0f/CONV_FFT_SIZE);
+        spectrum->Imag[i] = im[i] * (1.0f/CONV_FFT_SIZE);
+    }
+}
+
+
+HrtfConvolver *CreateHrtfConvolver(const HrtfParams *params, ALuint numchans, ALuint irsize)
+{
+    ALfloat tail[(CONV_MAX_PARTS+1) * HRTF_CONV_BLOCK_SIZE];
+    HrtfConvolver *conv;
+    ALuint maxdelay;
+    ALuint c, i, j;
+
+    if(irsize <= HRTF_CONV_BLOCK_SIZE || numchans == 0 || numchans > MAX_OUTPUT_CHANNELS)
+        return NULL;
+
+    conv = al_calloc(16, sizeof(*conv));
+    if(!conv) return NULL;
+
+    conv->FftPass = SelectFftPass();
+    conv->MulAdd = SelectComplexMulAdd();
+
+    for(i = 1;i < CONV_FFT_SIZE;i <<= 1)
+    {
+        for(j = 0;j < i;j++)
+        {
+            ALdouble phase = F_PI * j / i;
+            conv->Twiddle[0][0][i+j] = (ALfloat)cos(phase);
+            conv->Twiddle[0][1][i+j] = (ALfloat)-sin(phase);
+            conv->Twiddle[1][0][i+j] = (ALfloat)cos(phase);
+            conv->Twiddle[1][1][i+j] = (ALfloat)sin(phase);
+        }
+    }
+    for(i = 0;i < CONV_FFT_SIZE;i++)
+    {
+        ALuint rev = 0;
+        for(j = 1;j < CONV_FFT_SIZE;j <<= 1)
+        {
+            rev <<= 1;
+            if((i&j)) rev |= 1;
+        }
+        conv->BitReverse[i] = (ALubyte)rev;
+    }
+
+    maxdelay = 0;
+    for(c = 0;c < numchans;c++)
+    {
+        maxdelay = maxu(maxdelay, params[c].Delay[0]>>HRTFDELAY_BITS);
+        maxdelay = maxu(maxdelay, params[c].Delay[1]>>HRTFDELAY_BITS);
+    }
+    conv->NumChannels = numchans;
+    conv->NumParts = minu((maxdelay + irsize-1) / HRTF_CONV_BLOCK_SIZE, CONV_MAX_PARTS);
+
+    /* Lay out each ear's tail taps at their total delay (including the
+     * channel's onset delay), then split it into block-sized partitions
+     * starting one block in. The head block is left to the time-domain mixer.
+     */
+    for(c = 0;c < numchans;c++)
+    {
+        for(i = 0;i < 2;i++)
+        {
+            ALuint delay = params[c].Delay[i]>>HRTFDELAY_BITS;
+
+            memset(tail, 0, sizeof(tail));
+            for(j = HRTF_CONV_BLOCK_SIZE;j < irsize;j++)
+                tail[delay+j] = params[c].Coeffs[j][i];
+
+            for(j = 0;j < conv->NumParts;j++)
+                ConvTransformPartition(conv, &tail[(j+1)*HRTF_CONV_BLOCK_SIZE],
+                                       &conv->Filter[c][j][i]);
+        }
+    }
+
+    return conv;
+}
+
+void DestroyHrtfConvolver(HrtfConvolver *conv)
+{
+    al_free(conv);
+}
+
+
+/* Called once a full input block is available. Adds the block's spectrum to
+ * the delay lines and computes the tail output for the next block. */
+static void ConvProcessBlock(HrtfConvolver *conv)
+{
+    const ALuint numparts = conv->NumParts;
+    alignas(16) ALfloat re[CONV_FFT_SIZE];
+    alignas(16) ALfloat im[CONV_FFT_SIZE];
+    ConvSpectrum accum[2];
+    ALuint c, i, j, k;
+
+    conv->Current = (conv->Current+1) % numparts;
+
+    /* Transform the input channels two at a time, packing one in the real and
+     * one in the imaginary part, and separate the two spectra using their
+     * conjugate symmetry. */
+    for(c = 0;c < conv->NumChannels;c += 2)
+    {
+        ALfloat *restrict in0 = conv->Input[c];
+        ALfloat *restrict in1 = (c+1 < conv->NumChannels) ? conv->Input[c+1] : NULL;
+        ConvSpectrum *restrict spec0 = &conv->History[c][conv->Current];
+
+        for(i = 0;i < CONV_FFT_SIZE;i++)
+        {
+            re[conv->BitReverse[i]] = in0[i];
+            im[conv->BitReverse[i]] = in1 ? in1[i] : 0.0f;
+        }
+        FftTransform(conv, re, im, AL_FALSE);
+
+        if(!in1)
+        {
+            for(k = 0;k < CONV_BINS;k++)
+            {
+                spec0->Real[k] = re[k];
+                spec0->Imag[k] = im[k];
+            }
+        }
+        else
+        {
+            ConvSpectrum *restrict spec1 = &conv->History[c+1][conv->Current];
+
+            spec0->Real[0] = re[0]; spec0->Imag[0] = 0.0f;
+            spec1->Real[0] = im[0]; spec1->Imag[0] = 0.0f;
+            for(k = 1;k < CONV_BINS;k++)
+            {
+                const ALuint n = CONV_FFT_SIZE - k;
+
+                spec0->Real[k] = (re[k] + re[n]) * 0.5f;
+                spec0->Imag[k] = (im[k] - im[n]) * 0.5f;
+                spec1->Real[k] = (im[k] + im[n]) * 0.5f;
+                spec1->Imag[k] = (re[n] - re[k]) * 0.5f;
+            }
+            memcpy(in1, in1+HRTF_CONV_BLOCK_SIZE, HRTF_CONV_BLOCK_SIZE*sizeof(in1[0]));
+        }
+        memcpy(in0, in0+HRTF_CONV_BLOCK_SIZE, HRTF_CONV_BLOCK_SIZE*sizeof(in0[0]));
+    }
+
+    /* Multiply-accumulate every channel's delay line with its filter
+     * partitions. Partition j applies to the spectrum from j blocks ago. */
+    memset(accum, 0, sizeof(accum));
+    for(c = 0;c < conv->NumChannels;c++)
+    {
+        for(j = 0;j < numparts;j++)
+        {
+            const ConvSpectrum *spec = &conv->History[c][(conv->Current+numparts-j) % numparts];
+            for(i = 0;i < 2;i++)
+            {
+                const ConvSpectrum *filter = &conv->Filter[c][j][i];
+                conv->MulAdd(accum[i].Real, accum[i].Imag, filter->Real, filter->Imag,
+                             spec->Real, spec->Imag, CONV_BINS_PAD);
+            }
+        }
+    }
+
+    /* Both ears' outputs are real, so transform them back together with the
+     * left in the real part and the right in the imaginary part. */
+    for(k = 0;k < CONV_BINS;k++)
+    {
+        re[conv->BitReverse[k]] = accum[0].Real[k] - accum[1].Imag[k];
+        im[conv->BitReverse[k]] = accum[0].Imag[k] + accum[1].Real[k];
+    }
+    for(;k < CONV_FFT_SIZE;k++)
+    {
+        const ALuint n = CONV_FFT_SIZE - k;
+        re[conv->BitReverse[k]] = accum[0].Real[n] + accum[1].Imag[n];
+        im[conv->BitReverse[k]] = accum[1].Real[n] - accum[0].Imag[n];
+    }
+    FftTransform(conv, re, im, AL_TRUE);
+
+    /* Overlap-save: the second half holds the valid (unaliased) output. */
+    memcpy(conv->Output[0], &re[HRTF_CONV_BLOCK_SIZE], HRTF_CONV_BLOCK_SIZE*sizeof(ALfloat));
+    memcpy(conv->Output[1], &im[HRTF_CONV_BLOCK_SIZE], HRTF_CONV_BLOCK_SIZE*sizeof(ALfloat));
+}
+
+void MixHrtfConvolver(HrtfConvolver *conv, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+                      ALfloat (*restrict InBuffer)[BUFFERSIZE], ALuint BufferSize)
+{
+    ALuint pos = 0;
+    ALuint c, i;
+
+    while(pos < BufferSize)
+    {
+        const ALuint blockpos = conv->BlockPos;
+        ALuint todo = minu(HRTF_CONV_BLOCK_SIZE - blockpos, BufferSize - pos);
+
+        for(c = 0;c < conv->NumChannels;c++)
+            memcpy(&conv->Input[c][HRTF_CONV_BLOCK_SIZE + blockpos], &InBuffer[c][pos],
+                   todo*sizeof(ALfloat));
+        for(i = 0;i < todo;i++)
+        {
+            OutBuffer[0][pos+i] += conv->Output[0][blockpos+i];
+            OutBuffer[1][pos+i] += conv->Output[1][blockpos+i];
+        }
+
+        pos += todo;
+        conv->BlockPos += todo;
+        if(conv->BlockPos == HRTF_CONV_BLOCK_SIZE)
+        {
+            ConvProcessBlock(conv);
+            conv->BlockPos = 0;
+        }
+    }
+}
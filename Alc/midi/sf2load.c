@@ -1107,7 +1107,7 @@ ALboolean loadSf2(Reader *stream, ALsoundfont *soundfont, ALCcontext *context)
         if(!buffer)
             SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, error);
         /* Sample rate is unimportant, the individual fontsounds will specify it. */
-        if((err=LoadData(buffer, 22050, AL_MONO16_SOFT, smpl.mSize/2, UserFmtMono, UserFmtShort, NULL, 1, AL_FALSE)) != AL_NO_ERROR)
+        if((err=LoadData(buffer, 22050, AL_MONO16_SOFT, smpl.mSize/2, UserFmtMono, UserFmtShort, NULL, 1, AL_FALSE, NULL)) != AL_NO_ERROR)
             SET_ERROR_AND_GOTO(context, err, error);
 
         ptr = buffer->data;
@@ -34,11 +34,13 @@
 #include "alListener.h"
 #include "alAuxEffectSlot.h"
 #include "alu.h"
+#include "sample_cvt.h"
 
 #include "mixer_defs.h"
 
 
 extern inline void InitiatePositionArrays(ALuint frac, ALuint increment, ALuint *frac_arr, ALuint *pos_arr, ALuint size);
+extern inline void CalcFilterBlockCoeffs(const ALfilterState *filter, ALfloat (*restrict coeffs)[4]);
 
 alignas(16) ALfloat CubicLUT[FRACTIONONE][4];
 
@@ -86,6 +88,20 @@ static inline MixerFunc SelectMixer(void)
     return Mix_C;
 }
 
+static inline FilterBandPassFunc SelectBandPass(void)
+{
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return ALfilterState_processBandPassSSE;
+#endif
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return ALfilterState_processBandPassNeon;
+#endif
+
+    return ALfilterState_processBandPassC;
+}
+
 static inline ResamplerFunc SelectResampler(enum Resampler resampler)
 {
     switch(resampler)
@@ -144,19 +160,50 @@ DECL_TEMPLATE(ALfloat)
 
 #undef DECL_TEMPLATE
 
-static void LoadSamples(ALfloat *dst, const ALvoid *src, ALuint srcstep, enum FmtType srctype, ALuint samples)
+/* Loads samples of one channel from the buffer, starting at the given sample
+ * frame. Compressed data is decoded from the start of the block holding the
+ * first sample, so it can be loaded from any position.
+ */
+static void LoadSamples(ALfloat *dst, const ALbuffer *buffer, ALuint chan, ALuint pos, ALuint samples)
 {
-    switch(srctype)
+    const ALuint numchans = ChannelsFromFmt(buffer->FmtChannels);
+    const ALubyte *src = buffer->data;
+
+    switch(buffer->FmtType)
     {
         case FmtByte:
-            Load_ALbyte(dst, src, srcstep, samples);
+            Load_ALbyte(dst, (const ALbyte*)src + pos*numchans + chan, numchans, samples);
             break;
         case FmtShort:
-            Load_ALshort(dst, src, srcstep, samples);
+            Load_ALshort(dst, (const ALshort*)src + pos*numchans + chan, numchans, samples);
             break;
         case FmtFloat:
-            Load_ALfloat(dst, src, srcstep, samples);
+            Load_ALfloat(dst, (const ALfloat*)src + pos*numchans + chan, numchans, samples);
+            break;
+
+        case FmtIMA4:
+        case FmtMSADPCM:
+        {
+            const ALuint align = buffer->OriginalAlign;
+            const ALuint blocksize = BlockSizeFromFmt(buffer->FmtChannels, buffer->FmtType, align);
+            ALuint skip = pos % align;
+
+            src += pos/align * blocksize;
+            while(samples > 0)
+            {
+                ALuint todo = minu(samples, align-skip);
+                if(buffer->FmtType == FmtIMA4)
+                    DecodeIMA4Samples(dst, src, chan, numchans, skip, todo);
+                else
+                    DecodeMSADPCMSamples(dst, src, chan, numchans, skip, todo);
+                dst += todo;
+                samples -= todo;
+
+                src += blocksize;
+                skip = 0;
+            }
             break;
+        }
     }
 }
 
@@ -168,11 +215,19 @@ static inline void SilenceSamples(ALfloat *dst, ALuint samples)
 }
 
 
+static inline void CopyFilterHistory(ALfilterState *restrict dst, const ALfilterState *restrict src)
+{
+    dst->x[0] = src->x[0];
+    dst->x[1] = src->x[1];
+    dst->y[0] = src->y[0];
+    dst->y[1] = src->y[1];
+}
+
 static const ALfloat *DoFilters(ALfilterState *lpfilter, ALfilterState *hpfilter,
                                 ALfloat *restrict dst, const ALfloat *restrict src,
-                                ALuint numsamples, enum ActiveFilters type)
+                                ALuint numsamples, enum ActiveFilters type,
+                                FilterBandPassFunc BandPass)
 {
-    ALuint i;
     switch(type)
     {
         case AF_None:
@@ -186,15 +241,7 @@ static const ALfloat *DoFilters(ALfilterState *lpfilter, ALfilterState *hpfilter
             return dst;
 
         case AF_BandPass:
-            for(i = 0;i < numsamples;)
-            {
-                ALfloat temp[256];
-                ALuint todo = minu(256, numsamples-i);
-
-                ALfilterState_process(lpfilter, temp, src+i, todo);
-                ALfilterState_process(hpfilter, dst+i, temp, todo);
-                i += todo;
-            }
+            BandPass(lpfilter, hpfilter, dst, src, numsamples);
             return dst;
     }
     return src;
@@ -204,6 +251,7 @@ static const ALfloat *DoFilters(ALfilterState *lpfilter, ALfilterState *hpfilter
 ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint SamplesToDo)
 {
     MixerFunc Mix;
+    FilterBandPassFunc BandPass;
     HrtfMixerFunc HrtfMix;
     ResamplerFunc Resample;
     ALbufferlistitem *BufferListItem;
@@ -215,9 +263,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
     ALenum State;
     ALuint OutPos;
     ALuint NumChannels;
-    ALuint SampleSize;
     ALint64 DataSize64;
-    ALuint IrSize;
     ALuint chan, j;
 
     /* Get source info */
@@ -228,7 +274,6 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
     Looping        = Source->Looping;
     Resampler      = Source->Resampler;
     NumChannels    = Source->NumChannels;
-    SampleSize     = Source->SampleSize;
     increment      = voice->Step;
 
     while(BufferListItem)
@@ -244,9 +289,8 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
     }
     assert(BufferListItem != NULL);
 
-    IrSize = (Device->Hrtf ? GetHrtfIrSize(Device->Hrtf) : 0);
-
     Mix = SelectMixer();
+    BandPass = SelectBandPass();
     HrtfMix = SelectHrtfMixer();
     Resample = ((increment == FRACTIONONE && DataPosFrac == 0) ?
                 Resample_copy32_C : SelectResampler(Resampler));
@@ -283,19 +327,17 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
         for(chan = 0;chan < NumChannels;chan++)
         {
             const ALfloat *ResampledData;
+            const ALfloat *DryFiltered;
             ALfloat *SrcData = Device->SourceData;
             ALuint SrcDataSize = 0;
 
             if(Source->SourceType == AL_STATIC)
             {
-                const ALbuffer *ALBuffer = BufferListItem->buffer;
-                const ALubyte *Data = ALBuffer->data;
+                const ALbuffer *ALBuffer = Source->Preresampled ? Source->Preresampled :
+                                           BufferListItem->buffer;
                 ALuint DataSize;
                 ALuint pos;
 
-                /* Offset to current channel */
-                Data += chan*SampleSize;
-
                 /* If current pos is beyond the loop range, do not loop */
                 if(Looping == AL_FALSE || DataPosInt >= (ALuint)ALBuffer->LoopEnd)
                 {
@@ -318,8 +360,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                      * rest of the temp buffer */
                     DataSize = minu(SrcBufferSize - SrcDataSize, ALBuffer->SampleLen - pos);
 
-                    LoadSamples(&SrcData[SrcDataSize], &Data[pos * NumChannels*SampleSize],
-                                NumChannels, ALBuffer->FmtType, DataSize);
+                    LoadSamples(&SrcData[SrcDataSize], ALBuffer, chan, pos, DataSize);
                     SrcDataSize += DataSize;
 
                     SilenceSamples(&SrcData[SrcDataSize], SrcBufferSize - SrcDataSize);
@@ -356,8 +397,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                     DataSize = LoopEnd - pos;
                     DataSize = minu(SrcBufferSize - SrcDataSize, DataSize);
 
-                    LoadSamples(&SrcData[SrcDataSize], &Data[pos * NumChannels*SampleSize],
-                                NumChannels, ALBuffer->FmtType, DataSize);
+                    LoadSamples(&SrcData[SrcDataSize], ALBuffer, chan, pos, DataSize);
                     SrcDataSize += DataSize;
 
                     DataSize = LoopEnd-LoopStart;
@@ -365,8 +405,7 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                     {
                         DataSize = minu(SrcBufferSize - SrcDataSize, DataSize);
 
-                        LoadSamples(&SrcData[SrcDataSize], &Data[LoopStart * NumChannels*SampleSize],
-                                    NumChannels, ALBuffer->FmtType, DataSize);
+                        LoadSamples(&SrcData[SrcDataSize], ALBuffer, chan, LoopStart, DataSize);
                         SrcDataSize += DataSize;
                     }
                 }
@@ -420,7 +459,6 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                     const ALbuffer *ALBuffer;
                     if((ALBuffer=tmpiter->buffer) != NULL)
                     {
-                        const ALubyte *Data = ALBuffer->data;
                         ALuint DataSize = ALBuffer->SampleLen;
 
                         /* Skip the data already played */
@@ -428,13 +466,11 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                             pos -= DataSize;
                         else
                         {
-                            Data += (pos*NumChannels + chan)*SampleSize;
                             DataSize -= pos;
-                            pos -= pos;
 
                             DataSize = minu(SrcBufferSize - SrcDataSize, DataSize);
-                            LoadSamples(&SrcData[SrcDataSize], Data, NumChannels,
-                                        ALBuffer->FmtType, DataSize);
+                            LoadSamples(&SrcData[SrcDataSize], ALBuffer, chan, pos, DataSize);
+                            pos -= pos;
                             SrcDataSize += DataSize;
                         }
                     }
@@ -458,24 +494,20 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
                 DirectParams *parms = &voice->Direct;
                 const ALfloat *samples;
 
-                samples = DoFilters(
+                samples = DryFiltered = DoFilters(
                     &parms->Filters[chan].LowPass, &parms->Filters[chan].HighPass,
                     Device->FilteredData, ResampledData, DstBufferSize,
-                    parms->Filters[chan].ActiveType
+                    parms->Filters[chan].ActiveType, BandPass
                 );
                 if(!voice->IsHrtf)
                     Mix(samples, parms->OutChannels, parms->OutBuffer, parms->Gains[chan],
                         parms->Counter, OutPos, DstBufferSize);
                 else
                     HrtfMix(parms->OutBuffer, samples, parms->Counter, voice->Offset,
-                            OutPos, IrSize, &parms->Hrtf[chan].Params,
+                            OutPos, parms->IrSize, &parms->Hrtf[chan].Params,
                             &parms->Hrtf[chan].State, DstBufferSize);
             }
 
-            /* Only the first channel for B-Format buffers (W channel) goes to
-             * the send paths. */
-            if(chan > 0 && isbformat)
-                continue;
             for(j = 0;j < Device->NumAuxSends;j++)
             {
                 SendParams *parms = &voice->Send[j];
@@ -483,13 +515,33 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
 
                 if(!parms->OutBuffer)
                     continue;
+                /* Only the first channel for B-Format buffers (W channel) goes
+                 * to mono sends. */
+                if(chan > 0 && isbformat && parms->OutChannels == 1)
+                    continue;
 
-                samples = DoFilters(
-                    &parms->Filters[chan].LowPass, &parms->Filters[chan].HighPass,
-                    Device->FilteredData, ResampledData, DstBufferSize,
-                    parms->Filters[chan].ActiveType
-                );
-                Mix(samples, 1, parms->OutBuffer, &parms->Gain,
+                if(parms->Filters[chan].SameAsDirect && DryFiltered)
+                {
+                    /* Reuse the direct path's output, and keep the filters in
+                     * the same state as if they had run. */
+                    const DirectParams *direct = &voice->Direct;
+                    samples = DryFiltered;
+                    CopyFilterHistory(&parms->Filters[chan].LowPass, &direct->Filters[chan].LowPass);
+                    CopyFilterHistory(&parms->Filters[chan].HighPass, &direct->Filters[chan].HighPass);
+                }
+                else
+                {
+                    samples = DoFilters(
+                        &parms->Filters[chan].LowPass, &parms->Filters[chan].HighPass,
+                        Device->FilteredData, ResampledData, DstBufferSize,
+                        parms->Filters[chan].ActiveType, BandPass
+                    );
+                    /* The direct path's output is gone once something else is
+                     * filtered into the same buffer. */
+                    if(samples == Device->FilteredData)
+                        DryFiltered = NULL;
+                }
+                Mix(samples, parms->OutChannels, parms->OutBuffer, parms->Gains[chan],
                     parms->Counter, OutPos, DstBufferSize);
             }
         }
@@ -514,6 +566,8 @@ ALvoid MixSource(ALvoice *voice, ALsource *Source, ALCdevice *Device, ALuint Sam
 
             if((ALBuffer=BufferListItem->buffer) != NULL)
             {
+                if(Source->Preresampled)
+                    ALBuffer = Source->Preresampled;
                 DataSize = ALBuffer->SampleLen;
                 LoopStart = ALBuffer->LoopStart;
                 LoopEnd = ALBuffer->LoopEnd;
@@ -58,6 +58,16 @@ void ALfilterState_processC(ALfilterState *filter, ALfloat *restrict dst, const
         *(dst++) = ALfilterState_processSingle(filter, *(src++));
 }
 
+void ALfilterState_processBandPassC(ALfilterState *lpfilter, ALfilterState *hpfilter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples)
+{
+    ALuint i;
+    for(i = 0;i < numsamples;i++)
+    {
+        ALfloat smp = ALfilterState_processSingle(lpfilter, *(src++));
+        *(dst++) = ALfilterState_processSingle(hpfilter, smp);
+    }
+}
+
 
 static inline void SetupCoeffs(ALfloat (*restrict OutCoeffs)[2],
                                const HrtfParams *hrtfparams,
@@ -136,3 +146,39 @@ void Mix_C(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)[B
             OutBuffer[c][OutPos+pos] += data[pos]*gain;
     }
 }
+
+
+void FftPass_C(ALfloat *restrict re, ALfloat *restrict im, const ALfloat *restrict twr,
+               const ALfloat *restrict twi, ALuint half, ALuint size)
+{
+    ALuint i, k;
+
+    for(i = 0;i < size;i += half*2)
+    {
+        for(k = 0;k < half;k++)
+        {
+            const ALuint a = i + k;
+            const ALuint b = a + half;
+            ALfloat tr = re[b]*twr[k] - im[b]*twi[k];
+            ALfloat ti = re[b]*twi[k] + im[b]*twr[k];
+
+            re[b] = re[a] - tr;
+            im[b] = im[a] - ti;
+            re[a] += tr;
+            im[a] += ti;
+        }
+    }
+}
+
+void ComplexMulAdd_C(ALfloat *restrict dstr, ALfloat *restrict dsti,
+                     const ALfloat *restrict ar, const ALfloat *restrict ai,
+                     const ALfloat *restrict br, const ALfloat *restrict bi, ALuint count)
+{
+    ALuint i;
+
+    for(i = 0;i < count;i++)
+    {
+        dstr[i] += ar[i]*br[i] - ai[i]*bi[i];
+        dsti[i] += ar[i]*bi[i] + ai[i]*br[i];
+    }
+}
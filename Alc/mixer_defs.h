@@ -26,6 +26,13 @@ void MixHrtf_C(ALfloat (*restrict OutBuffer)[BUFFERSIZE], const ALfloat *data,
 void Mix_C(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
                  struct MixGains *Gains, ALuint Counter, ALuint OutPos, ALuint BufferSize);
 
+/* C convolution kernels */
+void FftPass_C(ALfloat *restrict re, ALfloat *restrict im, const ALfloat *restrict twr,
+              const ALfloat *restrict twi, ALuint half, ALuint size);
+void ComplexMulAdd_C(ALfloat *restrict dstr, ALfloat *restrict dsti,
+                    const ALfloat *restrict ar, const ALfloat *restrict ai,
+                    const ALfloat *restrict br, const ALfloat *restrict bi, ALuint count);
+
 /* SSE mixers */
 void MixHrtf_SSE(ALfloat (*restrict OutBuffer)[BUFFERSIZE], const ALfloat *data,
                  ALuint Counter, ALuint Offset, ALuint OutPos, const ALuint IrSize,
@@ -34,6 +41,45 @@ void MixHrtf_SSE(ALfloat (*restrict OutBuffer)[BUFFERSIZE], const ALfloat *data,
 void Mix_SSE(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
              struct MixGains *Gains, ALuint Counter, ALuint OutPos, ALuint BufferSize);
 
+/* SSE convolution kernels */
+void FftPass_SSE(ALfloat *restrict re, ALfloat *restrict im, const ALfloat *restrict twr,
+                const ALfloat *restrict twi, ALuint half, ALuint size);
+void ComplexMulAdd_SSE(ALfloat *restrict dstr, ALfloat *restrict dsti,
+                      const ALfloat *restrict ar, const ALfloat *restrict ai,
+                      const ALfloat *restrict br, const ALfloat *restrict bi, ALuint count);
+
+/* Calculates the coefficients for running a biquad filter four samples at a
+ * time. Each output of a block is a weighted sum of the two previous inputs,
+ * the four new inputs, and the two previous outputs, in that order; coeffs[j]
+ * holds the weights of input j for each of the four outputs.
+ */
+inline void CalcFilterBlockCoeffs(const ALfilterState *filter, ALfloat (*restrict coeffs)[4])
+{
+    ALuint j, k;
+
+    /* The filter is linear, so running it over each input alone gives its
+     * weight on the outputs. */
+    for(j = 0;j < 8;j++)
+    {
+        ALfloat x[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        ALfloat y[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+        if(j < 6)
+            x[j] = 1.0f;
+        else
+            y[j-6] = 1.0f;
+        for(k = 0;k < 4;k++)
+        {
+            y[k+2] = filter->b[0] * x[k+2] +
+                     filter->b[1] * x[k+1] +
+                     filter->b[2] * x[k] -
+                     filter->a[1] * y[k+1] -
+                     filter->a[2] * y[k];
+            coeffs[j][k] = y[k+2];
+        }
+    }
+}
+
 /* SSE resamplers */
 inline void InitiatePositionArrays(ALuint frac, ALuint increment, ALuint *frac_arr, ALuint *pos_arr, ALuint size)
 {
@@ -67,4 +113,11 @@ void MixHrtf_Neon(ALfloat (*restrict OutBuffer)[BUFFERSIZE], const ALfloat *data
 void Mix_Neon(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
               struct MixGains *Gains, ALuint Counter, ALuint OutPos, ALuint BufferSize);
 
+/* Neon convolution kernels */
+void FftPass_Neon(ALfloat *restrict re, ALfloat *restrict im, const ALfloat *restrict twr,
+                 const ALfloat *restrict twi, ALuint half, ALuint size);
+void ComplexMulAdd_Neon(ALfloat *restrict dstr, ALfloat *restrict dsti,
+                       const ALfloat *restrict ar, const ALfloat *restrict ai,
+                       const ALfloat *restrict br, const ALfloat *restrict bi, ALuint count);
+
 #endif /* MIXER_DEFS_H */
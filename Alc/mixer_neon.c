@@ -135,3 +135,156 @@ void Mix_Neon(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer
             OutBuffer[c][OutPos+pos] += data[pos]*gain;
     }
 }
+
+
+/* Runs one block of four samples through a biquad filter, given the block
+ * coefficients from CalcFilterBlockCoeffs and the filter history, each
+ * broadcast across a vector. The history is updated for the next block.
+ */
+static inline float32x4_t FilterBlock(const float32x4_t *restrict coeffs, const float32x4_t in,
+                                      float32x4_t *restrict x1, float32x4_t *restrict x0,
+                                      float32x4_t *restrict y1, float32x4_t *restrict y0)
+{
+    float32x4_t out;
+
+    out = vmulq_f32(coeffs[0], *x1);
+    out = vmlaq_f32(out, coeffs[1], *x0);
+    out = vmlaq_f32(out, coeffs[2], vdupq_n_f32(vgetq_lane_f32(in, 0)));
+    out = vmlaq_f32(out, coeffs[3], vdupq_n_f32(vgetq_lane_f32(in, 1)));
+    out = vmlaq_f32(out, coeffs[4], vdupq_n_f32(vgetq_lane_f32(in, 2)));
+    out = vmlaq_f32(out, coeffs[5], vdupq_n_f32(vgetq_lane_f32(in, 3)));
+    out = vmlaq_f32(out, coeffs[6], *y1);
+    out = vmlaq_f32(out, coeffs[7], *y0);
+
+    *x1 = vdupq_n_f32(vgetq_lane_f32(in, 2));
+    *x0 = vdupq_n_f32(vgetq_lane_f32(in, 3));
+    *y1 = vdupq_n_f32(vgetq_lane_f32(out, 2));
+    *y0 = vdupq_n_f32(vgetq_lane_f32(out, 3));
+    return out;
+}
+
+static inline void LoadFilterBlock(const ALfilterState *filter, float32x4_t *restrict coeffs,
+                                   float32x4_t *restrict x1, float32x4_t *restrict x0,
+                                   float32x4_t *restrict y1, float32x4_t *restrict y0)
+{
+    alignas(16) ALfloat blockcoeffs[8][4];
+    ALuint j;
+
+    CalcFilterBlockCoeffs(filter, blockcoeffs);
+    for(j = 0;j < 8;j++)
+        coeffs[j] = vld1q_f32(blockcoeffs[j]);
+    *x1 = vdupq_n_f32(filter->x[1]);
+    *x0 = vdupq_n_f32(filter->x[0]);
+    *y1 = vdupq_n_f32(filter->y[1]);
+    *y0 = vdupq_n_f32(filter->y[0]);
+}
+
+static inline void StoreFilterBlock(ALfilterState *filter, float32x4_t x1, float32x4_t x0,
+                                    float32x4_t y1, float32x4_t y0)
+{
+    filter->x[1] = vgetq_lane_f32(x1, 0);
+    filter->x[0] = vgetq_lane_f32(x0, 0);
+    filter->y[1] = vgetq_lane_f32(y1, 0);
+    filter->y[0] = vgetq_lane_f32(y0, 0);
+}
+
+void ALfilterState_processNeon(ALfilterState *filter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples)
+{
+    ALuint i = 0;
+
+    if(numsamples >= 4)
+    {
+        float32x4_t coeffs[8], x1, x0, y1, y0;
+
+        LoadFilterBlock(filter, coeffs, &x1, &x0, &y1, &y0);
+        for(;numsamples-i > 3;i += 4)
+        {
+            const float32x4_t in = vld1q_f32(&src[i]);
+            vst1q_f32(&dst[i], FilterBlock(coeffs, in, &x1, &x0, &y1, &y0));
+        }
+        StoreFilterBlock(filter, x1, x0, y1, y0);
+    }
+    for(;i < numsamples;i++)
+        dst[i] = ALfilterState_processSingle(filter, src[i]);
+}
+
+void ALfilterState_processBandPassNeon(ALfilterState *lpfilter, ALfilterState *hpfilter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples)
+{
+    ALuint i = 0;
+
+    if(numsamples >= 4)
+    {
+        float32x4_t lpcoeffs[8], lpx1, lpx0, lpy1, lpy0;
+        float32x4_t hpcoeffs[8], hpx1, hpx0, hpy1, hpy0;
+
+        LoadFilterBlock(lpfilter, lpcoeffs, &lpx1, &lpx0, &lpy1, &lpy0);
+        LoadFilterBlock(hpfilter, hpcoeffs, &hpx1, &hpx0, &hpy1, &hpy0);
+        for(;numsamples-i > 3;i += 4)
+        {
+            float32x4_t smps = vld1q_f32(&src[i]);
+            smps = FilterBlock(lpcoeffs, smps, &lpx1, &lpx0, &lpy1, &lpy0);
+            smps = FilterBlock(hpcoeffs, smps, &hpx1, &hpx0, &hpy1, &hpy0);
+            vst1q_f32(&dst[i], smps);
+        }
+        StoreFilterBlock(lpfilter, lpx1, lpx0, lpy1, lpy0);
+        StoreFilterBlock(hpfilter, hpx1, hpx0, hpy1, hpy0);
+    }
+    for(;i < numsamples;i++)
+    {
+        ALfloat smp = ALfilterState_processSingle(lpfilter, src[i]);
+        dst[i] = ALfilterState_processSingle(hpfilter, smp);
+    }
+}
+
+
+void FftPass_Neon(ALfloat *restrict re, ALfloat *restrict im, const ALfloat *restrict twr,
+                  const ALfloat *restrict twi, ALuint half, ALuint size)
+{
+    ALuint i, k;
+
+    for(i = 0;i < size;i += half*2)
+    {
+        for(k = 0;k < half;k += 4)
+        {
+            const ALuint a = i + k;
+            const ALuint b = a + half;
+            const float32x4_t wr = vld1q_f32(&twr[k]);
+            const float32x4_t wi = vld1q_f32(&twi[k]);
+            float32x4_t ar = vld1q_f32(&re[a]);
+            float32x4_t ai = vld1q_f32(&im[a]);
+            float32x4_t br = vld1q_f32(&re[b]);
+            float32x4_t bi = vld1q_f32(&im[b]);
+            float32x4_t tr = vmlsq_f32(vmulq_f32(br, wr), bi, wi);
+            float32x4_t ti = vmlaq_f32(vmulq_f32(br, wi), bi, wr);
+
+            vst1q_f32(&re[b], vsubq_f32(ar, tr));
+            vst1q_f32(&im[b], vsubq_f32(ai, ti));
+            vst1q_f32(&re[a], vaddq_f32(ar, tr));
+            vst1q_f32(&im[a], vaddq_f32(ai, ti));
+        }
+    }
+}
+
+void ComplexMulAdd_Neon(ALfloat *restrict dstr, ALfloat *restrict dsti,
+                        const ALfloat *restrict ar, const ALfloat *restrict ai,
+                        const ALfloat *restrict br, const ALfloat *restrict bi, ALuint count)
+{
+    ALuint i;
+
+    for(i = 0;i < count;i += 4)
+    {
+        const float32x4_t r0 = vld1q_f32(&ar[i]);
+        const float32x4_t i0 = vld1q_f32(&ai[i]);
+        const float32x4_t r1 = vld1q_f32(&br[i]);
+        const float32x4_t i1 = vld1q_f32(&bi[i]);
+        float32x4_t outr = vld1q_f32(&dstr[i]);
+        float32x4_t outi = vld1q_f32(&dsti[i]);
+
+        outr = vmlaq_f32(outr, r0, r1);
+        outr = vmlsq_f32(outr, i0, i1);
+        outi = vmlaq_f32(outi, r0, i1);
+        outi = vmlaq_f32(outi, i0, r1);
+        vst1q_f32(&dstr[i], outr);
+        vst1q_f32(&dsti[i], outi);
+    }
+}
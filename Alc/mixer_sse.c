@@ -210,3 +210,154 @@ void Mix_SSE(const ALfloat *data, ALuint OutChans, ALfloat (*restrict OutBuffer)
             OutBuffer[c][OutPos+pos] += data[pos]*gain;
     }
 }
+
+
+/* Runs one block of four samples through a biquad filter, given the block
+ * coefficients from CalcFilterBlockCoeffs and the filter history, each
+ * broadcast across a vector. The history is updated for the next block.
+ */
+static inline __m128 FilterBlock(const __m128 *restrict coeffs, const __m128 in,
+                                 __m128 *restrict x1, __m128 *restrict x0,
+                                 __m128 *restrict y1, __m128 *restrict y0)
+{
+    __m128 out;
+
+    out = _mm_mul_ps(coeffs[0], *x1);
+    out = _mm_add_ps(out, _mm_mul_ps(coeffs[1], *x0));
+    out = _mm_add_ps(out, _mm_mul_ps(coeffs[2], _mm_shuffle_ps(in, in, _MM_SHUFFLE(0, 0, 0, 0))));
+    out = _mm_add_ps(out, _mm_mul_ps(coeffs[3], _mm_shuffle_ps(in, in, _MM_SHUFFLE(1, 1, 1, 1))));
+    out = _mm_add_ps(out, _mm_mul_ps(coeffs[4], _mm_shuffle_ps(in, in, _MM_SHUFFLE(2, 2, 2, 2))));
+    out = _mm_add_ps(out, _mm_mul_ps(coeffs[5], _mm_shuffle_ps(in, in, _MM_SHUFFLE(3, 3, 3, 3))));
+    out = _mm_add_ps(out, _mm_mul_ps(coeffs[6], *y1));
+    out = _mm_add_ps(out, _mm_mul_ps(coeffs[7], *y0));
+
+    *x1 = _mm_shuffle_ps(in, in, _MM_SHUFFLE(2, 2, 2, 2));
+    *x0 = _mm_shuffle_ps(in, in, _MM_SHUFFLE(3, 3, 3, 3));
+    *y1 = _mm_shuffle_ps(out, out, _MM_SHUFFLE(2, 2, 2, 2));
+    *y0 = _mm_shuffle_ps(out, out, _MM_SHUFFLE(3, 3, 3, 3));
+    return out;
+}
+
+static inline void LoadFilterBlock(const ALfilterState *filter, __m128 *restrict coeffs,
+                                   __m128 *restrict x1, __m128 *restrict x0,
+                                   __m128 *restrict y1, __m128 *restrict y0)
+{
+    alignas(16) ALfloat blockcoeffs[8][4];
+    ALuint j;
+
+    CalcFilterBlockCoeffs(filter, blockcoeffs);
+    for(j = 0;j < 8;j++)
+        coeffs[j] = _mm_load_ps(blockcoeffs[j]);
+    *x1 = _mm_set1_ps(filter->x[1]);
+    *x0 = _mm_set1_ps(filter->x[0]);
+    *y1 = _mm_set1_ps(filter->y[1]);
+    *y0 = _mm_set1_ps(filter->y[0]);
+}
+
+static inline void StoreFilterBlock(ALfilterState *filter, __m128 x1, __m128 x0,
+                                    __m128 y1, __m128 y0)
+{
+    filter->x[1] = _mm_cvtss_f32(x1);
+    filter->x[0] = _mm_cvtss_f32(x0);
+    filter->y[1] = _mm_cvtss_f32(y1);
+    filter->y[0] = _mm_cvtss_f32(y0);
+}
+
+void ALfilterState_processSSE(ALfilterState *filter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples)
+{
+    ALuint i = 0;
+
+    if(numsamples >= 4)
+    {
+        __m128 coeffs[8], x1, x0, y1, y0;
+
+        LoadFilterBlock(filter, coeffs, &x1, &x0, &y1, &y0);
+        for(;numsamples-i > 3;i += 4)
+        {
+            const __m128 in = _mm_loadu_ps(&src[i]);
+            _mm_storeu_ps(&dst[i], FilterBlock(coeffs, in, &x1, &x0, &y1, &y0));
+        }
+        StoreFilterBlock(filter, x1, x0, y1, y0);
+    }
+    for(;i < numsamples;i++)
+        dst[i] = ALfilterState_processSingle(filter, src[i]);
+}
+
+void ALfilterState_processBandPassSSE(ALfilterState *lpfilter, ALfilterState *hpfilter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples)
+{
+    ALuint i = 0;
+
+    if(numsamples >= 4)
+    {
+        __m128 lpcoeffs[8], lpx1, lpx0, lpy1, lpy0;
+        __m128 hpcoeffs[8], hpx1, hpx0, hpy1, hpy0;
+
+        LoadFilterBlock(lpfilter, lpcoeffs, &lpx1, &lpx0, &lpy1, &lpy0);
+        LoadFilterBlock(hpfilter, hpcoeffs, &hpx1, &hpx0, &hpy1, &hpy0);
+        for(;numsamples-i > 3;i += 4)
+        {
+            __m128 smps = _mm_loadu_ps(&src[i]);
+            smps = FilterBlock(lpcoeffs, smps, &lpx1, &lpx0, &lpy1, &lpy0);
+            smps = FilterBlock(hpcoeffs, smps, &hpx1, &hpx0, &hpy1, &hpy0);
+            _mm_storeu_ps(&dst[i], smps);
+        }
+        StoreFilterBlock(lpfilter, lpx1, lpx0, lpy1, lpy0);
+        StoreFilterBlock(hpfilter, hpx1, hpx0, hpy1, hpy0);
+    }
+    for(;i < numsamples;i++)
+    {
+        ALfloat smp = ALfilterState_processSingle(lpfilter, src[i]);
+        dst[i] = ALfilterState_processSingle(hpfilter, smp);
+    }
+}
+
+
+void FftPass_SSE(ALfloat *restrict re, ALfloat *restrict im, const ALfloat *restrict twr,
+                 const ALfloat *restrict twi, ALuint half, ALuint size)
+{
+    ALuint i, k;
+
+    for(i = 0;i < size;i += half*2)
+    {
+        for(k = 0;k < half;k += 4)
+        {
+            const ALuint a = i + k;
+            const ALuint b = a + half;
+            const __m128 wr = _mm_load_ps(&twr[k]);
+            const __m128 wi = _mm_load_ps(&twi[k]);
+            __m128 ar = _mm_load_ps(&re[a]);
+            __m128 ai = _mm_load_ps(&im[a]);
+            __m128 br = _mm_load_ps(&re[b]);
+            __m128 bi = _mm_load_ps(&im[b]);
+            __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+            __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+
+            _mm_store_ps(&re[b], _mm_sub_ps(ar, tr));
+            _mm_store_ps(&im[b], _mm_sub_ps(ai, ti));
+            _mm_store_ps(&re[a], _mm_add_ps(ar, tr));
+            _mm_store_ps(&im[a], _mm_add_ps(ai, ti));
+        }
+    }
+}
+
+void ComplexMulAdd_SSE(ALfloat *restrict dstr, ALfloat *restrict dsti,
+                       const ALfloat *restrict ar, const ALfloat *restrict ai,
+                       const ALfloat *restrict br, const ALfloat *restrict bi, ALuint count)
+{
+    ALuint i;
+
+    for(i = 0;i < count;i += 4)
+    {
+        const __m128 r0 = _mm_load_ps(&ar[i]);
+        const __m128 i0 = _mm_load_ps(&ai[i]);
+        const __m128 r1 = _mm_load_ps(&br[i]);
+        const __m128 i1 = _mm_load_ps(&bi[i]);
+        __m128 outr = _mm_load_ps(&dstr[i]);
+        __m128 outi = _mm_load_ps(&dsti[i]);
+
+        outr = _mm_add_ps(outr, _mm_sub_ps(_mm_mul_ps(r0, r1), _mm_mul_ps(i0, i1)));
+        outi = _mm_add_ps(outi, _mm_add_ps(_mm_mul_ps(r0, i1), _mm_mul_ps(i0, r1)));
+        _mm_store_ps(&dstr[i], outr);
+        _mm_store_ps(&dsti[i], outi);
+    }
+}
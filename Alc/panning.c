@@ -138,6 +138,8 @@ DECL_CONST static inline const char *GetLabelFromChannel(enum Channel channel)
         case Aux1: return "aux-1";
         case Aux2: return "aux-2";
         case Aux3: return "aux-3";
+        case Aux4: return "aux-4";
+        case Aux5: return "aux-5";
 
         case InvalidChannel: break;
     }
@@ -344,19 +346,42 @@ ALvoid aluInitPanning(ALCdevice *device)
         { Aux1, { { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f } } },
         { Aux2, { { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f } } },
         { Aux3, { { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } },
+    }, BFormat2H[6] = {
+        /* Panned sounds taper off the higher orders, which avoids the rear
+         * lobe a plain second-order decode would have. */
+        { Aux0, { { 1.0f, 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 0.0f } } },
+        { Aux1, { { 0.0f, 0.75f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f } } },
+        { Aux2, { { 0.0f, 0.0f, 0.75f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f } } },
+        { Aux3, { { 0.0f, 0.0f, 0.0f, 0.75f }, { 0.0f, 0.0f, 0.0f, 1.0f } } },
+        { Aux4, { { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.25f }, { 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { Aux5, { { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.25f }, { 0.0f, 0.0f, 0.0f, 0.0f } } },
     };
+    /* The ambisonic component carried by each of the HRTF B-Format channels,
+     * as an index into the HOA coefficients. */
+    static const ALuint BFormatHrtfComponent[6] = { 0, 1, 2, 3, 7, 8 };
     const ChannelMap *chanmap = NULL;
     size_t count = 0;
 
     memset(device->Channel, 0, sizeof(device->Channel));
     device->NumChannels = 0;
 
+    DestroyHrtfConvolver(device->Hrtf_Conv);
+    device->Hrtf_Conv = NULL;
+
     if(device->Hrtf)
     {
         ALuint i;
 
-        count = COUNTOF(BFormat3D);
-        chanmap = BFormat3D;
+        if(device->Hrtf_Mode == HrtfAmbi2)
+        {
+            count = COUNTOF(BFormat2H);
+            chanmap = BFormat2H;
+        }
+        else
+        {
+            count = COUNTOF(BFormat3D);
+            chanmap = BFormat3D;
+        }
 
         for(i = 0;i < count;i++)
             device->ChannelName[i] = chanmap[i].ChanName;
@@ -366,11 +391,23 @@ ALvoid aluInitPanning(ALCdevice *device)
         SetChannelMap(device, chanmap, count);
         for(i = 0;i < count;i++)
         {
-            GetBFormatHrtfCoeffs(device->Hrtf, chanmap[i].Config.FOACoeff,
+            ALfloat ambi_coeffs[MAX_AMBI_COEFFS] = { 0.0f };
+
+            ambi_coeffs[BFormatHrtfComponent[i]] = 1.0f;
+            GetBFormatHrtfCoeffs(device->Hrtf, ambi_coeffs,
                 device->Hrtf_Params[i].Coeffs, device->Hrtf_Params[i].Delay
             );
         }
 
+        if(GetHrtfIrSize(device->Hrtf) > HRTF_CONV_MIN_IRSIZE)
+        {
+            device->Hrtf_Conv = CreateHrtfConvolver(device->Hrtf_Params, count,
+                                                    GetHrtfIrSize(device->Hrtf));
+            if(device->Hrtf_Conv)
+                TRACE("Using partitioned convolution for %u-tap HRIRs\n",
+                      GetHrtfIrSize(device->Hrtf));
+        }
+
         return;
     }
 
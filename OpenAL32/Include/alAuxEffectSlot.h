@@ -22,7 +22,7 @@ struct ALeffectStateVtable {
 
     ALboolean (*const deviceUpdate)(ALeffectState *state, ALCdevice *device);
     void (*const update)(ALeffectState *state, ALCdevice *device, const struct ALeffectslot *slot);
-    void (*const process)(ALeffectState *state, ALuint samplesToDo, const ALfloat *restrict samplesIn, ALfloat (*restrict samplesOut)[BUFFERSIZE], ALuint numChannels);
+    void (*const process)(ALeffectState *state, ALuint samplesToDo, const ALfloat (*restrict samplesIn)[BUFFERSIZE], ALfloat (*restrict samplesOut)[BUFFERSIZE], ALuint numChannels);
 
     void (*const Delete)(void *ptr);
 };
@@ -31,7 +31,7 @@ struct ALeffectStateVtable {
 DECLARE_THUNK(T, ALeffectState, void, Destruct)                               \
 DECLARE_THUNK1(T, ALeffectState, ALboolean, deviceUpdate, ALCdevice*)         \
 DECLARE_THUNK2(T, ALeffectState, void, update, ALCdevice*, const ALeffectslot*) \
-DECLARE_THUNK4(T, ALeffectState, void, process, ALuint, const ALfloat*restrict, ALfloatBUFFERSIZE*restrict, ALuint) \
+DECLARE_THUNK4(T, ALeffectState, void, process, ALuint, const ALfloatBUFFERSIZE*restrict, ALfloatBUFFERSIZE*restrict, ALuint) \
 static void T##_ALeffectState_Delete(void *ptr)                               \
 { return T##_Delete(STATIC_UPCAST(T, ALeffectState, (ALeffectState*)ptr)); }  \
                                                                               \
@@ -64,7 +64,32 @@ static const struct ALeffectStateFactoryVtable T##_ALeffectStateFactory_vtable =
 }
 
 
+/* Number of samples taken to fade from one effect state to the next when a
+ * slot's effect type changes. Effects that smooth their own parameter changes
+ * use it too.
+ */
+#define EFFECT_FADE_SAMPLES (256)
+
+/* A change to a slot's effect, prepared on the app's thread and handed to the
+ * mixer. Each slot keeps a pool of these, so the mixer doesn't need to
+ * allocate anything or be locked out to pick up a change.
+ */
+typedef struct ALeffectslotUpdate {
+    ALenum EffectType;
+    ALeffectProps EffectProps;
+    ALuint NumChannels;
+
+    /* The state to switch to, already set up for the device, or NULL if the
+     * effect type isn't changing. Once the mixer returns the update to the
+     * pool, this holds the old state instead, for the app's thread to delete.
+     */
+    ALeffectState *State;
+
+    struct ALeffectslotUpdate *next;
+} ALeffectslotUpdate;
+
 typedef struct ALeffectslot {
+    /* The effect currently used by the mixer. */
     ALenum EffectType;
     ALeffectProps EffectProps;
 
@@ -74,7 +99,43 @@ typedef struct ALeffectslot {
     ATOMIC(ALenum) NeedsUpdate;
     ALeffectState *EffectState;
 
-    alignas(16) ALfloat WetBuffer[1][BUFFERSIZE];
+    /* The effect type last set by the app, which the mixer catches up to
+     * once it picks up the pending Update. */
+    ALenum NewEffectType;
+    ATOMIC(ALeffectslotUpdate*) Update;
+    ATOMIC(ALeffectslotUpdate*) FreeUpdates;
+
+    /* The previous effect state, while it's faded out after a type change,
+     * along with the update it will be returned through. FadeBuffer holds the
+     * separate output of the old and new states during the fade. */
+    ALeffectState *FadeState;
+    ALeffectslotUpdate *FadeUpdate;
+    ALuint FadeCount;
+    ALfloat (*FadeBuffer)[BUFFERSIZE];
+
+    /* The effect's input. Channel 0 always holds the plain (mono) mix, so
+     * effects that only handle mono input can ignore the rest. When
+     * NumChannels is 4, channels 1-3 hold the X, Y, and Z components of a
+     * first-order B-Format mix. */
+    alignas(16) ALfloat WetBuffer[MAX_EFFECT_CHANNELS][BUFFERSIZE];
+    ALuint NumChannels;
+
+    /* Number of samples processed since the input last had any signal. Once
+     * this exceeds the effect's tail length, the slot is put to sleep until a
+     * send becomes active again. */
+    ALuint SilentSamples;
+
+    /* Output accumulator used when the slot is processed on the device's
+     * effect pool or feeds another slot, and whether it has anything to add
+     * to the mix. NULL if neither applies. */
+    ALfloat (*MixBuffer)[BUFFERSIZE];
+    ALboolean MixActive;
+
+    /* Slot this one's output feeds into, or NULL for the device output. */
+    struct ALeffectslot *Target;
+    /* Number of slots between this one and the device output. Active slots
+     * are kept sorted by this, so a slot is processed before its target. */
+    ALuint ChainDepth;
 
     RefCount ref;
 
@@ -88,6 +149,11 @@ inline struct ALeffectslot *RemoveEffectSlot(ALCcontext *context, ALuint id)
 { return (struct ALeffectslot*)RemoveUIntMapKey(&context->EffectSlotMap, id); }
 
 ALenum InitEffectSlot(ALeffectslot *slot);
+void DeinitEffectSlot(ALeffectslot *slot);
+ALboolean ApplyEffectSlotUpdate(ALeffectslot *slot, ALCdevice *device);
+void RetireEffectSlotFade(ALeffectslot *slot);
+void DeleteRetiredEffectStates(ALeffectslot *slot);
+ALuint GetEffectSlotTailLength(const ALeffectslot *slot, ALuint frequency);
 ALvoid ReleaseALAuxiliaryEffectSlots(ALCcontext *Context);
 
 
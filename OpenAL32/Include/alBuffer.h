@@ -49,6 +49,9 @@ enum FmtType {
     FmtByte  = UserFmtByte,
     FmtShort = UserFmtShort,
     FmtFloat = UserFmtFloat,
+    /* Compressed formats, stored in blocks of OriginalAlign sample frames. */
+    FmtIMA4    = UserFmtIMA4,
+    FmtMSADPCM = UserFmtMSADPCM,
 };
 enum FmtChannels {
     FmtMono   = UserFmtMono,
@@ -69,10 +72,49 @@ inline ALuint FrameSizeFromFmt(enum FmtChannels chans, enum FmtType type)
 {
     return ChannelsFromFmt(chans) * BytesFromFmt(type);
 }
+inline ALboolean IsCompressedFmt(enum FmtType type)
+{
+    return (type == FmtIMA4 || type == FmtMSADPCM) ? AL_TRUE : AL_FALSE;
+}
+/* Byte size of a block of the given number of sample frames, for compressed
+ * formats. */
+inline ALuint BlockSizeFromFmt(enum FmtChannels chans, enum FmtType type, ALuint align)
+{
+    if(type == FmtIMA4)
+        return ((align-1)/2 + 4) * ChannelsFromFmt(chans);
+    return ((align-2)/2 + 7) * ChannelsFromFmt(chans);
+}
+
+
+/* An asynchronous load of application data into a buffer's storage. */
+typedef struct ALbufferLoad {
+    LoaderJob Job;
+
+    ALvoid *Dst;
+    enum UserFmtType DstType;
+    const ALvoid *Src;
+    enum UserFmtType SrcType;
+    ALsizei NumChannels;
+    ALsizei Frames;
+    ALsizei Align;
 
+    /* The buffer being loaded, to fill its pre-resampled copy (if any) once
+     * the data is converted. */
+    struct ALbuffer *Buffer;
+} ALbufferLoad;
 
 typedef struct ALbuffer {
     ALvoid  *data;
+    /* Set when data is owned by the application, which is told through the
+     * callback (if any) when it's no longer used. */
+    ALboolean StaticData;
+    ALBUFFERRELEASECALLBACKSOFT ReleaseCallback;
+    ALvoid  *ReleaseUserPtr;
+    /* Access bits of the current mapping, or 0 when not mapped, and the
+     * mapped byte range. */
+    ALbitfieldSOFT MappedAccess;
+    ALsizei MappedOffset;
+    ALsizei MappedSize;
 
     ALsizei  Frequency;
     ALenum   Format;
@@ -92,8 +134,21 @@ typedef struct ALbuffer {
     ATOMIC(ALsizei) UnpackAlign;
     ATOMIC(ALsizei) PackAlign;
 
+    /* Set up by alBufferDataAsyncSOFT. The buffer can't be used or changed
+     * while the load is pending. */
+    ALbufferLoad Load;
+
+    /* Device frequency the samples were asked to be pre-resampled to with
+     * AL_PRERESAMPLE_SOFT (0 if not), and the copy resampled to it. The copy
+     * is stored as float, and mixed from in place of the buffer's own samples
+     * by static sources playing at that frequency. */
+    ALuint PreresampleFreq;
+    struct ALbuffer *Preresampled;
+
     /* Number of times buffer was attached to a source (deletion can only occur when 0) */
     RefCount ref;
+    /* Number of handles to this buffer (deletion can only occur when 0) */
+    RefCount handle_ref;
 
     RWLock lock;
 
@@ -101,10 +156,24 @@ typedef struct ALbuffer {
     ALuint id;
 } ALbuffer;
 
+/* Keeps IMA4 and MSADPCM data compressed in memory, to be decoded as it's
+ * mixed. */
+extern ALboolean NativeADPCM;
+
 ALbuffer *NewBuffer(ALCcontext *context);
 void DeleteBuffer(ALCdevice *device, ALbuffer *buffer);
 
-ALenum LoadData(ALbuffer *buffer, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels SrcChannels, enum UserFmtType SrcType, const ALvoid *data, ALsizei align, ALboolean storesrc);
+ALenum LoadData(ALbuffer *buffer, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels SrcChannels, enum UserFmtType SrcType, const ALvoid *data, ALsizei align, ALboolean storesrc, LoaderPool *loader);
+
+inline ALboolean IsBufferLoading(struct ALbuffer *buffer)
+{ return ATOMIC_LOAD(&buffer->Load.Job.Pending); }
+
+/* A handle referencing a buffer directly, for queueing without an ID lookup.
+ * It holds a reference on both the buffer and its device. */
+struct ALbufferhandleSOFT_struct {
+    ALbuffer *Buffer;
+    ALCdevice *Device;
+};
 
 inline struct ALbuffer *LookupBuffer(ALCdevice *device, ALuint id)
 { return (struct ALbuffer*)LookupUIntMapKey(&device->BufferMap, id); }
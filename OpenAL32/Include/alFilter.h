@@ -31,6 +31,14 @@ typedef enum ALfilterType {
     ALfilterType_BandPass,
 } ALfilterType;
 
+struct ALfilterState;
+
+typedef void (*FilterProcessFunc)(struct ALfilterState *filter, ALfloat *restrict dst,
+                                  const ALfloat *src, ALuint numsamples);
+/* Runs a low-pass and a high-pass filter over the samples in one pass. */
+typedef void (*FilterBandPassFunc)(struct ALfilterState *lpfilter, struct ALfilterState *hpfilter,
+                                   ALfloat *restrict dst, const ALfloat *src, ALuint numsamples);
+
 typedef struct ALfilterState {
     ALfloat x[2]; /* History of two last input samples  */
     ALfloat y[2]; /* History of two last output samples */
@@ -62,6 +70,12 @@ inline ALfloat ALfilterState_processSingle(ALfilterState *filter, ALfloat sample
 }
 
 void ALfilterState_processC(ALfilterState *filter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples);
+void ALfilterState_processSSE(ALfilterState *filter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples);
+void ALfilterState_processNeon(ALfilterState *filter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples);
+
+void ALfilterState_processBandPassC(ALfilterState *lpfilter, ALfilterState *hpfilter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples);
+void ALfilterState_processBandPassSSE(ALfilterState *lpfilter, ALfilterState *hpfilter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples);
+void ALfilterState_processBandPassNeon(ALfilterState *lpfilter, ALfilterState *hpfilter, ALfloat *restrict dst, const ALfloat *src, ALuint numsamples);
 
 
 typedef struct ALfilter {
@@ -44,6 +44,11 @@
 #define ALC_HRTF_SOFT                            0x1992
 #endif
 
+#ifndef AL_SOFT_effect_chain
+#define AL_SOFT_effect_chain 1
+#define AL_EFFECTSLOT_TARGET_SOFT                0x199C
+#endif
+
 #ifndef ALC_SOFT_midi_interface
 #define ALC_SOFT_midi_interface 1
 /* Global properties */
@@ -243,6 +248,86 @@ AL_API void AL_APIENTRY alLoadSoundfontSOFT(ALuint id, size_t(*cb)(ALvoid*,size_
 #endif
 #endif
 
+#ifndef AL_SOFT_map_buffer
+#define AL_SOFT_map_buffer 1
+typedef unsigned int ALbitfieldSOFT;
+#define AL_MAP_READ_BIT_SOFT                     0x00000001
+#define AL_MAP_WRITE_BIT_SOFT                    0x00000002
+typedef void (*ALBUFFERRELEASECALLBACKSOFT)(ALvoid *data, ALvoid *userptr);
+typedef void (AL_APIENTRY*LPALBUFFERDATASTATICSOFT)(ALuint buffer, ALenum format, ALvoid *data, ALsizei size, ALsizei freq, ALBUFFERRELEASECALLBACKSOFT callback, ALvoid *userptr);
+typedef void* (AL_APIENTRY*LPALMAPBUFFERSOFT)(ALuint buffer, ALsizei offset, ALsizei length, ALbitfieldSOFT access);
+typedef void (AL_APIENTRY*LPALUNMAPBUFFERSOFT)(ALuint buffer);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferDataStaticSOFT(ALuint buffer, ALenum format, ALvoid *data, ALsizei size, ALsizei freq, ALBUFFERRELEASECALLBACKSOFT callback, ALvoid *userptr);
+AL_API void* AL_APIENTRY alMapBufferSOFT(ALuint buffer, ALsizei offset, ALsizei length, ALbitfieldSOFT access);
+AL_API void AL_APIENTRY alUnmapBufferSOFT(ALuint buffer);
+#endif
+#endif
+
+#ifndef AL_SOFT_async_buffer_data
+#define AL_SOFT_async_buffer_data 1
+#define AL_LOAD_PENDING_SOFT                     0x19A0
+typedef void (AL_APIENTRY*LPALBUFFERDATAASYNCSOFT)(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq);
+typedef void (AL_APIENTRY*LPALWAITBUFFERSSOFT)(ALsizei n, const ALuint *buffers);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferDataAsyncSOFT(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq);
+AL_API void AL_APIENTRY alWaitBuffersSOFT(ALsizei n, const ALuint *buffers);
+#endif
+#endif
+
+#ifndef AL_SOFT_buffer_preresample
+#define AL_SOFT_buffer_preresample 1
+#define AL_PRERESAMPLE_SOFT                      0x19A1
+#endif
+
+#ifndef AL_SOFT_source_batch
+#define AL_SOFT_source_batch 1
+#define AL_SOURCE_POSITION_BIT_SOFT              0x00000001
+#define AL_SOURCE_VELOCITY_BIT_SOFT              0x00000002
+#define AL_SOURCE_DIRECTION_BIT_SOFT             0x00000004
+#define AL_SOURCE_GAIN_BIT_SOFT                  0x00000008
+#define AL_SOURCE_PITCH_BIT_SOFT                 0x00000010
+typedef struct ALsourcepropsSOFT {
+    ALfloat position[3];
+    ALfloat velocity[3];
+    ALfloat direction[3];
+    ALfloat gain;
+    ALfloat pitch;
+} ALsourcepropsSOFT;
+typedef void (AL_APIENTRY*LPALSOURCEPROPSVSOFT)(ALsizei n, const ALuint *sources, ALbitfieldSOFT fields, const ALsourcepropsSOFT *props);
+typedef void (AL_APIENTRY*LPALGETSOURCEPROPSVSOFT)(ALsizei n, const ALuint *sources, ALsourcepropsSOFT *props);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourcePropsvSOFT(ALsizei n, const ALuint *sources, ALbitfieldSOFT fields, const ALsourcepropsSOFT *props);
+AL_API void AL_APIENTRY alGetSourcePropsvSOFT(ALsizei n, const ALuint *sources, ALsourcepropsSOFT *props);
+#endif
+#endif
+
+#ifndef AL_SOFT_direct_handles
+#define AL_SOFT_direct_handles 1
+typedef struct ALsourcehandleSOFT_struct *ALsourcehandleSOFT;
+typedef struct ALbufferhandleSOFT_struct *ALbufferhandleSOFT;
+typedef ALsourcehandleSOFT (AL_APIENTRY*LPALGETSOURCEHANDLESOFT)(ALuint source);
+typedef void (AL_APIENTRY*LPALRELEASESOURCEHANDLESOFT)(ALsourcehandleSOFT handle);
+typedef ALbufferhandleSOFT (AL_APIENTRY*LPALGETBUFFERHANDLESOFT)(ALuint buffer);
+typedef void (AL_APIENTRY*LPALRELEASEBUFFERHANDLESOFT)(ALbufferhandleSOFT handle);
+typedef void (AL_APIENTRY*LPALSOURCEFHANDLESOFT)(ALsourcehandleSOFT handle, ALenum param, ALfloat value);
+typedef void (AL_APIENTRY*LPALSOURCE3FHANDLESOFT)(ALsourcehandleSOFT handle, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3);
+typedef void (AL_APIENTRY*LPALSOURCEPLAYHANDLESOFT)(ALsourcehandleSOFT handle);
+typedef void (AL_APIENTRY*LPALSOURCESTOPHANDLESOFT)(ALsourcehandleSOFT handle);
+typedef void (AL_APIENTRY*LPALSOURCEQUEUEBUFFERHANDLESSOFT)(ALsourcehandleSOFT handle, ALsizei nb, const ALbufferhandleSOFT *buffers);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API ALsourcehandleSOFT AL_APIENTRY alGetSourceHandleSOFT(ALuint source);
+AL_API void AL_APIENTRY alReleaseSourceHandleSOFT(ALsourcehandleSOFT handle);
+AL_API ALbufferhandleSOFT AL_APIENTRY alGetBufferHandleSOFT(ALuint buffer);
+AL_API void AL_APIENTRY alReleaseBufferHandleSOFT(ALbufferhandleSOFT handle);
+AL_API void AL_APIENTRY alSourcefHandleSOFT(ALsourcehandleSOFT handle, ALenum param, ALfloat value);
+AL_API void AL_APIENTRY alSource3fHandleSOFT(ALsourcehandleSOFT handle, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3);
+AL_API void AL_APIENTRY alSourcePlayHandleSOFT(ALsourcehandleSOFT handle);
+AL_API void AL_APIENTRY alSourceStopHandleSOFT(ALsourcehandleSOFT handle);
+AL_API void AL_APIENTRY alSourceQueueBufferHandlesSOFT(ALsourcehandleSOFT handle, ALsizei nb, const ALbufferhandleSOFT *buffers);
+#endif
+#endif
+
 #ifndef ALC_SOFT_device_clock
 #define ALC_SOFT_device_clock 1
 typedef int64_t ALCint64SOFT;
@@ -536,6 +621,8 @@ enum Channel {
     Aux1,
     Aux2,
     Aux3,
+    Aux4,
+    Aux5,
 
     InvalidChannel
 };
@@ -570,6 +657,11 @@ enum DevFmtChannels {
 };
 #define MAX_OUTPUT_CHANNELS  (8)
 
+/* Maximum number of input channels for an effect slot. Slots are fed either a
+ * mono mix, or a first-order B-Format (W, X, Y, Z) mix with unity-gain W.
+ */
+#define MAX_EFFECT_CHANNELS  (4)
+
 ALuint BytesFromDevFmt(enum DevFmtType type) DECL_CONST;
 ALuint ChannelsFromDevFmt(enum DevFmtChannels chans) DECL_CONST;
 inline ALuint FrameSizeFromDevFmt(enum DevFmtChannels chans, enum DevFmtType type)
@@ -608,6 +700,18 @@ typedef struct ChannelConfig {
 #define HRTF_HISTORY_LENGTH (1<<HRTF_HISTORY_BITS)
 #define HRTF_HISTORY_MASK   (HRTF_HISTORY_LENGTH-1)
 
+/* How sources are rendered when HRTF is enabled. */
+enum HrtfMode {
+    /* Each 3D source is filtered with its own HRTF, and a first-order
+     * B-Format bus takes everything else. */
+    HrtfFull,
+    /* Everything is panned to a B-Format bus, and only the bus channels are
+     * HRTF filtered. The second-order bus adds the horizontal second-order
+     * (U and V) channels. */
+    HrtfAmbi1,
+    HrtfAmbi2
+};
+
 typedef struct HrtfState {
     alignas(16) ALfloat History[HRTF_HISTORY_LENGTH];
     alignas(16) ALfloat Values[HRIR_LENGTH][2];
@@ -620,7 +724,27 @@ typedef struct HrtfParams {
     ALint DelayStep[2];
 } HrtfParams;
 
+/* When the device's virtual HRTF channels are handled by the partitioned
+ * convolver, the time-domain mixer only applies this many leading taps. The
+ * convolver is used for HRIRs longer than HRTF_CONV_MIN_IRSIZE. */
+#define HRTF_CONV_BLOCK_SIZE (32)
+#define HRTF_CONV_MIN_IRSIZE (56)
+
 typedef struct RingBuffer RingBuffer;
+typedef struct MixerPool MixerPool;
+typedef struct LoaderPool LoaderPool;
+typedef struct HrtfConvolver HrtfConvolver;
+
+/* Objects in the first slab of a slab pool. Each following slab doubles the
+ * pool's size. */
+#define SLAB_BASE_COUNT  64
+#define SLAB_MAX_SLABS   20
+
+typedef struct SlabPool {
+    size_t ObjSize;
+    ATOMIC(ALvoid*) Slabs[SLAB_MAX_SLABS];
+    RWLock GrowLock;
+} SlabPool;
 
 /* Size for temporary storage of buffer data, in ALfloats. Larger values need
  * more memory, while smaller values may need more iterations. The value needs
@@ -643,6 +767,10 @@ struct ALCdevice_struct
     enum DevFmtType     FmtType;
     ALboolean    IsHeadphones;
 
+    /* Incremented with the backend locked each time the device is reset, so
+     * things set up for it without the lock can tell if they're stale. */
+    ATOMIC(ALuint) ResetCount;
+
     al_string DeviceName;
 
     ATOMIC(ALCenum) LastError;
@@ -665,6 +793,11 @@ struct ALCdevice_struct
     // Map of Filters for this device
     UIntMap FilterMap;
 
+    // Storage and IDs for the Buffers, Effects and Filters
+    SlabPool BufferSlabs;
+    SlabPool EffectSlabs;
+    SlabPool FilterSlabs;
+
     // Map of Soundfonts for this device
     UIntMap SfontMap;
 
@@ -682,9 +815,16 @@ struct ALCdevice_struct
 
     /* HRTF filter tables */
     const struct Hrtf *Hrtf;
+    enum HrtfMode Hrtf_Mode;
+    /* Shortens the HRIRs of quieter sources. */
+    ALboolean Hrtf_AdaptiveLength;
+    /* Compensates HRTF filters for sources closer than the data set's. */
+    ALboolean Hrtf_NearField;
     HrtfState Hrtf_State[MAX_OUTPUT_CHANNELS];
     HrtfParams Hrtf_Params[MAX_OUTPUT_CHANNELS];
     ALuint Hrtf_Offset;
+    /* Applies the taps past the first block for long HRIRs. */
+    HrtfConvolver *Hrtf_Conv;
 
     // Stereo-to-binaural filter
     struct bs2b *Bs2b;
@@ -728,6 +868,17 @@ struct ALCdevice_struct
 
     RingBuffer *loopback_ring;
 
+    /* Worker threads used to process effect slots in parallel. NULL if
+     * disabled. */
+    MixerPool *EffectPool;
+
+    /* Worker threads used for asynchronous buffer loads. Created when first
+     * needed. */
+    ATOMIC(LoaderPool*) BufferLoader;
+
+    /* Feed effects that can make use of it a B-Format mix of their input. */
+    ALboolean EffectBFormat;
+
     /* Memory space used by the default slot (Playback devices only) */
     alignas(16) ALCbyte _slot_mem[];
 };
@@ -758,6 +909,8 @@ struct ALCdevice_struct
 
 #define RECORD_THREAD_NAME "alsoft-record"
 
+#define LOADER_THREAD_NAME "alsoft-loader"
+
 
 struct ALCcontext_struct
 {
@@ -768,6 +921,11 @@ struct ALCcontext_struct
     UIntMap SourceMap;
     UIntMap EffectSlotMap;
 
+    /* Storage and IDs for the Sources, and storage for their buffer queue
+     * items. */
+    SlabPool SourceSlabs;
+    SlabPool BufferListSlabs;
+
     ATOMIC(ALenum) LastError;
 
     ATOMIC(ALenum) UpdateSources;
@@ -795,6 +953,9 @@ struct ALCcontext_struct
     alignas(16) ALCbyte _listener_mem[];
 };
 
+void ALCdevice_IncRef(ALCdevice *device);
+void ALCdevice_DecRef(ALCdevice *device);
+
 ALCcontext *GetContextRef(void);
 
 void ALCcontext_IncRef(ALCcontext *context);
@@ -842,6 +1003,34 @@ ALsizei RingBufferSize(RingBuffer *ring);
 void WriteRingBuffer(RingBuffer *ring, const ALubyte *data, ALsizei len);
 void ReadRingBuffer(RingBuffer *ring, ALubyte *data, ALsizei len);
 
+typedef void (*MixerPoolFunc)(void *arg, ALuint idx);
+MixerPool *CreateMixerPool(ALuint num_threads);
+void DestroyMixerPool(MixerPool *pool);
+ALuint MixerPoolSize(const MixerPool *pool);
+void RunMixerPool(MixerPool *pool, MixerPoolFunc func, void *arg, ALuint count);
+
+/* A job for the loader pool. Pending is set from when the job is queued until
+ * Process returns. */
+typedef struct LoaderJob {
+    void (*Process)(struct LoaderJob *job);
+    struct LoaderJob *next;
+    ATOMIC(ALenum) Pending;
+} LoaderJob;
+LoaderPool *CreateLoaderPool(ALuint num_threads);
+void DestroyLoaderPool(LoaderPool *pool);
+void QueueLoaderJob(LoaderPool *pool, LoaderJob *job);
+void WaitLoaderJob(LoaderPool *pool, LoaderJob *job);
+
+void InitSlabPool(SlabPool *pool, size_t objsize);
+void ResetSlabPool(SlabPool *pool);
+ALvoid *SlabAlloc(SlabPool *pool, ALuint *id);
+void SlabFree(SlabPool *pool, ALvoid *obj);
+
+HrtfConvolver *CreateHrtfConvolver(const HrtfParams *params, ALuint numchans, ALuint irsize);
+void DestroyHrtfConvolver(HrtfConvolver *conv);
+void MixHrtfConvolver(HrtfConvolver *conv, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+                      ALfloat (*restrict InBuffer)[BUFFERSIZE], ALuint BufferSize);
+
 typedef struct ll_ringbuffer ll_ringbuffer_t;
 typedef struct ll_ringbuffer_data {
     char *buf;
@@ -952,6 +1141,11 @@ void FillCPUCaps(ALuint capfilter);
 
 FILE *OpenDataFile(const char *fname, const char *subdir);
 
+/* Maps the whole of an open file into memory, read-only, returning NULL if it
+ * can't be. The mapping stays valid after the file is closed. */
+void *MapFileToMem(FILE *f, size_t *size);
+void UnmapFileMem(void *ptr, size_t size);
+
 /* Small hack to use a pointer-to-array type as a normal argument type.
  * Shouldn't be used directly. */
 typedef ALfloat ALfloatBUFFERSIZE[BUFFERSIZE];
@@ -101,6 +101,12 @@ typedef struct ALsource {
     ALuint position;
     ALuint position_fraction;
 
+    /**
+     * The buffer's pre-resampled copy, when a static source is playing from
+     * it instead of the buffer. The position is then in the copy's samples.
+     */
+    const struct ALbuffer *Preresampled;
+
     /** Source Buffer Queue info. */
     ATOMIC(ALbufferlistitem*) queue;
     ATOMIC(ALbufferlistitem*) current_buffer;
@@ -108,7 +114,6 @@ typedef struct ALsource {
 
     /** Current buffer sample info. */
     ALuint NumChannels;
-    ALuint SampleSize;
 
     /** Direct filter and auxiliary send info. */
     struct {
@@ -130,10 +135,20 @@ typedef struct ALsource {
     /** Source needs to update its mixing parameters. */
     ATOMIC(ALenum) NeedsUpdate;
 
+    /** Number of handles to this source (deletion can only occur when 0) */
+    RefCount handle_ref;
+
     /** Self ID */
     ALuint id;
 } ALsource;
 
+/* A handle referencing a source directly, so calls using it can skip the ID
+ * lookup and the current context. It holds a reference on both. */
+struct ALsourcehandleSOFT_struct {
+    ALsource *Source;
+    ALCcontext *Context;
+};
+
 inline struct ALsource *LookupSource(ALCcontext *context, ALuint id)
 { return (struct ALsource*)LookupUIntMapKey(&context->SourceMap, id); }
 inline struct ALsource *RemoveSource(ALCcontext *context, ALuint id)
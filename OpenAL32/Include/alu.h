@@ -105,6 +105,12 @@ typedef struct DirectParams {
     /* Last direction (relative to listener) and gain of a moving source. */
     aluVector LastDir;
     ALfloat LastGain;
+    /* Last near-field distance, in meters (0 when not compensated). */
+    ALfloat LastDistance;
+    /* HRIR length to mix with, and the length of the target coefficients. The
+     * mix length stays longer than the target's while the tail fades out. */
+    ALuint IrSize;
+    ALuint TargetIrSize;
 
     struct {
         enum ActiveFilters ActiveType;
@@ -121,19 +127,23 @@ typedef struct DirectParams {
 
 typedef struct SendParams {
     ALfloat (*OutBuffer)[BUFFERSIZE];
+    ALuint OutChannels;
 
     ALboolean Moving;
     ALuint Counter;
 
     struct {
         enum ActiveFilters ActiveType;
+        /* Set when these filters match the direct path's, so its filtered
+         * output can be reused rather than filtering the channel again. */
+        ALboolean SameAsDirect;
         ALfilterState LowPass;
         ALfilterState HighPass;
     } Filters[MAX_INPUT_CHANNELS];
 
-    /* Gain control, which applies to all input channels to a single (mono)
-     * output buffer. */
-    MixGains Gain;
+    /* Gain control for each input channel to the slot's input channels (just
+     * W for mono slots, or W, X, Y, Z for B-Format slots). */
+    MixGains Gains[MAX_INPUT_CHANNELS][MAX_EFFECT_CHANNELS];
 } SendParams;
 
 
@@ -148,6 +158,19 @@ typedef void (*HrtfMixerFunc)(ALfloat (*restrict OutBuffer)[BUFFERSIZE], const A
                               const ALuint IrSize, const HrtfParams *hrtfparams,
                               HrtfState *hrtfstate, ALuint BufferSize);
 
+/* Kernels for the partitioned HRTF convolver. FftPassFunc runs one radix-2
+ * pass of a split-format complex FFT, combining the sub-transforms of length
+ * 'half'. ComplexMulAddFunc accumulates the element-wise product of two
+ * split-format complex arrays. Both require counts that are multiples of 4,
+ * and 16-byte aligned arrays. */
+typedef void (*FftPassFunc)(ALfloat *restrict re, ALfloat *restrict im,
+                            const ALfloat *restrict twr, const ALfloat *restrict twi,
+                            ALuint half, ALuint size);
+typedef void (*ComplexMulAddFunc)(ALfloat *restrict dstr, ALfloat *restrict dsti,
+                                  const ALfloat *restrict ar, const ALfloat *restrict ai,
+                                  const ALfloat *restrict br, const ALfloat *restrict bi,
+                                  ALuint count);
+
 
 #define GAIN_SILENCE_THRESHOLD  (0.00001f) /* -100dB */
 
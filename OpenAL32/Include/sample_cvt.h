@@ -6,4 +6,16 @@
 
 void ConvertData(ALvoid *dst, enum UserFmtType dstType, const ALvoid *src, enum UserFmtType srcType, ALsizei numchans, ALsizei len, ALsizei align);
 
+/* Converts as many of the count samples as the SSE2 kernels can handle, and
+ * returns how many were converted (0 if the pair has no SSE2 kernel). */
+ALsizei ConvertData_SSE2(ALvoid *dst, enum UserFmtType dstType, const ALvoid *src, enum UserFmtType srcType, ALsizei count);
+
+/* Resamples a range of interleaved samples offline, with a high quality
+ * filter. Returns AL_FALSE on allocation failure. */
+ALsizei GetResampleTaps(ALuint dstfreq, ALuint srcfreq);
+ALboolean ResampleSamples(ALfloat *dst, ALsizei dstoffset, ALsizei count, ALuint dstfreq, const ALfloat *src, ALsizei srcoffset, ALsizei srccount, ALuint srcfreq, ALsizei channels);
+
+void DecodeIMA4Samples(ALfloat *dst, const ALubyte *src, ALuint chan, ALuint numchans, ALuint skip, ALuint count);
+void DecodeMSADPCMSamples(ALfloat *dst, const ALubyte *src, ALuint chan, ALuint numchans, ALuint skip, ALuint count);
+
 #endif /* SAMPLE_CVT_H */
@@ -37,6 +37,22 @@ extern inline struct ALeffectslot *RemoveEffectSlot(ALCcontext *context, ALuint
 
 static ALenum AddEffectSlotArray(ALCcontext *Context, ALeffectslot **start, ALsizei count);
 static void RemoveEffectSlotArray(ALCcontext *Context, const ALeffectslot *slot);
+static void SortEffectSlotArray(ALCcontext *Context);
+
+
+/* Gets the number of input channels an effect slot should use for the given
+ * effect type. Only effects that can make use of B-Format input get it.
+ */
+static ALuint GetEffectInputChannels(const ALCdevice *device, ALenum type)
+{
+    if(device->EffectBFormat)
+    {
+        if(type == AL_EFFECT_REVERB || type == AL_EFFECT_EAXREVERB ||
+           type == AL_EFFECT_ECHO)
+            return 4;
+    }
+    return 1;
+}
 
 
 static UIntMap EffectStateFactoryMap;
@@ -76,6 +92,19 @@ AL_API ALvoid AL_APIENTRY alGenAuxiliaryEffectSlots(ALsizei n, ALuint *effectslo
             alDeleteAuxiliaryEffectSlots(cur, effectslots);
             SET_ERROR_AND_GOTO(context, err, done);
         }
+        if(context->Device->EffectPool)
+        {
+            /* Slots processed by the effect pool mix into their own buffer,
+             * which the mixer then adds to the device output. */
+            slot->MixBuffer = al_calloc(16, sizeof(slot->MixBuffer[0])*MAX_OUTPUT_CHANNELS);
+            if(!slot->MixBuffer)
+            {
+                DeinitEffectSlot(slot);
+                al_free(slot);
+                alDeleteAuxiliaryEffectSlots(cur, effectslots);
+                SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
+            }
+        }
 
         err = NewThunkEntry(&slot->id);
         if(err == AL_NO_ERROR)
@@ -83,7 +112,8 @@ AL_API ALvoid AL_APIENTRY alGenAuxiliaryEffectSlots(ALsizei n, ALuint *effectslo
         if(err != AL_NO_ERROR)
         {
             FreeThunkEntry(slot->id);
-            DELETE_OBJ(slot->EffectState);
+            DeinitEffectSlot(slot);
+            al_free(slot->MixBuffer);
             al_free(slot);
 
             alDeleteAuxiliaryEffectSlots(cur, effectslots);
@@ -134,7 +164,10 @@ AL_API ALvoid AL_APIENTRY alDeleteAuxiliaryEffectSlots(ALsizei n, const ALuint *
         FreeThunkEntry(slot->id);
 
         RemoveEffectSlotArray(context, slot);
-        DELETE_OBJ(slot->EffectState);
+        if(slot->Target)
+            DecrementRef(&slot->Target->ref);
+        DeinitEffectSlot(slot);
+        al_free(slot->MixBuffer);
 
         memset(slot, 0, sizeof(*slot));
         al_free(slot);
@@ -163,8 +196,9 @@ AL_API ALvoid AL_APIENTRY alAuxiliaryEffectSloti(ALuint effectslot, ALenum param
 {
     ALCdevice *device;
     ALCcontext *context;
-    ALeffectslot *slot;
+    ALeffectslot *slot, *target;
     ALeffect *effect = NULL;
+    ALfloat (*mixbuf)[BUFFERSIZE] = NULL;
     ALenum err;
 
     context = GetContextRef();
@@ -194,11 +228,55 @@ AL_API ALvoid AL_APIENTRY alAuxiliaryEffectSloti(ALuint effectslot, ALenum param
         ATOMIC_STORE(&context->UpdateSources, AL_TRUE);
         break;
 
+    case AL_EFFECTSLOT_TARGET_SOFT:
+        target = (value ? LookupEffectSlot(context, value) : NULL);
+        if(!(value == 0 || target != NULL))
+            SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+        /* A slot with a target mixes into its own buffer. Allocate it before
+         * locking, and only keep it if another thread hasn't set one first.
+         */
+        if(target && !slot->MixBuffer)
+        {
+            mixbuf = al_calloc(16, sizeof(slot->MixBuffer[0])*MAX_OUTPUT_CHANNELS);
+            if(!mixbuf)
+                SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
+        }
+
+        /* Check for a loop with the lock held, so another thread can't change
+         * the chain before this target is set.
+         */
+        LockContext(context);
+        if(target)
+        {
+            /* Don't allow a slot to feed back into itself. */
+            ALeffectslot *checker = target;
+            while(checker && checker != slot)
+                checker = checker->Target;
+            if(checker)
+            {
+                UnlockContext(context);
+                SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+            }
+            if(!slot->MixBuffer)
+            {
+                slot->MixBuffer = mixbuf;
+                mixbuf = NULL;
+            }
+            IncrementRef(&target->ref);
+        }
+        if(slot->Target)
+            DecrementRef(&slot->Target->ref);
+        slot->Target = target;
+        SortEffectSlotArray(context);
+        UnlockContext(context);
+        break;
+
     default:
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
     }
 
 done:
+    al_free(mixbuf);
     ALCcontext_DecRef(context);
 }
 
@@ -210,6 +288,7 @@ AL_API ALvoid AL_APIENTRY alAuxiliaryEffectSlotiv(ALuint effectslot, ALenum para
     {
     case AL_EFFECTSLOT_EFFECT:
     case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO:
+    case AL_EFFECTSLOT_TARGET_SOFT:
         alAuxiliaryEffectSloti(effectslot, param, values[0]);
         return;
     }
@@ -299,6 +378,10 @@ AL_API ALvoid AL_APIENTRY alGetAuxiliaryEffectSloti(ALuint effectslot, ALenum pa
         *value = slot->AuxSendAuto;
         break;
 
+    case AL_EFFECTSLOT_TARGET_SOFT:
+        *value = (slot->Target ? slot->Target->id : 0);
+        break;
+
     default:
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
     }
@@ -315,6 +398,7 @@ AL_API ALvoid AL_APIENTRY alGetAuxiliaryEffectSlotiv(ALuint effectslot, ALenum p
     {
     case AL_EFFECTSLOT_EFFECT:
     case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO:
+    case AL_EFFECTSLOT_TARGET_SOFT:
         alGetAuxiliaryEffectSloti(effectslot, param, values);
         return;
     }
@@ -408,11 +492,45 @@ static void RemoveEffectSlotArray(ALCcontext *context, const ALeffectslot *slot)
     {
         *iter = VECTOR_BACK(context->ActiveAuxSlots);
         VECTOR_POP_BACK(context->ActiveAuxSlots);
+        SortEffectSlotArray(context);
     }
 #undef MATCH_SLOT
     UnlockContext(context);
 }
 
+/* Orders the context's active slots so that each slot comes before the one it
+ * feeds into, with slots the same distance from the device output grouped
+ * together. The context must be locked.
+ */
+static void SortEffectSlotArray(ALCcontext *context)
+{
+    ALeffectslot **begin = VECTOR_ITER_BEGIN(context->ActiveAuxSlots);
+    ALeffectslot **end = VECTOR_ITER_END(context->ActiveAuxSlots);
+    ALeffectslot **iter, **pos;
+
+    for(iter = begin;iter != end;iter++)
+    {
+        const ALeffectslot *target = (*iter)->Target;
+        ALuint depth = 0;
+        while(target)
+        {
+            target = target->Target;
+            depth++;
+        }
+        (*iter)->ChainDepth = depth;
+    }
+
+    /* There's only ever a handful of slots, so a simple stable insertion sort
+     * (deepest first) is fine. */
+    for(iter = begin;iter != end;iter++)
+    {
+        ALeffectslot *slot = *iter;
+        for(pos = iter;pos != begin && (*(pos-1))->ChainDepth < slot->ChainDepth;pos--)
+            *pos = *(pos-1);
+        *pos = slot;
+    }
+}
+
 
 void InitEffectFactoryMap(void)
 {
@@ -439,15 +557,70 @@ void DeinitEffectFactoryMap(void)
 }
 
 
+/* Adds a chain of updates, from first to last, to the slot's pool. This may be
+ * called from the mixer, so it mustn't block or allocate.
+ */
+static void PushEffectSlotUpdates(ALeffectslot *slot, ALeffectslotUpdate *first, ALeffectslotUpdate *last)
+{
+    ALeffectslotUpdate *head = ATOMIC_LOAD(&slot->FreeUpdates);
+    do {
+        last->next = head;
+    } while(!ATOMIC_COMPARE_EXCHANGE_WEAK(ALeffectslotUpdate*, &slot->FreeUpdates, &head, first));
+}
+
+/* Takes an update from the slot's pool, allocating a new one if the pool is
+ * empty. Any effect state the mixer left in it is deleted.
+ */
+static ALeffectslotUpdate *GetEffectSlotUpdate(ALeffectslot *slot)
+{
+    ALeffectslotUpdate *update, *last;
+
+    /* Take the whole pool at once and put back what isn't needed, so other
+     * threads adding to it can't pull the list out from under us. */
+    update = ATOMIC_EXCHANGE(ALeffectslotUpdate*, &slot->FreeUpdates, NULL);
+    if(!update)
+        update = al_calloc(16, sizeof(*update));
+    else if(update->next)
+    {
+        last = update->next;
+        while(last->next)
+            last = last->next;
+        PushEffectSlotUpdates(slot, update->next, last);
+    }
+    if(!update) return NULL;
+
+    update->next = NULL;
+    if(update->State)
+        DELETE_OBJ(update->State);
+    update->State = NULL;
+    return update;
+}
+
+static void DeleteEffectSlotUpdates(ALeffectslotUpdate *update)
+{
+    while(update)
+    {
+        ALeffectslotUpdate *next = update->next;
+        if(update->State)
+            DELETE_OBJ(update->State);
+        al_free(update);
+        update = next;
+    }
+}
+
+
 ALenum InitializeEffect(ALCdevice *Device, ALeffectslot *EffectSlot, ALeffect *effect)
 {
     ALenum newtype = (effect ? effect->type : AL_EFFECT_NULL);
-    ALeffectStateFactory *factory;
+    ALeffectState *State = NULL;
+    ALeffectslotUpdate *update, *old;
+    ALuint resetCount = 0;
+    ALboolean ok;
+    FPUCtl oldMode;
 
-    if(newtype != EffectSlot->EffectType)
+    if(newtype != EffectSlot->NewEffectType)
     {
-        ALeffectState *State;
-        FPUCtl oldMode;
+        ALeffectStateFactory *factory;
 
         factory = getFactoryByType(newtype);
         if(!factory)
@@ -459,59 +632,191 @@ ALenum InitializeEffect(ALCdevice *Device, ALeffectslot *EffectSlot, ALeffect *e
         if(!State)
             return AL_OUT_OF_MEMORY;
 
+        /* Set up the new state here, so its buffers are allocated on the
+         * app's thread rather than while the mixer is locked out. */
+        resetCount = ATOMIC_LOAD(&Device->ResetCount);
         SetMixerFPUMode(&oldMode);
-
-        ALCdevice_Lock(Device);
-        if(V(State,deviceUpdate)(Device) == AL_FALSE)
+        ok = V(State,deviceUpdate)(Device);
+        RestoreFPUMode(&oldMode);
+        if(ok == AL_FALSE)
         {
-            ALCdevice_Unlock(Device);
-            RestoreFPUMode(&oldMode);
             DELETE_OBJ(State);
             return AL_OUT_OF_MEMORY;
         }
 
-        State = ExchangePtr((XchgPtr*)&EffectSlot->EffectState, State);
-        if(!effect)
-        {
-            memset(&EffectSlot->EffectProps, 0, sizeof(EffectSlot->EffectProps));
-            EffectSlot->EffectType = AL_EFFECT_NULL;
-        }
-        else
-        {
-            memcpy(&EffectSlot->EffectProps, &effect->Props, sizeof(effect->Props));
-            EffectSlot->EffectType = effect->type;
-        }
-
-        /* FIXME: This should be done asynchronously, but since the EffectState
-         * object was changed, it needs an update before its Process method can
-         * be called. */
-        ATOMIC_STORE(&EffectSlot->NeedsUpdate, AL_FALSE);
-        V(EffectSlot->EffectState,update)(Device, EffectSlot);
-        ALCdevice_Unlock(Device);
-
-        RestoreFPUMode(&oldMode);
+        /* Switching away from a real effect fades the old one out, which
+         * needs somewhere to hold each state's output. A failure here isn't
+         * fatal, the mixer will just switch without fading. */
+        if(EffectSlot->NewEffectType != AL_EFFECT_NULL && !EffectSlot->FadeBuffer)
+            EffectSlot->FadeBuffer = al_calloc(16, sizeof(EffectSlot->FadeBuffer[0]) *
+                                                   MAX_OUTPUT_CHANNELS*2);
+    }
+    else if(!effect)
+        return AL_NO_ERROR;
 
-        DELETE_OBJ(State);
-        State = NULL;
+    update = GetEffectSlotUpdate(EffectSlot);
+    if(!update)
+    {
+        if(State)
+            DELETE_OBJ(State);
+        return AL_OUT_OF_MEMORY;
     }
+
+    update->EffectType = newtype;
+    if(!effect)
+        memset(&update->EffectProps, 0, sizeof(update->EffectProps));
     else
+        memcpy(&update->EffectProps, &effect->Props, sizeof(effect->Props));
+    update->NumChannels = GetEffectInputChannels(Device, newtype);
+
+    /* Hand over the update with the device locked, so a reset can't slip in
+     * after the check below. A reset only sets up the states the slot already
+     * has, so if one happened since the new state was set up, it needs to be
+     * set up again for the new format. */
+    ALCdevice_Lock(Device);
+    if(State && ATOMIC_LOAD(&Device->ResetCount) != resetCount)
     {
-        if(effect)
+        SetMixerFPUMode(&oldMode);
+        ok = V(State,deviceUpdate)(Device);
+        RestoreFPUMode(&oldMode);
+        if(ok == AL_FALSE)
         {
-            ALCdevice_Lock(Device);
-            memcpy(&EffectSlot->EffectProps, &effect->Props, sizeof(effect->Props));
             ALCdevice_Unlock(Device);
-            ATOMIC_STORE(&EffectSlot->NeedsUpdate, AL_TRUE);
+            PushEffectSlotUpdates(EffectSlot, update, update);
+            DELETE_OBJ(State);
+            return AL_OUT_OF_MEMORY;
         }
     }
+    update->State = State;
+    EffectSlot->NewEffectType = newtype;
+
+    /* If the mixer hasn't picked up the last update yet, this one replaces
+     * it. Make sure a new state from it isn't lost when this update doesn't
+     * bring its own. */
+    old = ATOMIC_EXCHANGE(ALeffectslotUpdate*, &EffectSlot->Update, NULL);
+    if(old)
+    {
+        if(!update->State)
+            update->State = old->State;
+        else if(old->State)
+            DELETE_OBJ(old->State);
+        old->State = NULL;
+    }
+    if(old)
+        PushEffectSlotUpdates(EffectSlot, old, old);
+
+    update = ATOMIC_EXCHANGE(ALeffectslotUpdate*, &EffectSlot->Update, update);
+    if(update)
+        PushEffectSlotUpdates(EffectSlot, update, update);
+    ALCdevice_Unlock(Device);
 
     return AL_NO_ERROR;
 }
 
+/* Picks up the slot's pending update, if any, switching to its new effect
+ * state and recalculating the effect's parameters. Only called from the
+ * mixer, or with the mixer locked out. Returns AL_TRUE if the effect type
+ * changed, meaning sources sending to the slot need updating too.
+ */
+ALboolean ApplyEffectSlotUpdate(ALeffectslot *slot, ALCdevice *device)
+{
+    ALeffectslotUpdate *update;
+    ALeffectState *oldstate;
+    ALenum oldtype;
+
+    update = ATOMIC_EXCHANGE(ALeffectslotUpdate*, &slot->Update, NULL);
+    if(!update)
+    {
+        if(ATOMIC_EXCHANGE(ALenum, &slot->NeedsUpdate, AL_FALSE))
+            V(slot->EffectState,update)(device, slot);
+        return AL_FALSE;
+    }
+
+    oldtype = slot->EffectType;
+    slot->EffectType = update->EffectType;
+    memcpy(&slot->EffectProps, &update->EffectProps, sizeof(update->EffectProps));
+    if(update->NumChannels != slot->NumChannels)
+    {
+        /* Sources may still be mixing in the old format until they get
+         * updated, so clear out everything. */
+        memset(slot->WetBuffer, 0, sizeof(slot->WetBuffer));
+        slot->NumChannels = update->NumChannels;
+    }
+
+    oldstate = NULL;
+    if(update->State)
+    {
+        /* Only one state is faded out at a time. */
+        RetireEffectSlotFade(slot);
+        oldstate = slot->EffectState;
+        slot->EffectState = update->State;
+    }
+    update->State = NULL;
+
+    ATOMIC_STORE(&slot->NeedsUpdate, AL_FALSE);
+    V(slot->EffectState,update)(device, slot);
+
+    if(oldstate && oldtype != AL_EFFECT_NULL && slot->FadeBuffer)
+    {
+        slot->FadeState = oldstate;
+        slot->FadeUpdate = update;
+        slot->FadeCount = EFFECT_FADE_SAMPLES;
+    }
+    else
+    {
+        update->State = oldstate;
+        PushEffectSlotUpdates(slot, update, update);
+    }
+
+    return (oldstate != NULL);
+}
+
+/* Stops fading out the slot's old effect state, returning it to the app's
+ * thread to be deleted.
+ */
+void RetireEffectSlotFade(ALeffectslot *slot)
+{
+    ALeffectslotUpdate *update = slot->FadeUpdate;
+
+    if(!slot->FadeState)
+        return;
+
+    update->State = slot->FadeState;
+    slot->FadeState = NULL;
+    slot->FadeUpdate = NULL;
+    slot->FadeCount = 0;
+    PushEffectSlotUpdates(slot, update, update);
+}
+
+/* Deletes the old effect states the mixer has returned through the slot's
+ * pool, rather than leaving them until the updates are reused. Not for use
+ * from the mixer.
+ */
+void DeleteRetiredEffectStates(ALeffectslot *slot)
+{
+    ALeffectslotUpdate *first, *last;
+
+    first = ATOMIC_EXCHANGE(ALeffectslotUpdate*, &slot->FreeUpdates, NULL);
+    if(!first) return;
+
+    last = first;
+    while(1)
+    {
+        if(last->State)
+            DELETE_OBJ(last->State);
+        last->State = NULL;
+        if(!last->next)
+            break;
+        last = last->next;
+    }
+    PushEffectSlotUpdates(slot, first, last);
+}
+
 
 ALenum InitEffectSlot(ALeffectslot *slot)
 {
     ALeffectStateFactory *factory;
+    ALeffectslotUpdate *first = NULL;
     ALuint i, c;
 
     slot->EffectType = AL_EFFECT_NULL;
@@ -520,19 +825,137 @@ ALenum InitEffectSlot(ALeffectslot *slot)
     if(!(slot->EffectState=V0(factory,create)()))
         return AL_OUT_OF_MEMORY;
 
+    /* Start with a couple of updates in the pool, which is usually all that's
+     * needed: one waiting for the mixer, and one used to fade out an old
+     * effect state. */
+    for(i = 0;i < 2;i++)
+    {
+        ALeffectslotUpdate *update = al_calloc(16, sizeof(*update));
+        if(!update)
+        {
+            DeleteEffectSlotUpdates(first);
+            DELETE_OBJ(slot->EffectState);
+            return AL_OUT_OF_MEMORY;
+        }
+        update->next = first;
+        first = update;
+    }
+
     slot->Gain = 1.0;
     slot->AuxSendAuto = AL_TRUE;
     ATOMIC_INIT(&slot->NeedsUpdate, AL_FALSE);
-    for(c = 0;c < 1;c++)
+    slot->NewEffectType = AL_EFFECT_NULL;
+    ATOMIC_INIT(&slot->Update, NULL);
+    ATOMIC_INIT(&slot->FreeUpdates, first);
+    slot->FadeState = NULL;
+    slot->FadeUpdate = NULL;
+    slot->FadeCount = 0;
+    slot->FadeBuffer = NULL;
+    for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
     {
         for(i = 0;i < BUFFERSIZE;i++)
             slot->WetBuffer[c][i] = 0.0f;
     }
+    slot->NumChannels = 1;
+    slot->SilentSamples = 0;
+    slot->MixBuffer = NULL;
+    slot->MixActive = AL_FALSE;
+    slot->Target = NULL;
+    slot->ChainDepth = 0;
     InitRef(&slot->ref, 0);
 
     return AL_NO_ERROR;
 }
 
+/* Frees everything InitEffectSlot and later updates allocated for the slot.
+ * The mixer must not be using it any more.
+ */
+void DeinitEffectSlot(ALeffectslot *slot)
+{
+    RetireEffectSlotFade(slot);
+    DeleteEffectSlotUpdates(ATOMIC_EXCHANGE(ALeffectslotUpdate*, &slot->Update, NULL));
+    DeleteEffectSlotUpdates(ATOMIC_EXCHANGE(ALeffectslotUpdate*, &slot->FreeUpdates, NULL));
+
+    DELETE_OBJ(slot->EffectState);
+    slot->EffectState = NULL;
+
+    al_free(slot->FadeBuffer);
+    slot->FadeBuffer = NULL;
+}
+
+/* Calculates the length of time, in seconds, for a signal recirculating
+ * through a delay of the given length to decay below the silence threshold.
+ * Returns a negative value if the feedback never decays.
+ */
+static ALfloat CalcFeedbackTail(ALfloat delay, ALfloat feedback)
+{
+    feedback = fabsf(feedback);
+    if(feedback >= 1.0f)
+        return -1.0f;
+    if(feedback <= GAIN_SILENCE_THRESHOLD)
+        return delay;
+    return delay * (1.0f + log10f(GAIN_SILENCE_THRESHOLD)/log10f(feedback));
+}
+
+/* Returns the number of samples the slot's effect may keep producing output
+ * after its input goes silent, or UINT_MAX if it may never go silent. */
+ALuint GetEffectSlotTailLength(const ALeffectslot *slot, ALuint frequency)
+{
+    const ALeffectProps *props = &slot->EffectProps;
+    ALfloat length = 0.0f;
+
+    switch(slot->EffectType)
+    {
+        case AL_EFFECT_EAXREVERB:
+        case AL_EFFECT_REVERB:
+            /* The decay time is given to -60dB, so extend it to reach the
+             * -100dB silence threshold, using the slowest decaying band. */
+            length = props->Reverb.DecayTime * (100.0f/60.0f) *
+                     maxf(1.0f, maxf(props->Reverb.DecayHFRatio, props->Reverb.DecayLFRatio));
+            length += props->Reverb.ReflectionsDelay + props->Reverb.LateReverbDelay;
+            if(slot->EffectType == AL_EFFECT_EAXREVERB)
+                length += props->Reverb.EchoTime;
+            break;
+
+        case AL_EFFECT_ECHO:
+            length = CalcFeedbackTail(props->Echo.Delay + props->Echo.LRDelay,
+                                      props->Echo.Feedback);
+            break;
+
+        case AL_EFFECT_CHORUS:
+            length = CalcFeedbackTail(props->Chorus.Delay*2.0f, props->Chorus.Feedback);
+            break;
+
+        case AL_EFFECT_FLANGER:
+            length = CalcFeedbackTail(props->Flanger.Delay*2.0f, props->Flanger.Feedback);
+            break;
+
+        case AL_EFFECT_AUTOWAH:
+            /* The envelope follower needs to release, and the resonant
+             * filter needs to ring out. */
+            length = props->Autowah.ReleaseTime + 0.1f;
+            break;
+
+        case AL_EFFECT_EQUALIZER:
+        case AL_EFFECT_DISTORTION:
+            /* Only the filter histories need to ring out. */
+            length = 0.1f;
+            break;
+
+        case AL_EFFECT_COMPRESSOR:
+        case AL_EFFECT_RING_MODULATOR:
+        case AL_EFFECT_DEDICATED_DIALOGUE:
+        case AL_EFFECT_DEDICATED_LOW_FREQUENCY_EFFECT:
+        case AL_EFFECT_NULL:
+            break;
+    }
+
+    length *= frequency;
+    if(length < 0.0f || length >= (ALfloat)INT_MAX)
+        return UINT_MAX;
+    return fastf2u(length);
+}
+
 ALvoid ReleaseALAuxiliaryEffectSlots(ALCcontext *Context)
 {
     ALsizei pos;
@@ -541,7 +964,8 @@ ALvoid ReleaseALAuxiliaryEffectSlots(ALCcontext *Context)
         ALeffectslot *temp = Context->EffectSlotMap.array[pos].value;
         Context->EffectSlotMap.array[pos].value = NULL;
 
-        DELETE_OBJ(temp->EffectState);
+        DeinitEffectSlot(temp);
+        al_free(temp->MixBuffer);
 
         FreeThunkEntry(temp->id);
         memset(temp, 0, sizeof(ALeffectslot));
@@ -32,7 +32,6 @@
 #include "alu.h"
 #include "alError.h"
 #include "alBuffer.h"
-#include "alThunk.h"
 #include "sample_cvt.h"
 
 
@@ -40,12 +39,27 @@ extern inline struct ALbuffer *LookupBuffer(ALCdevice *device, ALuint id);
 extern inline struct ALbuffer *RemoveBuffer(ALCdevice *device, ALuint id);
 extern inline ALuint FrameSizeFromUserFmt(enum UserFmtChannels chans, enum UserFmtType type);
 extern inline ALuint FrameSizeFromFmt(enum FmtChannels chans, enum FmtType type);
+extern inline ALboolean IsCompressedFmt(enum FmtType type);
+extern inline ALuint BlockSizeFromFmt(enum FmtChannels chans, enum FmtType type, ALuint align);
+extern inline ALboolean IsBufferLoading(struct ALbuffer *buffer);
+
+ALboolean NativeADPCM = AL_FALSE;
 
 static ALboolean IsValidType(ALenum type) DECL_CONST;
 static ALboolean IsValidChannels(ALenum channels) DECL_CONST;
 static ALboolean DecomposeUserFormat(ALenum format, enum UserFmtChannels *chans, enum UserFmtType *type) DECL_CONST;
 static ALboolean DecomposeFormat(ALenum format, enum FmtChannels *chans, enum FmtType *type) DECL_CONST;
 static ALboolean SanitizeAlignment(enum UserFmtType type, ALsizei *align);
+static void FreeBufferData(ALvoid *data, ALboolean isstatic, ALBUFFERRELEASECALLBACKSOFT callback, ALvoid *userptr);
+static ALsizei StorageFrames(const ALbuffer *buffer, ALsizei offset, ALboolean round_up);
+static ALsizei StorageSize(const ALbuffer *buffer, ALsizei frames);
+static ALenum BufferData(ALbuffer *albuf, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq, LoaderPool *loader);
+static LoaderPool *GetBufferLoader(ALCdevice *device);
+static void ProcessBufferLoad(LoaderJob *job);
+static ALbuffer *NewPreresampled(const ALbuffer *buffer, ALuint freq);
+static void SetPreresampledLoop(ALbuffer *cache, const ALbuffer *buffer);
+static ALboolean FillPreresampled(ALbuffer *cache, const ALbuffer *buffer, ALsizei start, ALsizei count, ALCdevice *device);
+static void DeletePreresampled(ALbuffer *cache);
 
 
 AL_API ALvoid AL_APIENTRY alGenBuffers(ALsizei n, ALuint *buffers)
@@ -89,6 +103,9 @@ AL_API ALvoid AL_APIENTRY alDeleteBuffers(ALsizei n, const ALuint *buffers)
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
 
     device = context->Device;
+    /* Handles are made with the device locked, so keep it locked until the
+     * Buffers are deleted. */
+    ALCdevice_Lock(device);
     for(i = 0;i < n;i++)
     {
         if(!buffers[i])
@@ -96,9 +113,16 @@ AL_API ALvoid AL_APIENTRY alDeleteBuffers(ALsizei n, const ALuint *buffers)
 
         /* Check for valid Buffer ID */
         if((ALBuf=LookupBuffer(device, buffers[i])) == NULL)
+        {
+            ALCdevice_Unlock(device);
             SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
-        if(ReadRef(&ALBuf->ref) != 0)
+        }
+        if(ReadRef(&ALBuf->ref) != 0 || ReadRef(&ALBuf->handle_ref) != 0 ||
+           IsBufferLoading(ALBuf))
+        {
+            ALCdevice_Unlock(device);
             SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+        }
     }
 
     for(i = 0;i < n;i++)
@@ -106,6 +130,7 @@ AL_API ALvoid AL_APIENTRY alDeleteBuffers(ALsizei n, const ALuint *buffers)
         if((ALBuf=LookupBuffer(device, buffers[i])) != NULL)
             DeleteBuffer(device, ALBuf);
     }
+    ALCdevice_Unlock(device);
 
 done:
     ALCcontext_DecRef(context);
@@ -130,14 +155,9 @@ AL_API ALboolean AL_APIENTRY alIsBuffer(ALuint buffer)
 
 AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq)
 {
-    enum UserFmtChannels srcchannels;
-    enum UserFmtType srctype;
     ALCdevice *device;
     ALCcontext *context;
     ALbuffer *albuf;
-    ALenum newformat = AL_NONE;
-    ALuint framesize;
-    ALsizei align;
     ALenum err;
 
     context = GetContextRef();
@@ -146,135 +166,122 @@ AL_API ALvoid AL_APIENTRY alBufferData(ALuint buffer, ALenum format, const ALvoi
     device = context->Device;
     if((albuf=LookupBuffer(device, buffer)) == NULL)
         SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
-    if(!(size >= 0 && freq > 0))
-        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
-    if(DecomposeUserFormat(format, &srcchannels, &srctype) == AL_FALSE)
-        SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
 
-    align = ATOMIC_LOAD(&albuf->UnpackAlign);
-    if(SanitizeAlignment(srctype, &align) == AL_FALSE)
-        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
-    switch(srctype)
-    {
-        case UserFmtByte:
-        case UserFmtUByte:
-        case UserFmtShort:
-        case UserFmtUShort:
-        case UserFmtFloat:
-            framesize = FrameSizeFromUserFmt(srcchannels, srctype) * align;
-            if((size%framesize) != 0)
-                SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    err = BufferData(albuf, format, data, size, freq, NULL);
+    if(err != AL_NO_ERROR)
+        SET_ERROR_AND_GOTO(context, err, done);
 
-            err = LoadData(albuf, freq, format, size/framesize*align,
-                           srcchannels, srctype, data, align, AL_TRUE);
-            if(err != AL_NO_ERROR)
-                SET_ERROR_AND_GOTO(context, err, done);
-            break;
+done:
+    ALCcontext_DecRef(context);
+}
 
-        case UserFmtInt:
-        case UserFmtUInt:
-        case UserFmtByte3:
-        case UserFmtUByte3:
-        case UserFmtDouble:
-            framesize = FrameSizeFromUserFmt(srcchannels, srctype) * align;
-            if((size%framesize) != 0)
-                SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+AL_API void AL_APIENTRY alBufferDataAsyncSOFT(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq)
+{
+    ALCdevice *device;
+    ALCcontext *context;
+    LoaderPool *loader;
+    ALbuffer *albuf;
+    ALenum err;
 
-            switch(srcchannels)
-            {
-                case UserFmtMono: newformat = AL_FORMAT_MONO_FLOAT32; break;
-                case UserFmtStereo: newformat = AL_FORMAT_STEREO_FLOAT32; break;
-                case UserFmtRear: newformat = AL_FORMAT_REAR32; break;
-                case UserFmtQuad: newformat = AL_FORMAT_QUAD32; break;
-                case UserFmtX51: newformat = AL_FORMAT_51CHN32; break;
-                case UserFmtX61: newformat = AL_FORMAT_61CHN32; break;
-                case UserFmtX71: newformat = AL_FORMAT_71CHN32; break;
-                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_FLOAT32; break;
-                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_FLOAT32; break;
-            }
-            err = LoadData(albuf, freq, newformat, size/framesize*align,
-                           srcchannels, srctype, data, align, AL_TRUE);
-            if(err != AL_NO_ERROR)
-                SET_ERROR_AND_GOTO(context, err, done);
-            break;
+    context = GetContextRef();
+    if(!context) return;
 
-        case UserFmtMulaw:
-        case UserFmtAlaw:
-            framesize = FrameSizeFromUserFmt(srcchannels, srctype) * align;
-            if((size%framesize) != 0)
-                SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    device = context->Device;
+    if((albuf=LookupBuffer(device, buffer)) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+    if((loader=GetBufferLoader(device)) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
 
-            switch(srcchannels)
-            {
-                case UserFmtMono: newformat = AL_FORMAT_MONO16; break;
-                case UserFmtStereo: newformat = AL_FORMAT_STEREO16; break;
-                case UserFmtRear: newformat = AL_FORMAT_REAR16; break;
-                case UserFmtQuad: newformat = AL_FORMAT_QUAD16; break;
-                case UserFmtX51: newformat = AL_FORMAT_51CHN16; break;
-                case UserFmtX61: newformat = AL_FORMAT_61CHN16; break;
-                case UserFmtX71: newformat = AL_FORMAT_71CHN16; break;
-                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_16; break;
-                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_16; break;
-            }
-            err = LoadData(albuf, freq, newformat, size/framesize*align,
-                           srcchannels, srctype, data, align, AL_TRUE);
-            if(err != AL_NO_ERROR)
-                SET_ERROR_AND_GOTO(context, err, done);
-            break;
+    err = BufferData(albuf, format, data, size, freq, loader);
+    if(err != AL_NO_ERROR)
+        SET_ERROR_AND_GOTO(context, err, done);
 
-        case UserFmtIMA4:
-            framesize  = (align-1)/2 + 4;
-            framesize *= ChannelsFromUserFmt(srcchannels);
-            if((size%framesize) != 0)
-                SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+done:
+    ALCcontext_DecRef(context);
+}
 
-            switch(srcchannels)
-            {
-                case UserFmtMono: newformat = AL_FORMAT_MONO16; break;
-                case UserFmtStereo: newformat = AL_FORMAT_STEREO16; break;
-                case UserFmtRear: newformat = AL_FORMAT_REAR16; break;
-                case UserFmtQuad: newformat = AL_FORMAT_QUAD16; break;
-                case UserFmtX51: newformat = AL_FORMAT_51CHN16; break;
-                case UserFmtX61: newformat = AL_FORMAT_61CHN16; break;
-                case UserFmtX71: newformat = AL_FORMAT_71CHN16; break;
-                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_16; break;
-                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_16; break;
-            }
-            err = LoadData(albuf, freq, newformat, size/framesize*align,
-                           srcchannels, srctype, data, align, AL_TRUE);
-            if(err != AL_NO_ERROR)
-                SET_ERROR_AND_GOTO(context, err, done);
-            break;
+AL_API void AL_APIENTRY alWaitBuffersSOFT(ALsizei n, const ALuint *buffers)
+{
+    ALCdevice *device;
+    ALCcontext *context;
+    LoaderPool *loader;
+    ALbuffer *albuf;
+    ALsizei i;
 
-        case UserFmtMSADPCM:
-            framesize  = (align-2)/2 + 7;
-            framesize *= ChannelsFromUserFmt(srcchannels);
-            if((size%framesize) != 0)
-                SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    context = GetContextRef();
+    if(!context) return;
 
-            switch(srcchannels)
-            {
-                case UserFmtMono: newformat = AL_FORMAT_MONO16; break;
-                case UserFmtStereo: newformat = AL_FORMAT_STEREO16; break;
-                case UserFmtRear: newformat = AL_FORMAT_REAR16; break;
-                case UserFmtQuad: newformat = AL_FORMAT_QUAD16; break;
-                case UserFmtX51: newformat = AL_FORMAT_51CHN16; break;
-                case UserFmtX61: newformat = AL_FORMAT_61CHN16; break;
-                case UserFmtX71: newformat = AL_FORMAT_71CHN16; break;
-                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_16; break;
-                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_16; break;
-            }
-            err = LoadData(albuf, freq, newformat, size/framesize*align,
-                           srcchannels, srctype, data, align, AL_TRUE);
-            if(err != AL_NO_ERROR)
-                SET_ERROR_AND_GOTO(context, err, done);
-            break;
+    if(!(n >= 0))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+
+    device = context->Device;
+    for(i = 0;i < n;i++)
+    {
+        if(buffers[i] && LookupBuffer(device, buffers[i]) == NULL)
+            SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+    }
+
+    /* Nothing can be pending without the loader. */
+    if((loader=ATOMIC_LOAD(&device->BufferLoader)) == NULL)
+        goto done;
+    for(i = 0;i < n;i++)
+    {
+        if((albuf=LookupBuffer(device, buffers[i])) != NULL)
+            WaitLoaderJob(loader, &albuf->Load.Job);
     }
 
 done:
     ALCcontext_DecRef(context);
 }
 
+
+/* Buffer handles hold a reference on the buffer and its device, so they can be
+ * queued without looking up the buffer. A buffer can't be deleted while it has
+ * handles, but its data can still be changed when it isn't queued. */
+AL_API ALbufferhandleSOFT AL_APIENTRY alGetBufferHandleSOFT(ALuint buffer)
+{
+    ALbufferhandleSOFT handle = NULL;
+    ALCdevice *device;
+    ALCcontext *context;
+    ALbuffer *albuf;
+
+    context = GetContextRef();
+    if(!context) return NULL;
+
+    device = context->Device;
+    if((handle=malloc(sizeof(*handle))) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
+    /* Look up and count the handle with the device locked, so the Buffer
+     * can't be deleted in between. */
+    ALCdevice_Lock(device);
+    if((albuf=LookupBuffer(device, buffer)) == NULL)
+    {
+        ALCdevice_Unlock(device);
+        free(handle);
+        handle = NULL;
+        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+    }
+    IncrementRef(&albuf->handle_ref);
+    ALCdevice_Unlock(device);
+
+    ALCdevice_IncRef(device);
+    handle->Buffer = albuf;
+    handle->Device = device;
+
+done:
+    ALCcontext_DecRef(context);
+    return handle;
+}
+
+AL_API void AL_APIENTRY alReleaseBufferHandleSOFT(ALbufferhandleSOFT handle)
+{
+    if(!handle) return;
+
+    DecrementRef(&handle->Buffer->handle_ref);
+    ALCdevice_DecRef(handle->Device);
+    free(handle);
+}
+
 AL_API ALvoid AL_APIENTRY alBufferSubDataSOFT(ALuint buffer, ALenum format, const ALvoid *data, ALsizei offset, ALsizei length)
 {
     enum UserFmtChannels srcchannels;
@@ -299,6 +306,11 @@ AL_API ALvoid AL_APIENTRY alBufferSubDataSOFT(ALuint buffer, ALenum format, cons
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
 
     WriteLock(&albuf->lock);
+    if(IsBufferLoading(albuf))
+    {
+        WriteUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+    }
     align = ATOMIC_LOAD(&albuf->UnpackAlign);
     if(SanitizeAlignment(srctype, &align) == AL_FALSE)
     {
@@ -342,12 +354,170 @@ AL_API ALvoid AL_APIENTRY alBufferSubDataSOFT(ALuint buffer, ALenum format, cons
 
     channels = ChannelsFromFmt(albuf->FmtChannels);
     bytes = BytesFromFmt(albuf->FmtType);
-    /* offset -> byte offset, length -> sample count */
-    offset = offset/byte_align * channels*bytes;
+    /* offset -> byte offset, length -> sample count. Compressed data is
+     * stored as-is, so the offset is already in bytes. */
+    if(!IsCompressedFmt(albuf->FmtType))
+        offset = offset/byte_align * channels*bytes;
     length = length/byte_align * albuf->OriginalAlign;
 
     ConvertData((char*)albuf->data+offset, (enum UserFmtType)albuf->FmtType,
                 data, srctype, channels, length, align);
+    if(albuf->Preresampled)
+        FillPreresampled(albuf->Preresampled, albuf, StorageFrames(albuf, offset, AL_FALSE),
+                         length, device);
+    WriteUnlock(&albuf->lock);
+
+done:
+    ALCcontext_DecRef(context);
+}
+
+
+AL_API void AL_APIENTRY alBufferDataStaticSOFT(ALuint buffer, ALenum format, ALvoid *data, ALsizei size, ALsizei freq, ALBUFFERRELEASECALLBACKSOFT callback, ALvoid *userptr)
+{
+    enum UserFmtChannels srcchannels;
+    enum UserFmtType srctype;
+    enum FmtChannels dstchannels;
+    enum FmtType dsttype;
+    ALBUFFERRELEASECALLBACKSOFT oldcallback;
+    ALvoid *olduserptr;
+    ALboolean oldstatic;
+    ALvoid *olddata;
+    ALCdevice *device;
+    ALCcontext *context;
+    ALbuffer *albuf;
+    ALuint framesize;
+
+    context = GetContextRef();
+    if(!context) return;
+
+    device = context->Device;
+    if((albuf=LookupBuffer(device, buffer)) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+    if(!(size >= 0 && freq > 0) || (!data && size > 0))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    /* The data is used as-is, so it must already be in a storable format. */
+    if(DecomposeUserFormat(format, &srcchannels, &srctype) == AL_FALSE ||
+       DecomposeFormat(format, &dstchannels, &dsttype) == AL_FALSE ||
+       (long)srctype != (long)dsttype || IsCompressedFmt(dsttype))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
+
+    framesize = FrameSizeFromFmt(dstchannels, dsttype);
+    if((size%framesize) != 0 || ((size_t)data%BytesFromFmt(dsttype)) != 0)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+
+    WriteLock(&albuf->lock);
+    if(ReadRef(&albuf->ref) != 0 || albuf->MappedAccess != 0 || IsBufferLoading(albuf))
+    {
+        WriteUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+    }
+
+    olddata = albuf->data;
+    oldstatic = albuf->StaticData;
+    oldcallback = albuf->ReleaseCallback;
+    olduserptr = albuf->ReleaseUserPtr;
+
+    /* The application can change its own data at any time, so it isn't
+     * pre-resampled. */
+    DeletePreresampled(albuf->Preresampled);
+    albuf->Preresampled = NULL;
+
+    albuf->data = data;
+    albuf->StaticData = AL_TRUE;
+    albuf->ReleaseCallback = callback;
+    albuf->ReleaseUserPtr = userptr;
+
+    albuf->OriginalChannels = srcchannels;
+    albuf->OriginalType     = srctype;
+    albuf->OriginalSize     = size;
+    albuf->OriginalAlign    = 1;
+
+    albuf->Frequency = freq;
+    albuf->FmtChannels = dstchannels;
+    albuf->FmtType = dsttype;
+    albuf->Format = format;
+
+    albuf->SampleLen = size / framesize;
+    albuf->LoopStart = 0;
+    albuf->LoopEnd = albuf->SampleLen;
+    WriteUnlock(&albuf->lock);
+
+    FreeBufferData(olddata, oldstatic, oldcallback, olduserptr);
+
+done:
+    ALCcontext_DecRef(context);
+}
+
+AL_API void* AL_APIENTRY alMapBufferSOFT(ALuint buffer, ALsizei offset, ALsizei length, ALbitfieldSOFT access)
+{
+    ALCdevice *device;
+    ALCcontext *context;
+    ALbuffer *albuf;
+    void *ret = NULL;
+    ALsizei datasize;
+
+    context = GetContextRef();
+    if(!context) return NULL;
+
+    device = context->Device;
+    if((albuf=LookupBuffer(device, buffer)) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+    if(!access || (access&~(AL_MAP_READ_BIT_SOFT|AL_MAP_WRITE_BIT_SOFT)) != 0)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+
+    WriteLock(&albuf->lock);
+    /* Application-owned data is already accessible to the application. */
+    if(albuf->MappedAccess != 0 || albuf->StaticData || IsBufferLoading(albuf))
+    {
+        WriteUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+    }
+    datasize = StorageSize(albuf, albuf->SampleLen);
+    if(!(offset >= 0 && length > 0) || offset > datasize || length > datasize-offset)
+    {
+        WriteUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    }
+
+    /* The storage can't be reallocated while mapped, so the pointer stays
+     * valid until unmapped. */
+    albuf->MappedAccess = access;
+    albuf->MappedOffset = offset;
+    albuf->MappedSize = length;
+    ret = (ALubyte*)albuf->data + offset;
+    WriteUnlock(&albuf->lock);
+
+done:
+    ALCcontext_DecRef(context);
+    return ret;
+}
+
+AL_API void AL_APIENTRY alUnmapBufferSOFT(ALuint buffer)
+{
+    ALCdevice *device;
+    ALCcontext *context;
+    ALbuffer *albuf;
+
+    context = GetContextRef();
+    if(!context) return;
+
+    device = context->Device;
+    if((albuf=LookupBuffer(device, buffer)) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+
+    WriteLock(&albuf->lock);
+    if(albuf->MappedAccess == 0)
+    {
+        WriteUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+    }
+    if((albuf->MappedAccess&AL_MAP_WRITE_BIT_SOFT) && albuf->Preresampled)
+    {
+        ALsizei start = StorageFrames(albuf, albuf->MappedOffset, AL_FALSE);
+        ALsizei end = StorageFrames(albuf, albuf->MappedOffset+albuf->MappedSize, AL_TRUE);
+        FillPreresampled(albuf->Preresampled, albuf, start, end-start, device);
+    }
+    albuf->MappedAccess = 0;
     WriteUnlock(&albuf->lock);
 
 done:
@@ -383,7 +553,7 @@ AL_API void AL_APIENTRY alBufferSamplesSOFT(ALuint buffer,
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
 
     err = LoadData(albuf, samplerate, internalformat, samples,
-                   channels, type, data, align, AL_FALSE);
+                   channels, type, data, align, AL_FALSE, NULL);
     if(err != AL_NO_ERROR)
         SET_ERROR_AND_GOTO(context, err, done);
 
@@ -412,6 +582,11 @@ AL_API void AL_APIENTRY alBufferSubSamplesSOFT(ALuint buffer,
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
 
     WriteLock(&albuf->lock);
+    if(IsBufferLoading(albuf))
+    {
+        WriteUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+    }
     align = ATOMIC_LOAD(&albuf->UnpackAlign);
     if(SanitizeAlignment(type, &align) == AL_FALSE)
     {
@@ -433,11 +608,19 @@ AL_API void AL_APIENTRY alBufferSubSamplesSOFT(ALuint buffer,
         WriteUnlock(&albuf->lock);
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
     }
+    /* Compressed data can only be updated in whole blocks. */
+    if(IsCompressedFmt(albuf->FmtType) &&
+       ((offset%albuf->OriginalAlign) != 0 || (samples%albuf->OriginalAlign) != 0))
+    {
+        WriteUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    }
 
-    /* offset -> byte offset */
-    offset *= FrameSizeFromFmt(albuf->FmtChannels, albuf->FmtType);
-    ConvertData((char*)albuf->data+offset, (enum UserFmtType)albuf->FmtType,
-                data, type, ChannelsFromFmt(albuf->FmtChannels), samples, align);
+    ConvertData((char*)albuf->data+StorageSize(albuf, offset), (enum UserFmtType)albuf->FmtType,
+                data, type, ChannelsFromFmt(albuf->FmtChannels), samples,
+                IsCompressedFmt(albuf->FmtType) ? albuf->OriginalAlign : align);
+    if(albuf->Preresampled)
+        FillPreresampled(albuf->Preresampled, albuf, offset, samples, device);
     WriteUnlock(&albuf->lock);
 
 done:
@@ -465,6 +648,11 @@ AL_API void AL_APIENTRY alGetBufferSamplesSOFT(ALuint buffer,
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
 
     ReadLock(&albuf->lock);
+    if(IsBufferLoading(albuf))
+    {
+        ReadUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+    }
     align = ATOMIC_LOAD(&albuf->PackAlign);
     if(SanitizeAlignment(type, &align) == AL_FALSE)
     {
@@ -486,11 +674,19 @@ AL_API void AL_APIENTRY alGetBufferSamplesSOFT(ALuint buffer,
         ReadUnlock(&albuf->lock);
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
     }
+    /* Compressed data can only be read in whole blocks. */
+    if(IsCompressedFmt(albuf->FmtType) &&
+       ((offset%albuf->OriginalAlign) != 0 || (samples%albuf->OriginalAlign) != 0))
+    {
+        ReadUnlock(&albuf->lock);
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    }
 
     /* offset -> byte offset */
-    offset *= FrameSizeFromFmt(albuf->FmtChannels, albuf->FmtType);
+    offset = StorageSize(albuf, offset);
     ConvertData(data, type, (char*)albuf->data+offset, (enum UserFmtType)albuf->FmtType,
-                ChannelsFromFmt(albuf->FmtChannels), samples, align);
+                ChannelsFromFmt(albuf->FmtChannels), samples,
+                IsCompressedFmt(albuf->FmtType) ? albuf->OriginalAlign : align);
     ReadUnlock(&albuf->lock);
 
 done:
@@ -508,6 +704,9 @@ AL_API ALboolean AL_APIENTRY alIsBufferFormatSupportedSOFT(ALenum format)
     if(!context) return AL_FALSE;
 
     ret = DecomposeFormat(format, &dstchannels, &dsttype);
+    /* Compressed formats can't be converted to. */
+    if(ret && IsCompressedFmt(dsttype))
+        ret = AL_FALSE;
 
     ALCcontext_DecRef(context);
 
@@ -613,6 +812,36 @@ AL_API void AL_APIENTRY alBufferi(ALuint buffer, ALenum param, ALint value)
         ATOMIC_STORE(&albuf->PackAlign, value);
         break;
 
+    case AL_PRERESAMPLE_SOFT:
+        if(!(value == AL_FALSE || value == AL_TRUE))
+            SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+
+        WriteLock(&albuf->lock);
+        if(ReadRef(&albuf->ref) != 0 || IsBufferLoading(albuf))
+        {
+            WriteUnlock(&albuf->lock);
+            SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+        }
+        DeletePreresampled(albuf->Preresampled);
+        albuf->Preresampled = NULL;
+        albuf->PreresampleFreq = value ? device->Frequency : 0;
+
+        /* Setting it again after the device frequency changes remakes the
+         * copy for the new frequency. Making it is only an optimization, so
+         * the buffer just plays as normal if it fails. */
+        if(albuf->PreresampleFreq)
+        {
+            albuf->Preresampled = NewPreresampled(albuf, albuf->PreresampleFreq);
+            if(albuf->Preresampled &&
+               !FillPreresampled(albuf->Preresampled, albuf, 0, albuf->SampleLen, NULL))
+            {
+                DeletePreresampled(albuf->Preresampled);
+                albuf->Preresampled = NULL;
+            }
+        }
+        WriteUnlock(&albuf->lock);
+        break;
+
     default:
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
     }
@@ -657,6 +886,7 @@ AL_API void AL_APIENTRY alBufferiv(ALuint buffer, ALenum param, const ALint *val
         {
             case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
             case AL_PACK_BLOCK_ALIGNMENT_SOFT:
+            case AL_PRERESAMPLE_SOFT:
                 alBufferi(buffer, param, values[0]);
                 return;
         }
@@ -689,6 +919,8 @@ AL_API void AL_APIENTRY alBufferiv(ALuint buffer, ALenum param, const ALint *val
 
         albuf->LoopStart = values[0];
         albuf->LoopEnd = values[1];
+        if(albuf->Preresampled)
+            SetPreresampledLoop(albuf->Preresampled, albuf);
         WriteUnlock(&albuf->lock);
         break;
 
@@ -815,7 +1047,7 @@ AL_API ALvoid AL_APIENTRY alGetBufferi(ALuint buffer, ALenum param, ALint *value
         break;
 
     case AL_BITS:
-        *value = BytesFromFmt(albuf->FmtType) * 8;
+        *value = IsCompressedFmt(albuf->FmtType) ? 4 : BytesFromFmt(albuf->FmtType) * 8;
         break;
 
     case AL_CHANNELS:
@@ -824,8 +1056,7 @@ AL_API ALvoid AL_APIENTRY alGetBufferi(ALuint buffer, ALenum param, ALint *value
 
     case AL_SIZE:
         ReadLock(&albuf->lock);
-        *value = albuf->SampleLen * FrameSizeFromFmt(albuf->FmtChannels,
-                                                     albuf->FmtType);
+        *value = StorageSize(albuf, albuf->SampleLen);
         ReadUnlock(&albuf->lock);
         break;
 
@@ -849,6 +1080,14 @@ AL_API ALvoid AL_APIENTRY alGetBufferi(ALuint buffer, ALenum param, ALint *value
         *value = ATOMIC_LOAD(&albuf->PackAlign);
         break;
 
+    case AL_LOAD_PENDING_SOFT:
+        *value = IsBufferLoading(albuf);
+        break;
+
+    case AL_PRERESAMPLE_SOFT:
+        *value = (albuf->PreresampleFreq != 0);
+        break;
+
     default:
         SET_ERROR_AND_GOTO(context, AL_INVALID_ENUM, done);
     }
@@ -900,6 +1139,8 @@ AL_API void AL_APIENTRY alGetBufferiv(ALuint buffer, ALenum param, ALint *values
     case AL_SAMPLE_LENGTH_SOFT:
     case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
     case AL_PACK_BLOCK_ALIGNMENT_SOFT:
+    case AL_LOAD_PENDING_SOFT:
+    case AL_PRERESAMPLE_SOFT:
         alGetBufferi(buffer, param, values);
         return;
     }
@@ -931,50 +1172,235 @@ done:
 }
 
 
+/*
+ * BufferData
+ *
+ * Loads the application's data into the buffer, in the storage format used
+ * for it. When loader is not NULL, the conversion is done asynchronously on
+ * one of its threads.
+ */
+static ALenum BufferData(ALbuffer *albuf, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq, LoaderPool *loader)
+{
+    enum UserFmtChannels srcchannels;
+    enum UserFmtType srctype;
+    ALenum newformat = AL_NONE;
+    ALuint framesize;
+    ALsizei align;
+    ALenum err;
+
+    if(!(size >= 0 && freq > 0))
+        return AL_INVALID_VALUE;
+    if(DecomposeUserFormat(format, &srcchannels, &srctype) == AL_FALSE)
+        return AL_INVALID_ENUM;
+
+    align = ATOMIC_LOAD(&albuf->UnpackAlign);
+    if(SanitizeAlignment(srctype, &align) == AL_FALSE)
+        return AL_INVALID_VALUE;
+    switch(srctype)
+    {
+        case UserFmtByte:
+        case UserFmtUByte:
+        case UserFmtShort:
+        case UserFmtUShort:
+        case UserFmtFloat:
+            framesize = FrameSizeFromUserFmt(srcchannels, srctype) * align;
+            if((size%framesize) != 0)
+                return AL_INVALID_VALUE;
+
+            err = LoadData(albuf, freq, format, size/framesize*align,
+                           srcchannels, srctype, data, align, AL_TRUE,
+                           loader);
+            if(err != AL_NO_ERROR)
+                return err;
+            break;
+
+        case UserFmtInt:
+        case UserFmtUInt:
+        case UserFmtByte3:
+        case UserFmtUByte3:
+        case UserFmtDouble:
+            framesize = FrameSizeFromUserFmt(srcchannels, srctype) * align;
+            if((size%framesize) != 0)
+                return AL_INVALID_VALUE;
+
+            switch(srcchannels)
+            {
+                case UserFmtMono: newformat = AL_FORMAT_MONO_FLOAT32; break;
+                case UserFmtStereo: newformat = AL_FORMAT_STEREO_FLOAT32; break;
+                case UserFmtRear: newformat = AL_FORMAT_REAR32; break;
+                case UserFmtQuad: newformat = AL_FORMAT_QUAD32; break;
+                case UserFmtX51: newformat = AL_FORMAT_51CHN32; break;
+                case UserFmtX61: newformat = AL_FORMAT_61CHN32; break;
+                case UserFmtX71: newformat = AL_FORMAT_71CHN32; break;
+                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_FLOAT32; break;
+                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_FLOAT32; break;
+            }
+            err = LoadData(albuf, freq, newformat, size/framesize*align,
+                           srcchannels, srctype, data, align, AL_TRUE,
+                           loader);
+            if(err != AL_NO_ERROR)
+                return err;
+            break;
+
+        case UserFmtMulaw:
+        case UserFmtAlaw:
+            framesize = FrameSizeFromUserFmt(srcchannels, srctype) * align;
+            if((size%framesize) != 0)
+                return AL_INVALID_VALUE;
+
+            switch(srcchannels)
+            {
+                case UserFmtMono: newformat = AL_FORMAT_MONO16; break;
+                case UserFmtStereo: newformat = AL_FORMAT_STEREO16; break;
+                case UserFmtRear: newformat = AL_FORMAT_REAR16; break;
+                case UserFmtQuad: newformat = AL_FORMAT_QUAD16; break;
+                case UserFmtX51: newformat = AL_FORMAT_51CHN16; break;
+                case UserFmtX61: newformat = AL_FORMAT_61CHN16; break;
+                case UserFmtX71: newformat = AL_FORMAT_71CHN16; break;
+                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_16; break;
+                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_16; break;
+            }
+            err = LoadData(albuf, freq, newformat, size/framesize*align,
+                           srcchannels, srctype, data, align, AL_TRUE,
+                           loader);
+            if(err != AL_NO_ERROR)
+                return err;
+            break;
+
+        case UserFmtIMA4:
+            framesize  = (align-1)/2 + 4;
+            framesize *= ChannelsFromUserFmt(srcchannels);
+            if((size%framesize) != 0)
+                return AL_INVALID_VALUE;
+
+            if(NativeADPCM)
+                newformat = format;
+            else switch(srcchannels)
+            {
+                case UserFmtMono: newformat = AL_FORMAT_MONO16; break;
+                case UserFmtStereo: newformat = AL_FORMAT_STEREO16; break;
+                case UserFmtRear: newformat = AL_FORMAT_REAR16; break;
+                case UserFmtQuad: newformat = AL_FORMAT_QUAD16; break;
+                case UserFmtX51: newformat = AL_FORMAT_51CHN16; break;
+                case UserFmtX61: newformat = AL_FORMAT_61CHN16; break;
+                case UserFmtX71: newformat = AL_FORMAT_71CHN16; break;
+                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_16; break;
+                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_16; break;
+            }
+            err = LoadData(albuf, freq, newformat, size/framesize*align,
+                           srcchannels, srctype, data, align, AL_TRUE,
+                           loader);
+            if(err != AL_NO_ERROR)
+                return err;
+            break;
+
+        case UserFmtMSADPCM:
+            framesize  = (align-2)/2 + 7;
+            framesize *= ChannelsFromUserFmt(srcchannels);
+            if((size%framesize) != 0)
+                return AL_INVALID_VALUE;
+
+            if(NativeADPCM)
+                newformat = format;
+            else switch(srcchannels)
+            {
+                case UserFmtMono: newformat = AL_FORMAT_MONO16; break;
+                case UserFmtStereo: newformat = AL_FORMAT_STEREO16; break;
+                case UserFmtRear: newformat = AL_FORMAT_REAR16; break;
+                case UserFmtQuad: newformat = AL_FORMAT_QUAD16; break;
+                case UserFmtX51: newformat = AL_FORMAT_51CHN16; break;
+                case UserFmtX61: newformat = AL_FORMAT_61CHN16; break;
+                case UserFmtX71: newformat = AL_FORMAT_71CHN16; break;
+                case UserFmtBFormat2D: newformat = AL_FORMAT_BFORMAT2D_16; break;
+                case UserFmtBFormat3D: newformat = AL_FORMAT_BFORMAT3D_16; break;
+            }
+            err = LoadData(albuf, freq, newformat, size/framesize*align,
+                           srcchannels, srctype, data, align, AL_TRUE,
+                           loader);
+            if(err != AL_NO_ERROR)
+                return err;
+            break;
+    }
+
+    return AL_NO_ERROR;
+}
+
 /*
  * LoadData
  *
  * Loads the specified data into the buffer, using the specified formats.
  * Currently, the new format must have the same channel configuration as the
- * original format.
+ * original format. If loader is not NULL, the data is converted on one of
+ * its threads, and the buffer stays pending until it's done.
  */
-ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels SrcChannels, enum UserFmtType SrcType, const ALvoid *data, ALsizei align, ALboolean storesrc)
+ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames, enum UserFmtChannels SrcChannels, enum UserFmtType SrcType, const ALvoid *data, ALsizei align, ALboolean storesrc, LoaderPool *loader)
 {
     ALuint NewChannels, NewBytes;
     enum FmtChannels DstChannels;
     enum FmtType DstType;
+    ALBUFFERRELEASECALLBACKSOFT oldcallback = NULL;
+    ALvoid *olduserptr = NULL;
+    ALvoid *olddata = NULL;
     ALuint64 newsize;
     ALvoid *temp;
 
     if(DecomposeFormat(NewFormat, &DstChannels, &DstType) == AL_FALSE ||
        (long)SrcChannels != (long)DstChannels)
         return AL_INVALID_ENUM;
+    /* Compressed data is only stored as-is. */
+    if(IsCompressedFmt(DstType) && ((long)SrcType != (long)DstType || !storesrc))
+        return AL_INVALID_ENUM;
 
     NewChannels = ChannelsFromFmt(DstChannels);
     NewBytes = BytesFromFmt(DstType);
 
-    newsize = frames;
-    newsize *= NewBytes;
-    newsize *= NewChannels;
+    if(IsCompressedFmt(DstType))
+    {
+        newsize = frames / align;
+        newsize *= BlockSizeFromFmt(DstChannels, DstType, align);
+    }
+    else
+    {
+        newsize = frames;
+        newsize *= NewBytes;
+        newsize *= NewChannels;
+    }
     if(newsize > INT_MAX)
         return AL_OUT_OF_MEMORY;
 
     WriteLock(&ALBuf->lock);
-    if(ReadRef(&ALBuf->ref) != 0)
+    if(ReadRef(&ALBuf->ref) != 0 || ALBuf->MappedAccess != 0 || IsBufferLoading(ALBuf))
     {
         WriteUnlock(&ALBuf->lock);
         return AL_INVALID_OPERATION;
     }
 
-    temp = realloc(ALBuf->data, (size_t)newsize);
+    /* Application-owned data is kept until the new storage is allocated, and
+     * released after unlocking. */
+    if(ALBuf->StaticData)
+        temp = malloc((size_t)newsize);
+    else
+        temp = realloc(ALBuf->data, (size_t)newsize);
     if(!temp && newsize)
     {
         WriteUnlock(&ALBuf->lock);
         return AL_OUT_OF_MEMORY;
     }
+    if(ALBuf->StaticData)
+    {
+        olddata = ALBuf->data;
+        oldcallback = ALBuf->ReleaseCallback;
+        olduserptr = ALBuf->ReleaseUserPtr;
+        ALBuf->StaticData = AL_FALSE;
+        ALBuf->ReleaseCallback = NULL;
+        ALBuf->ReleaseUserPtr = NULL;
+    }
     ALBuf->data = temp;
 
-    if(data != NULL)
+    DeletePreresampled(ALBuf->Preresampled);
+    ALBuf->Preresampled = NULL;
+
+    if(data != NULL && !loader)
         ConvertData(ALBuf->data, (enum UserFmtType)DstType, data, SrcType, NewChannels, frames, align);
 
     if(storesrc)
@@ -1016,11 +1442,278 @@ ALenum LoadData(ALbuffer *ALBuf, ALuint freq, ALenum NewFormat, ALsizei frames,
     ALBuf->LoopStart = 0;
     ALBuf->LoopEnd = ALBuf->SampleLen;
 
+    if(ALBuf->PreresampleFreq)
+        ALBuf->Preresampled = NewPreresampled(ALBuf, ALBuf->PreresampleFreq);
+    if(ALBuf->Preresampled && !loader &&
+       !FillPreresampled(ALBuf->Preresampled, ALBuf, 0, ALBuf->SampleLen, NULL))
+    {
+        DeletePreresampled(ALBuf->Preresampled);
+        ALBuf->Preresampled = NULL;
+    }
+
+    /* Queue the conversion before unlocking, so nothing can see the buffer
+     * as loaded until it's finished. */
+    if(data != NULL && loader)
+    {
+        ALbufferLoad *load = &ALBuf->Load;
+        load->Job.Process = ProcessBufferLoad;
+        load->Dst = ALBuf->data;
+        load->DstType = (enum UserFmtType)DstType;
+        load->Src = data;
+        load->SrcType = SrcType;
+        load->NumChannels = NewChannels;
+        load->Frames = frames;
+        load->Align = align;
+        load->Buffer = ALBuf;
+        QueueLoaderJob(loader, &load->Job);
+    }
+
     WriteUnlock(&ALBuf->lock);
+
+    if(olddata)
+        FreeBufferData(olddata, AL_TRUE, oldcallback, olduserptr);
     return AL_NO_ERROR;
 }
 
 
+/*
+ * ProcessBufferLoad
+ *
+ * Converts the data for an asynchronous load, on a loader pool thread.
+ */
+static void ProcessBufferLoad(LoaderJob *job)
+{
+    ALbufferLoad *load = (ALbufferLoad*)job;
+    ALbuffer *buffer = load->Buffer;
+
+    ConvertData(load->Dst, load->DstType, load->Src, load->SrcType,
+                load->NumChannels, load->Frames, load->Align);
+
+    /* Nothing else can touch the buffer until the load is finished. */
+    if(buffer->Preresampled &&
+       !FillPreresampled(buffer->Preresampled, buffer, 0, buffer->SampleLen, NULL))
+    {
+        DeletePreresampled(buffer->Preresampled);
+        buffer->Preresampled = NULL;
+    }
+}
+
+/*
+ * GetBufferLoader
+ *
+ * Returns the device's loader pool, creating it if needed.
+ */
+static LoaderPool *GetBufferLoader(ALCdevice *device)
+{
+    LoaderPool *loader = ATOMIC_LOAD(&device->BufferLoader);
+    LoaderPool *oldloader = NULL;
+    ALuint threads = 1;
+
+    if(loader) return loader;
+
+    ConfigValueUInt(NULL, "buffer-load-threads", &threads);
+    loader = CreateLoaderPool(clampu(threads, 1, 16));
+    if(!loader) return NULL;
+
+    /* Another thread may have created one at the same time. */
+    if(!ATOMIC_COMPARE_EXCHANGE_STRONG(LoaderPool*, &device->BufferLoader, &oldloader, loader))
+    {
+        DestroyLoaderPool(loader);
+        loader = oldloader;
+    }
+    return loader;
+}
+
+/*
+ * NewPreresampled
+ *
+ * Allocates a float copy of the buffer's layout, resampled to the given
+ * frequency. Returns NULL if the buffer doesn't need one, or if it can't be
+ * allocated. The samples are filled in by FillPreresampled.
+ */
+static ALbuffer *NewPreresampled(const ALbuffer *buffer, ALuint freq)
+{
+    ALuint channels = ChannelsFromFmt(buffer->FmtChannels);
+    ALbuffer *cache;
+    ALuint64 len;
+
+    if(buffer->StaticData || buffer->SampleLen == 0 || (ALuint)buffer->Frequency == freq)
+        return NULL;
+
+    len = ((ALuint64)buffer->SampleLen*freq + buffer->Frequency/2) / buffer->Frequency;
+    if(len == 0 || len*channels*sizeof(ALfloat) > INT_MAX)
+        return NULL;
+
+    cache = calloc(1, sizeof(*cache));
+    if(!cache) return NULL;
+    cache->data = malloc((size_t)len*channels*sizeof(ALfloat));
+    if(!cache->data)
+    {
+        free(cache);
+        WARN("Failed to allocate %u samples to pre-resample buffer %u\n",
+             (ALuint)len*channels, buffer->id);
+        return NULL;
+    }
+
+    cache->Frequency = freq;
+    cache->FmtChannels = buffer->FmtChannels;
+    cache->FmtType = FmtFloat;
+    cache->OriginalAlign = 1;
+    cache->SampleLen = (ALsizei)len;
+    cache->id = buffer->id;
+    SetPreresampledLoop(cache, buffer);
+
+    return cache;
+}
+
+/*
+ * SetPreresampledLoop
+ *
+ * Sets the pre-resampled copy's loop points from the buffer's. They're
+ * rounded to the nearest sample frame, so the loop's length may be slightly
+ * different.
+ */
+static void SetPreresampledLoop(ALbuffer *cache, const ALbuffer *buffer)
+{
+    ALuint64 start = ((ALuint64)buffer->LoopStart*cache->Frequency + buffer->Frequency/2) /
+                     buffer->Frequency;
+    ALuint64 end = ((ALuint64)buffer->LoopEnd*cache->Frequency + buffer->Frequency/2) /
+                   buffer->Frequency;
+
+    cache->LoopEnd = (ALsizei)clampu64(end, 1, cache->SampleLen);
+    cache->LoopStart = (ALsizei)minu64(start, cache->LoopEnd-1);
+}
+
+/*
+ * FillPreresampled
+ *
+ * Updates the buffer's pre-resampled copy for the count sample frames changed
+ * from start. The filter spreads a change over many samples, so every output
+ * sample it reaches is redone. With a device given, the copy may be in use by
+ * its mixer, so the samples are made in scratch storage and copied in with the
+ * device locked. Without one, they're written in place.
+ */
+static ALboolean FillPreresampled(ALbuffer *cache, const ALbuffer *buffer, ALsizei start, ALsizei count, ALCdevice *device)
+{
+    ALsizei channels = ChannelsFromFmt(buffer->FmtChannels);
+    ALsizei align = IsCompressedFmt(buffer->FmtType) ? buffer->OriginalAlign : 1;
+    ALsizei taps = GetResampleTaps(cache->Frequency, buffer->Frequency);
+    ALuint64 dstfreq = cache->Frequency;
+    ALuint64 srcfreq = buffer->Frequency;
+    ALsizei dststart, dstend;
+    ALsizei srcstart, srcend;
+    ALfloat *temp, *dst;
+    ALboolean ret;
+
+    /* Find the output samples within the filter's reach of the changed ones,
+     * then the source samples those need. */
+    dststart = 0;
+    if(start > taps)
+        dststart = (ALsizei)(((start-taps)*dstfreq + srcfreq-1) / srcfreq);
+    dstend = (ALsizei)minu64(((start+count+taps)*dstfreq + srcfreq-1) / srcfreq,
+                             cache->SampleLen);
+    if(dststart >= dstend)
+        return AL_TRUE;
+
+    srcstart = maxi((ALsizei)(dststart*srcfreq / dstfreq) - taps, 0);
+    srcend = mini((ALsizei)((dstend-1)*srcfreq / dstfreq) + taps + 1, buffer->SampleLen);
+    /* Compressed data can only be decoded in whole blocks. */
+    srcstart = srcstart / align * align;
+    srcend = mini((srcend+align-1) / align * align, buffer->SampleLen);
+    if(srcstart >= srcend)
+        return AL_TRUE;
+
+    temp = malloc((size_t)(srcend-srcstart)*channels*sizeof(ALfloat));
+    if(device)
+        dst = malloc((size_t)(dstend-dststart)*channels*sizeof(ALfloat));
+    else
+        dst = (ALfloat*)cache->data + dststart*channels;
+    if(!temp || !dst)
+    {
+        WARN("Failed to allocate %d samples to pre-resample buffer %u\n",
+             (srcend-srcstart)*channels, buffer->id);
+        free(temp);
+        if(device)
+            free(dst);
+        return AL_FALSE;
+    }
+
+    ConvertData(temp, UserFmtFloat, (const ALubyte*)buffer->data+StorageSize(buffer, srcstart),
+                (enum UserFmtType)buffer->FmtType, channels, srcend-srcstart, align);
+    ret = ResampleSamples(dst, dststart, dstend-dststart, cache->Frequency,
+                          temp, srcstart, srcend-srcstart, buffer->Frequency, channels);
+    free(temp);
+
+    if(device)
+    {
+        if(ret)
+        {
+            ALCdevice_Lock(device);
+            memcpy((ALfloat*)cache->data + dststart*channels, dst,
+                   (size_t)(dstend-dststart)*channels*sizeof(ALfloat));
+            ALCdevice_Unlock(device);
+        }
+        free(dst);
+    }
+    return ret;
+}
+
+static void DeletePreresampled(ALbuffer *cache)
+{
+    if(!cache) return;
+    free(cache->data);
+    free(cache);
+}
+
+/*
+ * FreeBufferData
+ *
+ * Frees buffer storage, or for application-owned data, tells the application
+ * it's no longer used.
+ */
+static void FreeBufferData(ALvoid *data, ALboolean isstatic, ALBUFFERRELEASECALLBACKSOFT callback, ALvoid *userptr)
+{
+    if(!isstatic)
+        free(data);
+    else if(callback)
+        callback(data, userptr);
+}
+
+/*
+ * StorageFrames
+ *
+ * Returns the sample frame at the given byte offset in the buffer's storage,
+ * rounding up to the next frame (or block) if round_up is set.
+ */
+static ALsizei StorageFrames(const ALbuffer *buffer, ALsizei offset, ALboolean round_up)
+{
+    ALsizei size;
+
+    if(IsCompressedFmt(buffer->FmtType))
+        size = BlockSizeFromFmt(buffer->FmtChannels, buffer->FmtType, buffer->OriginalAlign);
+    else
+        size = FrameSizeFromFmt(buffer->FmtChannels, buffer->FmtType);
+    if(round_up)
+        offset += size-1;
+    return mini(offset/size * (IsCompressedFmt(buffer->FmtType) ? buffer->OriginalAlign : 1),
+                buffer->SampleLen);
+}
+
+/*
+ * StorageSize
+ *
+ * Returns the byte size of the given number of sample frames in the buffer's
+ * storage. For compressed data, this must be a multiple of the block size.
+ */
+static ALsizei StorageSize(const ALbuffer *buffer, ALsizei frames)
+{
+    if(IsCompressedFmt(buffer->FmtType))
+        return frames / buffer->OriginalAlign *
+               BlockSizeFromFmt(buffer->FmtChannels, buffer->FmtType, buffer->OriginalAlign);
+    return frames * FrameSizeFromFmt(buffer->FmtChannels, buffer->FmtType);
+}
+
+
 ALuint BytesFromUserFmt(enum UserFmtType type)
 {
     switch(type)
@@ -1144,6 +1837,8 @@ ALuint BytesFromFmt(enum FmtType type)
     case FmtByte: return sizeof(ALbyte);
     case FmtShort: return sizeof(ALshort);
     case FmtFloat: return sizeof(ALfloat);
+    case FmtIMA4: break; /* not byte-addressable */
+    case FmtMSADPCM: break; /* not byte-addressable */
     }
     return 0;
 }
@@ -1208,6 +1903,11 @@ static ALboolean DecomposeFormat(ALenum format, enum FmtChannels *chans, enum Fm
         { AL_FORMAT_BFORMAT3D_8,       FmtBFormat3D, FmtByte },
         { AL_FORMAT_BFORMAT3D_16,      FmtBFormat3D, FmtShort },
         { AL_FORMAT_BFORMAT3D_FLOAT32, FmtBFormat3D, FmtFloat },
+
+        { AL_FORMAT_MONO_IMA4,           FmtMono,   FmtIMA4    },
+        { AL_FORMAT_STEREO_IMA4,         FmtStereo, FmtIMA4    },
+        { AL_FORMAT_MONO_MSADPCM_SOFT,   FmtMono,   FmtMSADPCM },
+        { AL_FORMAT_STEREO_MSADPCM_SOFT, FmtStereo, FmtMSADPCM },
     };
     ALuint i;
 
@@ -1304,21 +2004,18 @@ ALbuffer *NewBuffer(ALCcontext *context)
     ALCdevice *device = context->Device;
     ALbuffer *buffer;
     ALenum err;
+    ALuint id;
 
-    buffer = calloc(1, sizeof(ALbuffer));
+    buffer = SlabAlloc(&device->BufferSlabs, &id);
     if(!buffer)
         SET_ERROR_AND_RETURN_VALUE(context, AL_OUT_OF_MEMORY, NULL);
     RWLockInit(&buffer->lock);
+    buffer->id = id;
 
-    err = NewThunkEntry(&buffer->id);
-    if(err == AL_NO_ERROR)
-        err = InsertUIntMapEntry(&device->BufferMap, buffer->id, buffer);
+    err = InsertUIntMapEntry(&device->BufferMap, buffer->id, buffer);
     if(err != AL_NO_ERROR)
     {
-        FreeThunkEntry(buffer->id);
-        memset(buffer, 0, sizeof(ALbuffer));
-        free(buffer);
-
+        SlabFree(&device->BufferSlabs, buffer);
         SET_ERROR_AND_RETURN_VALUE(context, err, NULL);
     }
 
@@ -1328,12 +2025,12 @@ ALbuffer *NewBuffer(ALCcontext *context)
 void DeleteBuffer(ALCdevice *device, ALbuffer *buffer)
 {
     RemoveBuffer(device, buffer->id);
-    FreeThunkEntry(buffer->id);
 
-    free(buffer->data);
+    FreeBufferData(buffer->data, buffer->StaticData, buffer->ReleaseCallback,
+                   buffer->ReleaseUserPtr);
+    DeletePreresampled(buffer->Preresampled);
 
-    memset(buffer, 0, sizeof(*buffer));
-    free(buffer);
+    SlabFree(&device->BufferSlabs, buffer);
 }
 
 
@@ -1350,10 +2047,10 @@ ALvoid ReleaseALBuffers(ALCdevice *device)
         ALbuffer *temp = device->BufferMap.array[i].value;
         device->BufferMap.array[i].value = NULL;
 
-        free(temp->data);
+        FreeBufferData(temp->data, temp->StaticData, temp->ReleaseCallback,
+                       temp->ReleaseUserPtr);
+        DeletePreresampled(temp->Preresampled);
 
-        FreeThunkEntry(temp->id);
-        memset(temp, 0, sizeof(ALbuffer));
-        free(temp);
+        SlabFree(&device->BufferSlabs, temp);
     }
 }
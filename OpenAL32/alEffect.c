@@ -28,7 +28,6 @@
 #include "AL/alc.h"
 #include "alMain.h"
 #include "alEffect.h"
-#include "alThunk.h"
 #include "alError.h"
 
 
@@ -56,23 +55,21 @@ AL_API ALvoid AL_APIENTRY alGenEffects(ALsizei n, ALuint *effects)
     device = context->Device;
     for(cur = 0;cur < n;cur++)
     {
-        ALeffect *effect = calloc(1, sizeof(ALeffect));
+        ALuint id;
+        ALeffect *effect = SlabAlloc(&device->EffectSlabs, &id);
         ALenum err = AL_OUT_OF_MEMORY;
         if(!effect || (err=InitEffect(effect)) != AL_NO_ERROR)
         {
-            free(effect);
+            SlabFree(&device->EffectSlabs, effect);
             alDeleteEffects(cur, effects);
             SET_ERROR_AND_GOTO(context, err, done);
         }
+        effect->id = id;
 
-        err = NewThunkEntry(&effect->id);
-        if(err == AL_NO_ERROR)
-            err = InsertUIntMapEntry(&device->EffectMap, effect->id, effect);
+        err = InsertUIntMapEntry(&device->EffectMap, effect->id, effect);
         if(err != AL_NO_ERROR)
         {
-            FreeThunkEntry(effect->id);
-            memset(effect, 0, sizeof(ALeffect));
-            free(effect);
+            SlabFree(&device->EffectSlabs, effect);
 
             alDeleteEffects(cur, effects);
             SET_ERROR_AND_GOTO(context, err, done);
@@ -108,10 +105,7 @@ AL_API ALvoid AL_APIENTRY alDeleteEffects(ALsizei n, const ALuint *effects)
     {
         if((effect=RemoveEffect(device, effects[i])) == NULL)
             continue;
-        FreeThunkEntry(effect->id);
-
-        memset(effect, 0, sizeof(*effect));
-        free(effect);
+        SlabFree(&device->EffectSlabs, effect);
     }
 
 done:
@@ -356,9 +350,7 @@ ALvoid ReleaseALEffects(ALCdevice *device)
         device->EffectMap.array[i].value = NULL;
 
         // Release effect structure
-        FreeThunkEntry(temp->id);
-        memset(temp, 0, sizeof(ALeffect));
-        free(temp);
+        SlabFree(&device->EffectSlabs, temp);
     }
 }
 
@@ -25,7 +25,6 @@
 #include "alMain.h"
 #include "alu.h"
 #include "alFilter.h"
-#include "alThunk.h"
 #include "alError.h"
 
 
@@ -52,22 +51,20 @@ AL_API ALvoid AL_APIENTRY alGenFilters(ALsizei n, ALuint *filters)
     device = context->Device;
     for(cur = 0;cur < n;cur++)
     {
-        ALfilter *filter = calloc(1, sizeof(ALfilter));
+        ALuint id;
+        ALfilter *filter = SlabAlloc(&device->FilterSlabs, &id);
         if(!filter)
         {
             alDeleteFilters(cur, filters);
             SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
         }
         InitFilterParams(filter, AL_FILTER_NULL);
+        filter->id = id;
 
-        err = NewThunkEntry(&filter->id);
-        if(err == AL_NO_ERROR)
-            err = InsertUIntMapEntry(&device->FilterMap, filter->id, filter);
+        err = InsertUIntMapEntry(&device->FilterMap, filter->id, filter);
         if(err != AL_NO_ERROR)
         {
-            FreeThunkEntry(filter->id);
-            memset(filter, 0, sizeof(ALfilter));
-            free(filter);
+            SlabFree(&device->FilterSlabs, filter);
 
             alDeleteFilters(cur, filters);
             SET_ERROR_AND_GOTO(context, err, done);
@@ -103,10 +100,7 @@ AL_API ALvoid AL_APIENTRY alDeleteFilters(ALsizei n, const ALuint *filters)
     {
         if((filter=RemoveFilter(device, filters[i])) == NULL)
             continue;
-        FreeThunkEntry(filter->id);
-
-        memset(filter, 0, sizeof(*filter));
-        free(filter);
+        SlabFree(&device->FilterSlabs, filter);
     }
 
 done:
@@ -336,6 +330,20 @@ void ALfilterState_clear(ALfilterState *filter)
     filter->y[1] = 0.0f;
 }
 
+static inline FilterProcessFunc SelectFilterProcess(void)
+{
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return ALfilterState_processSSE;
+#endif
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return ALfilterState_processNeon;
+#endif
+
+    return ALfilterState_processC;
+}
+
 void ALfilterState_setParams(ALfilterState *filter, ALfilterType type, ALfloat gain, ALfloat freq_mult, ALfloat bandwidth)
 {
     ALfloat alpha;
@@ -413,7 +421,7 @@ void ALfilterState_setParams(ALfilterState *filter, ALfilterType type, ALfloat g
     filter->a[1] /= filter->a[0];
     filter->a[0] /= filter->a[0];
 
-    filter->process = ALfilterState_processC;
+    filter->process = SelectFilterProcess();
 }
 
 
@@ -620,9 +628,7 @@ ALvoid ReleaseALFilters(ALCdevice *device)
         device->FilterMap.array[i].value = NULL;
 
         // Release filter structure
-        FreeThunkEntry(temp->id);
-        memset(temp, 0, sizeof(ALfilter));
-        free(temp);
+        SlabFree(&device->FilterSlabs, temp);
     }
 }
 
@@ -30,7 +30,6 @@
 #include "alError.h"
 #include "alSource.h"
 #include "alBuffer.h"
-#include "alThunk.h"
 #include "alAuxEffectSlot.h"
 
 #include "threads.h"
@@ -622,19 +621,35 @@ static ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SrcIntProp p
 
             if(buffer != NULL)
             {
+                /* Buffers still being loaded can't be used yet. The reference
+                 * is taken first so a new load can't start after the check. */
+                IncrementRef(&buffer->ref);
+                ReadLock(&buffer->lock);
+                if(IsBufferLoading(buffer))
+                {
+                    ReadUnlock(&buffer->lock);
+                    DecrementRef(&buffer->ref);
+                    WriteUnlock(&Source->queue_lock);
+                    SET_ERROR_AND_RETURN_VALUE(Context, AL_INVALID_OPERATION, AL_FALSE);
+                }
+
                 /* Add the selected buffer to a one-item queue */
-                newlist = malloc(sizeof(ALbufferlistitem));
+                newlist = SlabAlloc(&Context->BufferListSlabs, NULL);
+                if(!newlist)
+                {
+                    ReadUnlock(&buffer->lock);
+                    DecrementRef(&buffer->ref);
+                    WriteUnlock(&Source->queue_lock);
+                    SET_ERROR_AND_RETURN_VALUE(Context, AL_OUT_OF_MEMORY, AL_FALSE);
+                }
                 newlist->buffer = buffer;
                 newlist->next = NULL;
                 newlist->prev = NULL;
-                IncrementRef(&buffer->ref);
 
                 /* Source is now Static */
                 Source->SourceType = AL_STATIC;
 
-                ReadLock(&buffer->lock);
                 Source->NumChannels = ChannelsFromFmt(buffer->FmtChannels);
-                Source->SampleSize  = BytesFromFmt(buffer->FmtType);
                 ReadUnlock(&buffer->lock);
             }
             else
@@ -655,7 +670,7 @@ static ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SrcIntProp p
 
                 if(temp->buffer)
                     DecrementRef(&temp->buffer->ref);
-                free(temp);
+                SlabFree(&Context->BufferListSlabs, temp);
             }
             return AL_TRUE;
 
@@ -1419,22 +1434,20 @@ AL_API ALvoid AL_APIENTRY alGenSources(ALsizei n, ALuint *sources)
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
     for(cur = 0;cur < n;cur++)
     {
-        ALsource *source = al_calloc(16, sizeof(ALsource));
+        ALuint id;
+        ALsource *source = SlabAlloc(&context->SourceSlabs, &id);
         if(!source)
         {
             alDeleteSources(cur, sources);
             SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
         }
         InitSourceParams(source);
+        source->id = id;
 
-        err = NewThunkEntry(&source->id);
-        if(err == AL_NO_ERROR)
-            err = InsertUIntMapEntry(&context->SourceMap, source->id, source);
+        err = InsertUIntMapEntry(&context->SourceMap, source->id, source);
         if(err != AL_NO_ERROR)
         {
-            FreeThunkEntry(source->id);
-            memset(source, 0, sizeof(ALsource));
-            al_free(source);
+            SlabFree(&context->SourceSlabs, source);
 
             alDeleteSources(cur, sources);
             SET_ERROR_AND_GOTO(context, err, done);
@@ -1461,11 +1474,22 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
     if(!(n >= 0))
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
 
-    /* Check that all Sources are valid */
+    /* Check that all Sources are valid, and have no handles. Handles are made
+     * with the context locked, so keep it locked until the Sources are
+     * removed. */
+    LockContext(context);
     for(i = 0;i < n;i++)
     {
-        if(LookupSource(context, sources[i]) == NULL)
+        if((Source=LookupSource(context, sources[i])) == NULL)
+        {
+            UnlockContext(context);
             SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+        }
+        if(ReadRef(&Source->handle_ref) != 0)
+        {
+            UnlockContext(context);
+            SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+        }
     }
     for(i = 0;i < n;i++)
     {
@@ -1473,9 +1497,7 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
 
         if((Source=RemoveSource(context, sources[i])) == NULL)
             continue;
-        FreeThunkEntry(Source->id);
 
-        LockContext(context);
         voice = context->Voices;
         voice_end = voice + context->VoiceCount;
         while(voice != voice_end)
@@ -1485,7 +1507,6 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
                 break;
             voice++;
         }
-        UnlockContext(context);
 
         BufferList = ATOMIC_EXCHANGE(ALbufferlistitem*, &Source->queue, NULL);
         while(BufferList != NULL)
@@ -1493,7 +1514,7 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
             ALbufferlistitem *next = BufferList->next;
             if(BufferList->buffer != NULL)
                 DecrementRef(&BufferList->buffer->ref);
-            free(BufferList);
+            SlabFree(&context->BufferListSlabs, BufferList);
             BufferList = next;
         }
 
@@ -1504,9 +1525,9 @@ AL_API ALvoid AL_APIENTRY alDeleteSources(ALsizei n, const ALuint *sources)
             Source->Send[j].Slot = NULL;
         }
 
-        memset(Source, 0, sizeof(*Source));
-        al_free(Source);
+        SlabFree(&context->SourceSlabs, Source);
     }
+    UnlockContext(context);
 
 done:
     ALCcontext_DecRef(context);
@@ -2073,14 +2094,23 @@ AL_API void AL_APIENTRY alGetSourcei64vSOFT(ALuint source, ALenum param, ALint64
 }
 
 
-AL_API ALvoid AL_APIENTRY alSourcePlay(ALuint source)
+#define SOURCE_PROPS_ALL_BITS (AL_SOURCE_POSITION_BIT_SOFT | AL_SOURCE_VELOCITY_BIT_SOFT | \
+                               AL_SOURCE_DIRECTION_BIT_SOFT | AL_SOURCE_GAIN_BIT_SOFT |      \
+                               AL_SOURCE_PITCH_BIT_SOFT)
+
+static ALboolean IsFinite3(const ALfloat *values)
 {
-    alSourcePlayv(1, &source);
+    return isfinite(values[0]) && isfinite(values[1]) && isfinite(values[2]);
 }
-AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
+
+/* Sets the selected properties on each of the sources, from the matching
+ * element of props. Everything is checked before anything is changed, and the
+ * changes are all made while holding the context lock, so the mixer picks
+ * them up together in one update. */
+AL_API void AL_APIENTRY alSourcePropsvSOFT(ALsizei n, const ALuint *sources, ALbitfieldSOFT fields, const ALsourcepropsSOFT *props)
 {
     ALCcontext *context;
-    ALsource *source;
+    ALsource **srclist = NULL;
     ALsizei i;
 
     context = GetContextRef();
@@ -2088,13 +2118,106 @@ AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
 
     if(!(n >= 0))
         SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    if(n == 0)
+        goto done;
+    if(!sources || !props || (fields&~SOURCE_PROPS_ALL_BITS))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+
+    srclist = malloc(n * sizeof(srclist[0]));
+    if(!srclist)
+        SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
     for(i = 0;i < n;i++)
     {
-        if(!LookupSource(context, sources[i]))
+        if((srclist[i]=LookupSource(context, sources[i])) == NULL)
             SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+        if(((fields&AL_SOURCE_POSITION_BIT_SOFT) && !IsFinite3(props[i].position)) ||
+           ((fields&AL_SOURCE_VELOCITY_BIT_SOFT) && !IsFinite3(props[i].velocity)) ||
+           ((fields&AL_SOURCE_DIRECTION_BIT_SOFT) && !IsFinite3(props[i].direction)) ||
+           ((fields&AL_SOURCE_GAIN_BIT_SOFT) && !(props[i].gain >= 0.0f)) ||
+           ((fields&AL_SOURCE_PITCH_BIT_SOFT) && !(props[i].pitch >= 0.0f)))
+            SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
     }
 
     LockContext(context);
+    for(i = 0;i < n;i++)
+    {
+        ALsource *source = srclist[i];
+        const ALsourcepropsSOFT *src = &props[i];
+
+        if((fields&AL_SOURCE_POSITION_BIT_SOFT))
+            aluVectorSet(&source->Position, src->position[0], src->position[1],
+                         src->position[2], 1.0f);
+        if((fields&AL_SOURCE_VELOCITY_BIT_SOFT))
+            aluVectorSet(&source->Velocity, src->velocity[0], src->velocity[1],
+                         src->velocity[2], 0.0f);
+        if((fields&AL_SOURCE_DIRECTION_BIT_SOFT))
+            aluVectorSet(&source->Direction, src->direction[0], src->direction[1],
+                         src->direction[2], 0.0f);
+        if((fields&AL_SOURCE_GAIN_BIT_SOFT))
+            source->Gain = src->gain;
+        if((fields&AL_SOURCE_PITCH_BIT_SOFT))
+            source->Pitch = src->pitch;
+        if(fields)
+            ATOMIC_STORE(&source->NeedsUpdate, AL_TRUE);
+    }
+    UnlockContext(context);
+
+done:
+    free(srclist);
+    ALCcontext_DecRef(context);
+}
+
+/* Gets the batched properties of each of the sources, into the matching
+ * element of props. */
+AL_API void AL_APIENTRY alGetSourcePropsvSOFT(ALsizei n, const ALuint *sources, ALsourcepropsSOFT *props)
+{
+    ALCcontext *context;
+    ALsizei i;
+
+    context = GetContextRef();
+    if(!context) return;
+
+    if(!(n >= 0))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    if(n == 0)
+        goto done;
+    if(!sources || !props)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+
+    LockContext(context);
+    for(i = 0;i < n;i++)
+    {
+        ALsource *source = LookupSource(context, sources[i]);
+        ALsourcepropsSOFT *dst = &props[i];
+
+        if(!source)
+        {
+            UnlockContext(context);
+            SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+        }
+        dst->position[0] = source->Position.v[0];
+        dst->position[1] = source->Position.v[1];
+        dst->position[2] = source->Position.v[2];
+        dst->velocity[0] = source->Velocity.v[0];
+        dst->velocity[1] = source->Velocity.v[1];
+        dst->velocity[2] = source->Velocity.v[2];
+        dst->direction[0] = source->Direction.v[0];
+        dst->direction[1] = source->Direction.v[1];
+        dst->direction[2] = source->Direction.v[2];
+        dst->gain = source->Gain;
+        dst->pitch = source->Pitch;
+    }
+    UnlockContext(context);
+
+done:
+    ALCcontext_DecRef(context);
+}
+
+
+/* Makes sure there are enough voices for n more sources to play. Must be
+ * called with the context locked. */
+static ALboolean ReserveVoices(ALCcontext *context, ALsizei n)
+{
     while(n > context->MaxVoices-context->VoiceCount)
     {
         ALvoice *temp = NULL;
@@ -2104,15 +2227,42 @@ AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
         if(newcount > 0)
             temp = realloc(context->Voices, newcount * sizeof(context->Voices[0]));
         if(!temp)
-        {
-            UnlockContext(context);
-            SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
-        }
+            return AL_FALSE;
         memset(&temp[context->MaxVoices], 0, (newcount-context->MaxVoices) * sizeof(temp[0]));
 
         context->Voices = temp;
         context->MaxVoices = newcount;
     }
+    return AL_TRUE;
+}
+
+AL_API ALvoid AL_APIENTRY alSourcePlay(ALuint source)
+{
+    alSourcePlayv(1, &source);
+}
+AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
+{
+    ALCcontext *context;
+    ALsource *source;
+    ALsizei i;
+
+    context = GetContextRef();
+    if(!context) return;
+
+    if(!(n >= 0))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    for(i = 0;i < n;i++)
+    {
+        if(!LookupSource(context, sources[i]))
+            SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+    }
+
+    LockContext(context);
+    if(!ReserveVoices(context, n))
+    {
+        UnlockContext(context);
+        SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
+    }
 
     for(i = 0;i < n;i++)
     {
@@ -2229,35 +2379,23 @@ done:
 }
 
 
-AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALuint *buffers)
+/* Queues nb buffers on the source, given either by ID, or by handle if ids is
+ * NULL. */
+static void QueueSourceBuffers(ALsource *source, ALCcontext *context, ALsizei nb,
+                               const ALuint *ids, const ALbufferhandleSOFT *handles)
 {
-    ALCdevice *device;
-    ALCcontext *context;
-    ALsource *source;
+    ALCdevice *device = context->Device;
     ALsizei i;
     ALbufferlistitem *BufferListStart;
     ALbufferlistitem *BufferList;
     ALbuffer *BufferFmt = NULL;
 
-    if(nb == 0)
-        return;
-
-    context = GetContextRef();
-    if(!context) return;
-
-    device = context->Device;
-
-    if(!(nb >= 0))
-        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
-    if((source=LookupSource(context, src)) == NULL)
-        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
-
     WriteLock(&source->queue_lock);
     if(source->SourceType == AL_STATIC)
     {
         WriteUnlock(&source->queue_lock);
         /* Can't queue on a Static Source */
-        SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, done);
+        SET_ERROR_AND_RETURN(context, AL_INVALID_OPERATION);
     }
 
     /* Check for a valid Buffer, for its frequency and format */
@@ -2276,29 +2414,39 @@ AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALu
     BufferList = NULL;
     for(i = 0;i < nb;i++)
     {
+        ALbufferlistitem *item;
         ALbuffer *buffer = NULL;
-        if(buffers[i] && (buffer=LookupBuffer(device, buffers[i])) == NULL)
+        if(ids)
         {
-            WriteUnlock(&source->queue_lock);
-            SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, buffer_error);
+            if(ids[i] && (buffer=LookupBuffer(device, ids[i])) == NULL)
+            {
+                WriteUnlock(&source->queue_lock);
+                SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, buffer_error);
+            }
         }
-
-        if(!BufferListStart)
+        else if(handles[i])
         {
-            BufferListStart = malloc(sizeof(ALbufferlistitem));
-            BufferListStart->buffer = buffer;
-            BufferListStart->next = NULL;
-            BufferListStart->prev = NULL;
-            BufferList = BufferListStart;
+            if(handles[i]->Device != device)
+            {
+                WriteUnlock(&source->queue_lock);
+                SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, buffer_error);
+            }
+            buffer = handles[i]->Buffer;
         }
-        else
+
+        if((item=SlabAlloc(&context->BufferListSlabs, NULL)) == NULL)
         {
-            BufferList->next = malloc(sizeof(ALbufferlistitem));
-            BufferList->next->buffer = buffer;
-            BufferList->next->next = NULL;
-            BufferList->next->prev = BufferList;
-            BufferList = BufferList->next;
+            WriteUnlock(&source->queue_lock);
+            SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, buffer_error);
         }
+        item->buffer = buffer;
+        item->next = NULL;
+        item->prev = BufferList;
+        if(!BufferListStart)
+            BufferListStart = item;
+        else
+            BufferList->next = item;
+        BufferList = item;
         if(!buffer) continue;
 
         /* Hold a read lock on each buffer being queued while checking all
@@ -2307,12 +2455,16 @@ AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALu
         ReadLock(&buffer->lock);
         IncrementRef(&buffer->ref);
 
+        if(IsBufferLoading(buffer))
+        {
+            WriteUnlock(&source->queue_lock);
+            SET_ERROR_AND_GOTO(context, AL_INVALID_OPERATION, buffer_error);
+        }
         if(BufferFmt == NULL)
         {
             BufferFmt = buffer;
 
             source->NumChannels = ChannelsFromFmt(buffer->FmtChannels);
-            source->SampleSize  = BytesFromFmt(buffer->FmtType);
         }
         else if(BufferFmt->Frequency != buffer->Frequency ||
                 BufferFmt->OriginalChannels != buffer->OriginalChannels ||
@@ -2332,10 +2484,10 @@ AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALu
                     DecrementRef(&buffer->ref);
                     ReadUnlock(&buffer->lock);
                 }
-                free(BufferList);
+                SlabFree(&context->BufferListSlabs, BufferList);
                 BufferList = prev;
             }
-            goto done;
+            return;
         }
     }
     /* All buffers good, unlock them now. */
@@ -2362,6 +2514,25 @@ AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALu
     BufferList = NULL;
     ATOMIC_COMPARE_EXCHANGE_STRONG(ALbufferlistitem*, &source->current_buffer, &BufferList, BufferListStart);
     WriteUnlock(&source->queue_lock);
+}
+
+AL_API ALvoid AL_APIENTRY alSourceQueueBuffers(ALuint src, ALsizei nb, const ALuint *buffers)
+{
+    ALCcontext *context;
+    ALsource *source;
+
+    if(nb == 0)
+        return;
+
+    context = GetContextRef();
+    if(!context) return;
+
+    if(!(nb >= 0))
+        SET_ERROR_AND_GOTO(context, AL_INVALID_VALUE, done);
+    if((source=LookupSource(context, src)) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+
+    QueueSourceBuffers(source, context, nb, buffers, NULL);
 
 done:
     ALCcontext_DecRef(context);
@@ -2440,7 +2611,7 @@ AL_API ALvoid AL_APIENTRY alSourceUnqueueBuffers(ALuint src, ALsizei nb, ALuint
             DecrementRef(&buffer->ref);
         }
 
-        free(OldHead);
+        SlabFree(&context->BufferListSlabs, OldHead);
         OldHead = next;
     }
 
@@ -2449,6 +2620,138 @@ done:
 }
 
 
+/* Source handles hold a reference on the source and its context, so calls
+ * made with them don't need to look up either one. A source can't be deleted
+ * while it has handles. */
+AL_API ALsourcehandleSOFT AL_APIENTRY alGetSourceHandleSOFT(ALuint source)
+{
+    ALsourcehandleSOFT handle = NULL;
+    ALCcontext *context;
+    ALsource *Source;
+
+    context = GetContextRef();
+    if(!context) return NULL;
+
+    if((handle=malloc(sizeof(*handle))) == NULL)
+        SET_ERROR_AND_GOTO(context, AL_OUT_OF_MEMORY, done);
+    /* Look up and count the handle with the context locked, so the Source
+     * can't be deleted in between. */
+    LockContext(context);
+    if((Source=LookupSource(context, source)) == NULL)
+    {
+        UnlockContext(context);
+        free(handle);
+        handle = NULL;
+        SET_ERROR_AND_GOTO(context, AL_INVALID_NAME, done);
+    }
+    IncrementRef(&Source->handle_ref);
+    UnlockContext(context);
+
+    handle->Source = Source;
+    /* The handle keeps the reference taken on the context. */
+    handle->Context = context;
+    return handle;
+
+done:
+    ALCcontext_DecRef(context);
+    return handle;
+}
+
+AL_API void AL_APIENTRY alReleaseSourceHandleSOFT(ALsourcehandleSOFT handle)
+{
+    if(!handle) return;
+
+    DecrementRef(&handle->Source->handle_ref);
+    ALCcontext_DecRef(handle->Context);
+    free(handle);
+}
+
+/* Flags a NULL handle. There's no context to get from the handle, so the
+ * error goes to the current one. */
+static void SetNullHandleError(void)
+{
+    ALCcontext *context = GetContextRef();
+    if(!context) return;
+    alSetError(context, AL_INVALID_VALUE);
+    ALCcontext_DecRef(context);
+}
+
+AL_API void AL_APIENTRY alSourcefHandleSOFT(ALsourcehandleSOFT handle, ALenum param, ALfloat value)
+{
+    if(!handle)
+        SetNullHandleError();
+    else if(!(FloatValsByProp(param) == 1))
+        alSetError(handle->Context, AL_INVALID_ENUM);
+    else
+        SetSourcefv(handle->Source, handle->Context, param, &value);
+}
+
+AL_API void AL_APIENTRY alSource3fHandleSOFT(ALsourcehandleSOFT handle, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3)
+{
+    if(!handle)
+        SetNullHandleError();
+    else if(!(FloatValsByProp(param) == 3))
+        alSetError(handle->Context, AL_INVALID_ENUM);
+    else
+    {
+        ALfloat fvals[3] = { value1, value2, value3 };
+        SetSourcefv(handle->Source, handle->Context, param, fvals);
+    }
+}
+
+AL_API void AL_APIENTRY alSourcePlayHandleSOFT(ALsourcehandleSOFT handle)
+{
+    ALCcontext *context;
+
+    if(!handle)
+    {
+        SetNullHandleError();
+        return;
+    }
+    context = handle->Context;
+
+    LockContext(context);
+    if(!ReserveVoices(context, 1))
+    {
+        UnlockContext(context);
+        SET_ERROR_AND_RETURN(context, AL_OUT_OF_MEMORY);
+    }
+    if(context->DeferUpdates) handle->Source->new_state = AL_PLAYING;
+    else SetSourceState(handle->Source, context, AL_PLAYING);
+    UnlockContext(context);
+}
+
+AL_API void AL_APIENTRY alSourceStopHandleSOFT(ALsourcehandleSOFT handle)
+{
+    ALCcontext *context;
+
+    if(!handle)
+    {
+        SetNullHandleError();
+        return;
+    }
+    context = handle->Context;
+
+    LockContext(context);
+    handle->Source->new_state = AL_NONE;
+    SetSourceState(handle->Source, context, AL_STOPPED);
+    UnlockContext(context);
+}
+
+AL_API void AL_APIENTRY alSourceQueueBufferHandlesSOFT(ALsourcehandleSOFT handle, ALsizei nb, const ALbufferhandleSOFT *buffers)
+{
+    if(nb == 0)
+        return;
+
+    if(!handle)
+        SetNullHandleError();
+    else if(!(nb >= 0))
+        alSetError(handle->Context, AL_INVALID_VALUE);
+    else
+        QueueSourceBuffers(handle->Source, handle->Context, nb, NULL, buffers);
+}
+
+
 static ALvoid InitSourceParams(ALsource *Source)
 {
     ALuint i;
@@ -2548,6 +2851,17 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
             Source->position = 0;
             Source->position_fraction = 0;
             ATOMIC_STORE(&Source->current_buffer, BufferList);
+
+            /* Play from the buffer's pre-resampled copy if it's at the
+             * device's frequency. It can't go away while the buffer is
+             * attached. */
+            Source->Preresampled = NULL;
+            if(BufferList && Source->SourceType == AL_STATIC)
+            {
+                const ALbuffer *cache = BufferList->buffer->Preresampled;
+                if(cache && (ALuint)cache->Frequency == device->Frequency)
+                    Source->Preresampled = cache;
+            }
         }
         else
             Source->state = AL_PLAYING;
@@ -2623,6 +2937,7 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
         {
             Source->state = AL_STOPPED;
             ATOMIC_STORE(&Source->current_buffer, NULL);
+            Source->Preresampled = NULL;
         }
         Source->Offset = -1.0;
     }
@@ -2634,12 +2949,37 @@ ALvoid SetSourceState(ALsource *Source, ALCcontext *Context, ALenum state)
             Source->position = 0;
             Source->position_fraction = 0;
             ATOMIC_STORE(&Source->current_buffer, ATOMIC_LOAD(&Source->queue));
+            Source->Preresampled = NULL;
         }
         Source->Offset = -1.0;
     }
     ReadUnlock(&Source->queue_lock);
 }
 
+/* GetBufferPosition
+ *
+ * Gets the Source's position in the current buffer, in 32.32 fixed-point
+ * samples of the buffer (rather than of its pre-resampled copy, if the Source
+ * is playing from that).
+ */
+static ALuint64 GetBufferPosition(const ALsource *Source)
+{
+    const ALbuffer *cache = Source->Preresampled;
+    ALuint64 pos, ipos, fpos;
+    ALuint freq;
+
+    pos  = (ALuint64)Source->position << 32;
+    pos |= (ALuint64)Source->position_fraction << (32-FRACTIONBITS);
+    if(!cache)
+        return pos;
+
+    /* Scale the integer and fractional parts separately to avoid overflow. */
+    freq = ATOMIC_LOAD(&Source->queue)->buffer->Frequency;
+    ipos = (pos>>32) * freq;
+    fpos = ((ipos%cache->Frequency) << 32) + (pos&U64(0xffffffff))*freq;
+    return ((ipos/cache->Frequency) << 32) + fpos/cache->Frequency;
+}
+
 /* GetSourceOffset
  *
  * Gets the current read offset for the given Source, in 32.32 fixed-point
@@ -2657,8 +2997,7 @@ static ALint64 GetSourceOffset(const ALsource *Source)
 
     /* NOTE: This is the offset into the *current* buffer, so add the length of
      * any played buffers */
-    readPos  = (ALuint64)Source->position << 32;
-    readPos |= (ALuint64)Source->position_fraction << (32-FRACTIONBITS);
+    readPos = GetBufferPosition(Source);
     BufferList = ATOMIC_LOAD(&Source->queue);
     Current = ATOMIC_LOAD(&Source->current_buffer);
     while(BufferList && BufferList != Current)
@@ -2688,8 +3027,7 @@ static ALdouble GetSourceSecOffset(const ALsource *Source)
 
     /* NOTE: This is the offset into the *current* buffer, so add the length of
      * any played buffers */
-    readPos  = (ALuint64)Source->position << FRACTIONBITS;
-    readPos |= (ALuint64)Source->position_fraction;
+    readPos = GetBufferPosition(Source) >> (32-FRACTIONBITS);
     BufferList = ATOMIC_LOAD(&Source->queue);
     Current = ATOMIC_LOAD(&Source->current_buffer);
     while(BufferList && BufferList != Current)
@@ -2741,7 +3079,7 @@ static ALvoid GetSourceOffsets(const ALsource *Source, ALenum name, ALdouble *of
     /* NOTE: This is the offset into the *current* buffer, so add the length of
      * any played buffers */
     totalBufferLen = 0;
-    readPos = Source->position;
+    readPos = (ALuint)(GetBufferPosition(Source) >> 32);
     BufferList = ATOMIC_LOAD(&Source->queue);
     Current = ATOMIC_LOAD(&Source->current_buffer);
     while(BufferList != NULL)
@@ -2868,6 +3206,15 @@ ALboolean ApplyOffset(ALsource *Source)
 
             Source->position = offset - totalBufferLen;
             Source->position_fraction = 0;
+            if(Source->Preresampled)
+            {
+                /* Round to the nearest sample of the copy, so it can still
+                 * play without resampling. */
+                const ALbuffer *cache = Source->Preresampled;
+                ALuint64 pos = ((ALuint64)Source->position*cache->Frequency +
+                                Buffer->Frequency/2) / Buffer->Frequency;
+                Source->position = (ALuint)minu64(pos, cache->SampleLen-1);
+            }
             return AL_TRUE;
         }
 
@@ -2966,7 +3313,7 @@ ALvoid ReleaseALSources(ALCcontext *Context)
             ALbufferlistitem *next = item->next;
             if(item->buffer != NULL)
                 DecrementRef(&item->buffer->ref);
-            free(item);
+            SlabFree(&Context->BufferListSlabs, item);
             item = next;
         }
 
@@ -2977,8 +3324,6 @@ ALvoid ReleaseALSources(ALCcontext *Context)
             temp->Send[j].Slot = NULL;
         }
 
-        FreeThunkEntry(temp->id);
-        memset(temp, 0, sizeof(*temp));
-        al_free(temp);
+        SlabFree(&Context->SourceSlabs, temp);
     }
 }
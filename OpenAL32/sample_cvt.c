@@ -3,6 +3,7 @@
 
 #include "sample_cvt.h"
 
+#include <string.h>
 #ifdef HAVE_ALLOCA_H
 #include <alloca.h>
 #endif
@@ -286,6 +287,48 @@ static void DecodeIMA4Block(ALshort *dst, const ALima4 *src, ALint numchans, ALs
     }
 }
 
+/* Decodes count samples of one channel from an IMA4 block, after skipping the
+ * first skip samples. The samples are scaled like 16-bit samples for mixing.
+ */
+void DecodeIMA4Samples(ALfloat *dst, const ALubyte *src, ALuint chan, ALuint numchans, ALuint skip, ALuint count)
+{
+    const ALuint end = skip + count;
+    ALint sample, index;
+    ALuint j, k;
+
+    sample  = src[chan*4 + 0];
+    sample |= src[chan*4 + 1] << 8;
+    sample  = (sample^0x8000) - 32768;
+    index  = src[chan*4 + 2];
+    index |= src[chan*4 + 3] << 8;
+    index  = (index^0x8000) - 32768;
+    index  = clampi(index, 0, 88);
+    src += (numchans+chan) * 4;
+
+    if(skip == 0)
+        *(dst++) = sample * (1.0f/32767.0f);
+    for(j = 1;j < end;j += 8)
+    {
+        ALuint code = src[0] | (src[1]<<8) | (src[2]<<16) | ((ALuint)src[3]<<24);
+        src += numchans * 4;
+
+        for(k = 0;k < 8 && j+k < end;k++)
+        {
+            int nibble = code&0xf;
+            code >>= 4;
+
+            sample += IMA4Codeword[nibble] * IMAStep_size[index] / 8;
+            sample = clampi(sample, -32768, 32767);
+
+            index += IMA4Index_adjust[nibble];
+            index = clampi(index, 0, 88);
+
+            if(j+k >= skip)
+                *(dst++) = sample * (1.0f/32767.0f);
+        }
+    }
+}
+
 static void EncodeIMA4Block(ALima4 *dst, const ALshort *src, ALint *sample, ALint *index, ALint numchans, ALsizei align)
 {
     ALsizei j,k,c;
@@ -418,6 +461,66 @@ static void DecodeMSADPCMBlock(ALshort *dst, const ALmsadpcm *src, ALint numchan
     }
 }
 
+/* Decodes count samples of one channel from an MSADPCM block, after skipping
+ * the first skip samples. The samples are scaled like 16-bit samples for
+ * mixing.
+ */
+void DecodeMSADPCMSamples(ALfloat *dst, const ALubyte *src, ALuint chan, ALuint numchans, ALuint skip, ALuint count)
+{
+    const ALubyte *nibbles = src + numchans*7;
+    const ALuint end = skip + count;
+    ALshort samples[2];
+    ALuint blockpred;
+    ALint delta;
+    ALuint j;
+
+    blockpred = minu(src[chan], 6);
+    src += numchans;
+    delta  = src[chan*2 + 0];
+    delta |= src[chan*2 + 1] << 8;
+    delta  = (delta^0x8000) - 0x8000;
+    src += numchans * 2;
+    samples[0]  = src[chan*2 + 0];
+    samples[0] |= src[chan*2 + 1] << 8;
+    samples[0]  = (samples[0]^0x8000) - 0x8000;
+    src += numchans * 2;
+    samples[1]  = src[chan*2 + 0];
+    samples[1] |= src[chan*2 + 1] << 8;
+    samples[1]  = (samples[1]^0x8000) - 0x8000;
+
+    /* Second sample is first. */
+    if(skip == 0)
+        *(dst++) = samples[1] * (1.0f/32767.0f);
+    if(skip <= 1 && end > 1)
+        *(dst++) = samples[0] * (1.0f/32767.0f);
+
+    for(j = 2;j < end;j++)
+    {
+        const ALuint num = (j*numchans) + chan;
+        ALint nibble, pred;
+
+        /* The first nibble is in the upper bits. */
+        if(!(num&1))
+            nibble = (nibbles[num/2 - numchans]>>4)&0x0f;
+        else
+            nibble = nibbles[num/2 - numchans]&0x0f;
+
+        pred  = (samples[0]*MSADPCMAdaptionCoeff[blockpred][0] +
+                 samples[1]*MSADPCMAdaptionCoeff[blockpred][1]) / 256;
+        pred += ((nibble^0x08) - 0x08) * delta;
+        pred  = clampi(pred, -32768, 32767);
+
+        samples[1] = samples[0];
+        samples[0] = pred;
+
+        delta = (MSADPCMAdaption[nibble] * delta) / 256;
+        delta = maxi(16, delta);
+
+        if(j >= skip)
+            *(dst++) = pred * (1.0f/32767.0f);
+    }
+}
+
 /* NOTE: This encoder is pretty dumb/simplistic. Some kind of pre-processing
  * that tries to find the optimal block predictors would be nice, at least. A
  * multi-pass method that can generate better deltas would be good, too. */
@@ -1119,22 +1222,27 @@ DECL_TEMPLATE(ALubyte3)
 
 #undef DECL_TEMPLATE
 
-/* NOTE: We don't store compressed samples internally, so these conversions
- * should never happen. */
-static void Convert_ALima4_ALima4(ALima4* UNUSED(dst), const ALima4* UNUSED(src),
-                                  ALuint UNUSED(numchans), ALuint UNUSED(len),
-                                  ALuint UNUSED(align))
+/* Compressed samples are stored as-is, so they're copied in whole blocks. */
+static void Convert_ALima4_ALima4(ALima4 *dst, const ALima4 *src, ALuint numchans,
+                                  ALuint len, ALuint align)
 {
-    ERR("Unexpected IMA4-to-IMA4 conversion!\n");
+    ALsizei byte_align = ((align-1)/2 + 4) * numchans;
+
+    assert(align > 0 && (len%align) == 0);
+    memcpy(dst, src, len/align * byte_align);
 }
 
-static void Convert_ALmsadpcm_ALmsadpcm(ALmsadpcm* UNUSED(dst), const ALmsadpcm* UNUSED(src),
-                                        ALuint UNUSED(numchans), ALuint UNUSED(len),
-                                        ALuint UNUSED(align))
+static void Convert_ALmsadpcm_ALmsadpcm(ALmsadpcm *dst, const ALmsadpcm *src, ALuint numchans,
+                                        ALuint len, ALuint align)
 {
-    ERR("Unexpected MSADPCM-to-MSADPCM conversion!\n");
+    ALsizei byte_align = ((align-2)/2 + 7) * numchans;
+
+    assert(align > 1 && (len%align) == 0);
+    memcpy(dst, src, len/align * byte_align);
 }
 
+/* NOTE: Compressed samples are never converted to each other. */
+
 static void Convert_ALmsadpcm_ALima4(ALmsadpcm* UNUSED(dst), const ALima4* UNUSED(src),
                                      ALuint UNUSED(numchans), ALuint UNUSED(len),
                                      ALuint UNUSED(align))
@@ -1221,6 +1329,23 @@ DECL_TEMPLATE(ALubyte3)
 
 void ConvertData(ALvoid *dst, enum UserFmtType dstType, const ALvoid *src, enum UserFmtType srcType, ALsizei numchans, ALsizei len, ALsizei align)
 {
+#ifdef HAVE_SSE2
+    if((CPUCapFlags&CPU_CAP_SSE2))
+    {
+        /* Only plain sample types have SSE2 kernels, so the channels can be
+         * treated as one interleaved run, with the leftover samples going
+         * through the normal conversion. */
+        ALsizei count = numchans*len;
+        ALsizei done = ConvertData_SSE2(dst, dstType, src, srcType, count);
+        if(done > 0)
+        {
+            dst = (ALbyte*)dst + done*BytesFromUserFmt(dstType);
+            src = (const ALbyte*)src + done*BytesFromUserFmt(srcType);
+            numchans = 1;
+            len = count - done;
+        }
+    }
+#endif
     switch(dstType)
     {
         case UserFmtByte:
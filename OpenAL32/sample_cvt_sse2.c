@@ -0,0 +1,352 @@
+/**
+ * OpenAL cross platform audio library
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+#include "AL/al.h"
+#include "alBuffer.h"
+#include "sample_cvt.h"
+
+
+/* These kernels must produce exactly the same samples as the scalar Conv_
+ * functions in sample_cvt.c, so the float conversions clamp and truncate the
+ * same way, and NaNs become 0 (as x86's truncating conversion does for the
+ * scalar code). Each kernel only handles whole vectors and returns how many
+ * samples it converted; the caller converts the remainder.
+ */
+
+/* Converts four floats to integers in [-scale-1, scale], matching the clamp
+ * and truncation done by Conv_ALshort_ALfloat and Conv_ALubyte_ALfloat. */
+static inline __m128i ClampFloat(__m128 val, const __m128 scale)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 negone = _mm_set1_ps(-1.0f);
+    __m128 under;
+    __m128i ival;
+
+    val = _mm_and_ps(val, _mm_cmpord_ps(val, val));
+    under = _mm_cmplt_ps(val, negone);
+    val = _mm_max_ps(_mm_min_ps(val, one), negone);
+    ival = _mm_cvttps_epi32(_mm_mul_ps(val, scale));
+    /* Values below -1 go one step past the truncated -scale. */
+    return _mm_add_epi32(ival, _mm_castps_si128(under));
+}
+
+/* Sign-extends the low and high four 16-bit values to 32-bit floats. */
+static inline __m128 ShortsLoToFloat(__m128i val)
+{ return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(val, val), 16)); }
+static inline __m128 ShortsHiToFloat(__m128i val)
+{ return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(val, val), 16)); }
+
+/* Gathers four packed 24-bit samples from the low 12 bytes of val into the
+ * top of each 32-bit lane. */
+static inline __m128i UnpackByte3(__m128i val)
+{
+    __m128i s01 = _mm_unpacklo_epi32(val, _mm_srli_si128(val, 3));
+    __m128i s23 = _mm_unpacklo_epi32(_mm_srli_si128(val, 6), _mm_srli_si128(val, 9));
+    return _mm_slli_epi32(_mm_unpacklo_epi64(s01, s23), 8);
+}
+
+/* Decodes four companded samples, held in the low byte of each 32-bit lane,
+ * to floats. Both codecs store a sign, a 3-bit exponent and a 4-bit mantissa,
+ * and since the decoded magnitude is a small integer times a power of two,
+ * it's built exactly with a float multiply instead of a table lookup (SSE2
+ * has no gather). */
+static inline __m128 DecodeMuLaw4(__m128i val)
+{
+    const __m128i mask3 = _mm_set1_epi32(7);
+    const __m128i mask4 = _mm_set1_epi32(15);
+    __m128i exponent, mantissa, sign;
+    __m128 mag;
+
+    val = _mm_xor_si128(val, _mm_set1_epi32(0xff));
+    sign = _mm_slli_epi32(_mm_and_si128(val, _mm_set1_epi32(0x80)), 24);
+    exponent = _mm_and_si128(_mm_srli_epi32(val, 4), mask3);
+    mantissa = _mm_and_si128(val, mask4);
+
+    /* The sign is applied before removing the bias, so a zero sample comes
+     * out as +0 like the scalar conversion. */
+    mag = _mm_cvtepi32_ps(_mm_add_epi32(_mm_slli_epi32(mantissa, 3), _mm_set1_epi32(0x84)));
+    mag = _mm_mul_ps(_mm_xor_ps(mag, _mm_castsi128_ps(sign)), _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127)), 23)
+    ));
+    return _mm_sub_ps(mag, _mm_xor_ps(_mm_set1_ps(132.0f), _mm_castsi128_ps(sign)));
+}
+
+static inline __m128 DecodeALaw4(__m128i val)
+{
+    const __m128i mask3 = _mm_set1_epi32(7);
+    const __m128i mask4 = _mm_set1_epi32(15);
+    __m128i exponent, mantissa, sign, notzero;
+    __m128 mag;
+
+    val = _mm_xor_si128(val, _mm_set1_epi32(0x55));
+    sign = _mm_slli_epi32(_mm_andnot_si128(val, _mm_set1_epi32(0x80)), 24);
+    exponent = _mm_and_si128(_mm_srli_epi32(val, 4), mask3);
+    mantissa = _mm_and_si128(val, mask4);
+
+    /* A zero exponent is a denormal with no implicit leading bit; the others
+     * have it and are shifted by one less than the exponent. */
+    notzero = _mm_cmpgt_epi32(exponent, _mm_setzero_si128());
+    mag = _mm_cvtepi32_ps(_mm_add_epi32(
+        _mm_add_epi32(_mm_slli_epi32(mantissa, 4), _mm_set1_epi32(8)),
+        _mm_and_si128(notzero, _mm_set1_epi32(0x100))
+    ));
+    mag = _mm_mul_ps(mag, _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_add_epi32(_mm_add_epi32(exponent, notzero), _mm_set1_epi32(127)), 23)
+    ));
+    return _mm_xor_ps(mag, _mm_castsi128_ps(sign));
+}
+
+
+static ALsizei Convert_ALshort_ALfloat_SSE2(ALshort *dst, const ALfloat *src, ALsizei count)
+{
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    ALsizei i;
+
+    for(i = 0;count-i >= 8;i += 8)
+    {
+        __m128i lo = ClampFloat(_mm_loadu_ps(&src[i  ]), scale);
+        __m128i hi = ClampFloat(_mm_loadu_ps(&src[i+4]), scale);
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packs_epi32(lo, hi));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALfloat_ALshort_SSE2(ALfloat *dst, const ALshort *src, ALsizei count)
+{
+    const __m128 scale = _mm_set1_ps(1.0f/32767.0f);
+    ALsizei i;
+
+    for(i = 0;count-i >= 8;i += 8)
+    {
+        __m128i val = _mm_loadu_si128((const __m128i*)&src[i]);
+        _mm_storeu_ps(&dst[i  ], _mm_mul_ps(ShortsLoToFloat(val), scale));
+        _mm_storeu_ps(&dst[i+4], _mm_mul_ps(ShortsHiToFloat(val), scale));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALfloat_ALfloat_SSE2(ALfloat *dst, const ALfloat *src, ALsizei count)
+{
+    ALsizei i;
+
+    for(i = 0;count-i >= 4;i += 4)
+    {
+        __m128 val = _mm_loadu_ps(&src[i]);
+        _mm_storeu_ps(&dst[i], _mm_and_ps(val, _mm_cmpord_ps(val, val)));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALshort_ALubyte_SSE2(ALshort *dst, const ALubyte *src, ALsizei count)
+{
+    const __m128i bias = _mm_set1_epi8(-128);
+    const __m128i zero = _mm_setzero_si128();
+    ALsizei i;
+
+    for(i = 0;count-i >= 16;i += 16)
+    {
+        __m128i val = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&src[i]), bias);
+        _mm_storeu_si128((__m128i*)&dst[i  ], _mm_unpacklo_epi8(zero, val));
+        _mm_storeu_si128((__m128i*)&dst[i+8], _mm_unpackhi_epi8(zero, val));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALubyte_ALshort_SSE2(ALubyte *dst, const ALshort *src, ALsizei count)
+{
+    const __m128i bias = _mm_set1_epi8(-128);
+    ALsizei i;
+
+    for(i = 0;count-i >= 16;i += 16)
+    {
+        __m128i lo = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)&src[i  ]), 8);
+        __m128i hi = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)&src[i+8]), 8);
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_xor_si128(_mm_packs_epi16(lo, hi), bias));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALfloat_ALubyte_SSE2(ALfloat *dst, const ALubyte *src, ALsizei count)
+{
+    const __m128i bias = _mm_set1_epi8(-128);
+    const __m128 scale = _mm_set1_ps(1.0f/127.0f);
+    ALsizei i;
+
+    for(i = 0;count-i >= 16;i += 16)
+    {
+        __m128i val = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&src[i]), bias);
+        __m128i lo = _mm_unpacklo_epi8(val, val);
+        __m128i hi = _mm_unpackhi_epi8(val, val);
+        lo = _mm_srai_epi16(lo, 8);
+        hi = _mm_srai_epi16(hi, 8);
+        _mm_storeu_ps(&dst[i   ], _mm_mul_ps(ShortsLoToFloat(lo), scale));
+        _mm_storeu_ps(&dst[i+ 4], _mm_mul_ps(ShortsHiToFloat(lo), scale));
+        _mm_storeu_ps(&dst[i+ 8], _mm_mul_ps(ShortsLoToFloat(hi), scale));
+        _mm_storeu_ps(&dst[i+12], _mm_mul_ps(ShortsHiToFloat(hi), scale));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALubyte_ALfloat_SSE2(ALubyte *dst, const ALfloat *src, ALsizei count)
+{
+    const __m128i bias = _mm_set1_epi8(-128);
+    const __m128 scale = _mm_set1_ps(127.0f);
+    ALsizei i;
+
+    for(i = 0;count-i >= 16;i += 16)
+    {
+        __m128i v0 = ClampFloat(_mm_loadu_ps(&src[i   ]), scale);
+        __m128i v1 = ClampFloat(_mm_loadu_ps(&src[i+ 4]), scale);
+        __m128i v2 = ClampFloat(_mm_loadu_ps(&src[i+ 8]), scale);
+        __m128i v3 = ClampFloat(_mm_loadu_ps(&src[i+12]), scale);
+        __m128i val = _mm_packs_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_xor_si128(val, bias));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALshort_ALbyte3_SSE2(ALshort *dst, const ALubyte *src, ALsizei count)
+{
+    ALsizei i;
+
+    /* Each load reads 16 bytes for 4 samples, so stop while there's enough
+     * data left to not read past the end. */
+    for(i = 0;count-i >= 10;i += 8)
+    {
+        __m128i lo = UnpackByte3(_mm_loadu_si128((const __m128i*)&src[i*3]));
+        __m128i hi = UnpackByte3(_mm_loadu_si128((const __m128i*)&src[i*3 + 12]));
+        lo = _mm_srai_epi32(lo, 16);
+        hi = _mm_srai_epi32(hi, 16);
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packs_epi32(lo, hi));
+    }
+    return i;
+}
+
+static ALsizei Convert_ALfloat_ALbyte3_SSE2(ALfloat *dst, const ALubyte *src, ALsizei count)
+{
+    const __m128d scale = _mm_set1_pd(1.0/8388607.0);
+    ALsizei i;
+
+    for(i = 0;count-i >= 6;i += 4)
+    {
+        __m128i val = _mm_srai_epi32(UnpackByte3(_mm_loadu_si128((const __m128i*)&src[i*3])), 8);
+        /* The scalar conversion scales in double precision. */
+        __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(val), scale));
+        __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(val, 8)), scale));
+        _mm_storeu_ps(&dst[i], _mm_movelh_ps(lo, hi));
+    }
+    return i;
+}
+
+#define DECL_TEMPLATE(T, D)                                                   \
+static ALsizei Convert_ALfloat_##T##_SSE2(ALfloat *dst, const ALubyte *src,   \
+                                          ALsizei count)                      \
+{                                                                             \
+    const __m128 scale = _mm_set1_ps(1.0f/32767.0f);                          \
+    const __m128i zero = _mm_setzero_si128();                                 \
+    ALsizei i;                                                                \
+                                                                              \
+    for(i = 0;count-i >= 16;i += 16)                                          \
+    {                                                                         \
+        __m128i val = _mm_loadu_si128((const __m128i*)&src[i]);               \
+        __m128i lo = _mm_unpacklo_epi8(val, zero);                            \
+        __m128i hi = _mm_unpackhi_epi8(val, zero);                            \
+        _mm_storeu_ps(&dst[i   ], _mm_mul_ps(D(_mm_unpacklo_epi16(lo, zero)), scale)); \
+        _mm_storeu_ps(&dst[i+ 4], _mm_mul_ps(D(_mm_unpackhi_epi16(lo, zero)), scale)); \
+        _mm_storeu_ps(&dst[i+ 8], _mm_mul_ps(D(_mm_unpacklo_epi16(hi, zero)), scale)); \
+        _mm_storeu_ps(&dst[i+12], _mm_mul_ps(D(_mm_unpackhi_epi16(hi, zero)), scale)); \
+    }                                                                         \
+    return i;                                                                 \
+}                                                                             \
+                                                                              \
+static ALsizei Convert_ALshort_##T##_SSE2(ALshort *dst, const ALubyte *src,   \
+                                          ALsizei count)                      \
+{                                                                             \
+    const __m128i zero = _mm_setzero_si128();                                 \
+    ALsizei i;                                                                \
+                                                                              \
+    for(i = 0;count-i >= 16;i += 16)                                          \
+    {                                                                         \
+        __m128i val = _mm_loadu_si128((const __m128i*)&src[i]);               \
+        __m128i lo = _mm_unpacklo_epi8(val, zero);                            \
+        __m128i hi = _mm_unpackhi_epi8(val, zero);                            \
+        lo = _mm_packs_epi32(_mm_cvttps_epi32(D(_mm_unpacklo_epi16(lo, zero))), \
+                             _mm_cvttps_epi32(D(_mm_unpackhi_epi16(lo, zero)))); \
+        hi = _mm_packs_epi32(_mm_cvttps_epi32(D(_mm_unpacklo_epi16(hi, zero))), \
+                             _mm_cvttps_epi32(D(_mm_unpackhi_epi16(hi, zero)))); \
+        _mm_storeu_si128((__m128i*)&dst[i  ], lo);                            \
+        _mm_storeu_si128((__m128i*)&dst[i+8], hi);                            \
+    }                                                                         \
+    return i;                                                                 \
+}
+
+DECL_TEMPLATE(ALmulaw, DecodeMuLaw4)
+DECL_TEMPLATE(ALalaw, DecodeALaw4)
+
+#undef DECL_TEMPLATE
+
+
+ALsizei ConvertData_SSE2(ALvoid *dst, enum UserFmtType dstType, const ALvoid *src, enum UserFmtType srcType, ALsizei count)
+{
+    switch(dstType)
+    {
+        case UserFmtUByte:
+            switch(srcType)
+            {
+                case UserFmtShort: return Convert_ALubyte_ALshort_SSE2(dst, src, count);
+                case UserFmtFloat: return Convert_ALubyte_ALfloat_SSE2(dst, src, count);
+                default: break;
+            }
+            break;
+
+        case UserFmtShort:
+            switch(srcType)
+            {
+                case UserFmtUByte: return Convert_ALshort_ALubyte_SSE2(dst, src, count);
+                case UserFmtFloat: return Convert_ALshort_ALfloat_SSE2(dst, src, count);
+                case UserFmtMulaw: return Convert_ALshort_ALmulaw_SSE2(dst, src, count);
+                case UserFmtAlaw: return Convert_ALshort_ALalaw_SSE2(dst, src, count);
+                case UserFmtByte3: return Convert_ALshort_ALbyte3_SSE2(dst, src, count);
+                default: break;
+            }
+            break;
+
+        case UserFmtFloat:
+            switch(srcType)
+            {
+                case UserFmtUByte: return Convert_ALfloat_ALubyte_SSE2(dst, src, count);
+                case UserFmtShort: return Convert_ALfloat_ALshort_SSE2(dst, src, count);
+                case UserFmtFloat: return Convert_ALfloat_ALfloat_SSE2(dst, src, count);
+                case UserFmtMulaw: return Convert_ALfloat_ALmulaw_SSE2(dst, src, count);
+                case UserFmtAlaw: return Convert_ALfloat_ALalaw_SSE2(dst, src, count);
+                case UserFmtByte3: return Convert_ALfloat_ALbyte3_SSE2(dst, src, count);
+                default: break;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "alMain.h"
+#include "alu.h"
+#include "sample_cvt.h"
+
+
+/* An offline resampler, for converting whole buffers ahead of time. Since it
+ * isn't run while mixing, it can afford a much longer filter than the mixer's
+ * resamplers: a Kaiser-windowed sinc with 32 zero crossings on each side,
+ * giving around 90dB of stopband attenuation.
+ *
+ * The windowed sinc is tabulated once per call, at SINC_RESOLUTION points per
+ * zero crossing, and linearly interpolated between them.
+ */
+#define SINC_ZERO_CROSSINGS 32
+#define SINC_RESOLUTION     256
+#define SINC_TABLE_SIZE     (SINC_ZERO_CROSSINGS*SINC_RESOLUTION)
+#define KAISER_BETA         9.0
+
+
+/* Zeroth-order modified Bessel function of the first kind. */
+static double BesselI0(double x)
+{
+    double term = 1.0;
+    double sum = 1.0;
+    int k = 1;
+
+    do {
+        double y = x / (2.0*k);
+        term *= y*y;
+        sum += term;
+        k++;
+    } while(term > sum*1e-12);
+
+    return sum;
+}
+
+static void InitSincTable(ALfloat *table)
+{
+    const double scale = 1.0 / BesselI0(KAISER_BETA);
+    ALsizei i;
+
+    table[0] = 1.0f;
+    for(i = 1;i < SINC_TABLE_SIZE;i++)
+    {
+        double x = (double)i / SINC_RESOLUTION;
+        double w = x / SINC_ZERO_CROSSINGS;
+        double sinc = sin(F_PI*x) / (F_PI*x);
+        table[i] = (ALfloat)(sinc * BesselI0(KAISER_BETA*sqrt(1.0 - w*w)) * scale);
+    }
+    /* The window is 0 at the edge, and this also serves as the end point for
+     * interpolating the last entry. */
+    table[SINC_TABLE_SIZE] = 0.0f;
+}
+
+
+/* When downsampling, the cutoff is lowered to the new Nyquist frequency,
+ * which stretches the filter over more source samples.
+ */
+static ALdouble GetResampleCutoff(ALuint dstfreq, ALuint srcfreq)
+{
+    return minf(1.0f, (ALfloat)dstfreq / (ALfloat)srcfreq);
+}
+
+/* Returns how far the filter reaches into the source on each side of an
+ * output sample, in source samples.
+ */
+ALsizei GetResampleTaps(ALuint dstfreq, ALuint srcfreq)
+{
+    return (ALsizei)ceil(SINC_ZERO_CROSSINGS / GetResampleCutoff(dstfreq, srcfreq));
+}
+
+/* Resamples the count output sample frames starting at dstoffset, from a
+ * source at srcfreq to dstfreq. dst receives those count frames, while src
+ * holds srccount frames of the source starting at srcoffset, all with the
+ * given number of interleaved channels. Source samples outside of what src
+ * holds are taken as silence, so it should cover the filter's reach for the
+ * output frames within the source (see GetResampleTaps).
+ *
+ * Returns AL_FALSE if the filter table couldn't be allocated.
+ */
+ALboolean ResampleSamples(ALfloat *dst, ALsizei dstoffset, ALsizei count, ALuint dstfreq, const ALfloat *src, ALsizei srcoffset, ALsizei srccount, ALuint srcfreq, ALsizei channels)
+{
+    ALdouble sums[MAX_INPUT_CHANNELS];
+    ALfloat *table;
+    ALdouble cutoff;
+    ALsizei taps;
+    ALsizei i, j, c;
+
+    table = malloc((SINC_TABLE_SIZE+1) * sizeof(table[0]));
+    if(!table) return AL_FALSE;
+    InitSincTable(table);
+
+    cutoff = GetResampleCutoff(dstfreq, srcfreq);
+    taps = GetResampleTaps(dstfreq, srcfreq);
+
+    for(i = dstoffset;i < dstoffset+count;i++)
+    {
+        ALuint64 pos = (ALuint64)i * srcfreq;
+        ALsizei ipos = (ALsizei)(pos / dstfreq);
+        ALdouble frac = (ALdouble)(pos % dstfreq) / dstfreq;
+        ALsizei start = maxi(ipos-taps+1, srcoffset);
+        ALsizei end = mini(ipos+taps, srcoffset+srccount-1);
+
+        for(c = 0;c < channels;c++)
+            sums[c] = 0.0;
+        for(j = start;j <= end;j++)
+        {
+            const ALfloat *in = &src[(j-srcoffset)*channels];
+            ALdouble x = fabs((j-ipos) - frac) * cutoff * SINC_RESOLUTION;
+            ALsizei k = (ALsizei)x;
+            ALfloat mu = (ALfloat)(x - k);
+            ALfloat weight;
+
+            if(k >= SINC_TABLE_SIZE)
+                continue;
+            weight = lerp(table[k], table[k+1], mu);
+            for(c = 0;c < channels;c++)
+                sums[c] += in[c] * weight;
+        }
+        for(c = 0;c < channels;c++)
+            dst[(i-dstoffset)*channels + c] = (ALfloat)(sums[c] * cutoff);
+    }
+
+    free(table);
+    return AL_TRUE;
+}
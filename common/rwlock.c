@@ -7,6 +7,7 @@
 #include "atomic.h"
 #include "threads.h"
 
+#ifdef USE_SPIN_RWLOCK
 
 /* A simple spinlock. Yield the thread while the given integer is set by
  * another. Could probably be improved... */
@@ -55,3 +56,183 @@ void WriteUnlock(RWLock *lock)
     if(DecrementRef(&lock->write_count) == 0)
         UNLOCK(lock->read_lock);
 }
+
+#else
+
+#include <limits.h>
+
+#ifdef HAVE_LINUX_FUTEX_H
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+
+/* A blocking read-write lock. The whole lock state is kept in one integer:
+ * the reader count in the upper bits, and flags for a writer holding the lock
+ * and for threads waiting on it. Threads that can't get the lock spin for a
+ * little while, in case it's only held briefly, before going to sleep until
+ * the state changes. Unlocking only needs to wake anyone when the waiting flag
+ * is set.
+ */
+#define RWLOCK_WRITER  1
+#define RWLOCK_WAITING 2
+#define RWLOCK_READER  4
+
+#define RWLOCK_SPIN_COUNT 100
+
+
+#ifdef HAVE_LINUX_FUTEX_H
+
+static void WaitState(RWLock *lock, int state)
+{
+    syscall(SYS_futex, (int*)&lock->state, FUTEX_WAIT_PRIVATE, state, NULL, NULL, 0);
+}
+
+static void WakeState(RWLock *lock)
+{
+    syscall(SYS_futex, (int*)&lock->state, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+#else
+
+/* Without futexes, waiting threads sleep on one of a few condition variables
+ * shared by all locks, picked by the lock's address. */
+#define PARK_BUCKET_COUNT 16
+
+static struct {
+    almtx_t mtx;
+    alcnd_t cnd;
+} ParkBuckets[PARK_BUCKET_COUNT];
+static alonce_flag ParkBucketsOnce = AL_ONCE_FLAG_INIT;
+
+static void InitParkBuckets(void)
+{
+    int i;
+    for(i = 0;i < PARK_BUCKET_COUNT;i++)
+    {
+        almtx_init(&ParkBuckets[i].mtx, almtx_plain);
+        alcnd_init(&ParkBuckets[i].cnd);
+    }
+}
+
+static int GetParkBucket(RWLock *lock)
+{
+    alcall_once(&ParkBucketsOnce, InitParkBuckets);
+    return (int)(((size_t)lock / sizeof(RWLock)) % PARK_BUCKET_COUNT);
+}
+
+static void WaitState(RWLock *lock, int state)
+{
+    int b = GetParkBucket(lock);
+    almtx_lock(&ParkBuckets[b].mtx);
+    if(ATOMIC_LOAD(&lock->state) == state)
+        alcnd_wait(&ParkBuckets[b].cnd, &ParkBuckets[b].mtx);
+    almtx_unlock(&ParkBuckets[b].mtx);
+}
+
+static void WakeState(RWLock *lock)
+{
+    int b = GetParkBucket(lock);
+    almtx_lock(&ParkBuckets[b].mtx);
+    alcnd_broadcast(&ParkBuckets[b].cnd);
+    almtx_unlock(&ParkBuckets[b].mtx);
+}
+
+#endif
+
+
+void RWLockInit(RWLock *lock)
+{
+    ATOMIC_INIT(&lock->state, 0);
+    ATOMIC_INIT(&lock->write_waiters, 0);
+}
+
+void ReadLock(RWLock *lock)
+{
+    int spins = RWLOCK_SPIN_COUNT;
+    int state;
+
+    while(1)
+    {
+        state = ATOMIC_LOAD(&lock->state);
+        if(!(state&RWLOCK_WRITER) && ATOMIC_LOAD(&lock->write_waiters) == 0)
+        {
+            if(ATOMIC_COMPARE_EXCHANGE_WEAK(int, &lock->state, &state, state+RWLOCK_READER))
+                break;
+            continue;
+        }
+        if(spins > 0)
+        {
+            spins--;
+            continue;
+        }
+
+        /* Set the waiting flag so the thread holding the lock knows to wake
+         * us, then sleep unless the state changed in the mean time. */
+        if(!(state&RWLOCK_WAITING))
+        {
+            if(!ATOMIC_COMPARE_EXCHANGE_WEAK(int, &lock->state, &state, state|RWLOCK_WAITING))
+                continue;
+            state |= RWLOCK_WAITING;
+        }
+        /* The writers we're waiting for may not be in the state. If they all
+         * came and went before the flag was set, nothing would wake us, so
+         * check again. Writers stop counting themselves before unlocking, so
+         * this can't miss one that unlocked without seeing the flag. */
+        if(!(state&RWLOCK_WRITER) && ATOMIC_LOAD(&lock->write_waiters) == 0)
+            continue;
+        WaitState(lock, state);
+    }
+}
+
+void ReadUnlock(RWLock *lock)
+{
+    int state = ATOMIC_SUB(int, &lock->state, RWLOCK_READER) - RWLOCK_READER;
+    /* The last reader out wakes any waiting threads. If the state changes
+     * before the flag is cleared, whoever changed it is left to do that. */
+    if(state == RWLOCK_WAITING && ATOMIC_COMPARE_EXCHANGE_STRONG(int, &lock->state, &state, 0))
+        WakeState(lock);
+}
+
+void WriteLock(RWLock *lock)
+{
+    int spins = RWLOCK_SPIN_COUNT;
+    int state;
+
+    ATOMIC_ADD(int, &lock->write_waiters, 1);
+    while(1)
+    {
+        state = ATOMIC_LOAD(&lock->state);
+        if(!(state&~RWLOCK_WAITING))
+        {
+            /* Keep the waiting flag, so unlocking wakes the waiting threads. */
+            if(ATOMIC_COMPARE_EXCHANGE_WEAK(int, &lock->state, &state, state|RWLOCK_WRITER))
+                break;
+            continue;
+        }
+        if(spins > 0)
+        {
+            spins--;
+            continue;
+        }
+
+        if(!(state&RWLOCK_WAITING))
+        {
+            if(!ATOMIC_COMPARE_EXCHANGE_WEAK(int, &lock->state, &state, state|RWLOCK_WAITING))
+                continue;
+            state |= RWLOCK_WAITING;
+        }
+        WaitState(lock, state);
+    }
+    ATOMIC_SUB(int, &lock->write_waiters, 1);
+}
+
+void WriteUnlock(RWLock *lock)
+{
+    int state = ATOMIC_EXCHANGE(int, &lock->state, 0);
+    if((state&RWLOCK_WAITING))
+        WakeState(lock);
+}
+
+#endif
@@ -13,18 +13,107 @@ extern inline void LockUIntMapWrite(UIntMap *map);
 extern inline void UnlockUIntMapWrite(UIntMap *map);
 
 
+/* Gets the segment and slot index for the given key. */
+static ALuint GetSlotSegment(ALuint key, ALuint *idx)
+{
+    ALuint n = key/UINTMAP_SEGMENT_BASE + 1;
+    ALuint seg;
+#if defined(__GNUC__)
+    seg = 31 - __builtin_clz(n);
+#else
+    seg = 0;
+    while(n > 1)
+    {
+        n >>= 1;
+        seg++;
+    }
+#endif
+    *idx = key - UINTMAP_SEGMENT_BASE*((1u<<seg)-1);
+    return seg;
+}
+
+/* Finds the position of the key in the sorted array, or where it would be
+ * inserted. Must be called with the lock held. */
+static ALsizei FindUIntMapPos(const UIntMap *map, ALuint key)
+{
+    ALsizei low = 0;
+    if(map->size > 0)
+    {
+        ALsizei high = map->size - 1;
+        while(low < high)
+        {
+            ALsizei mid = low + (high-low)/2;
+            if(map->array[mid].key < key)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if(map->array[low].key < key)
+            low++;
+    }
+    return low;
+}
+
+/* Adds the slot segment for the key, if there is none yet and enough keys
+ * are in use for it to be worth the memory. The first segment is always
+ * added, since it's small and object IDs start there. Must be called with the
+ * write lock held. */
+static void AddUIntMapSegment(UIntMap *map, ALuint key)
+{
+    UIntMapSlot *slots;
+    ALuint seg, idx;
+    ALuint first, count;
+    ALsizei pos;
+
+    seg = GetSlotSegment(key, &idx);
+    if(seg >= UINTMAP_SEGMENT_COUNT || ATOMIC_LOAD(&map->slots[seg]) != NULL)
+        return;
+    count = (ALuint)UINTMAP_SEGMENT_BASE << seg;
+    if(seg > 0 && (ALuint)map->size < count/4)
+        return;
+
+    slots = malloc(count * sizeof(slots[0]));
+    if(!slots) return;
+    for(idx = 0;idx < count;idx++)
+        ATOMIC_INIT(&slots[idx], NULL);
+
+    /* Fill in the keys already in the segment's range before it's visible to
+     * readers. */
+    first = UINTMAP_SEGMENT_BASE*((1u<<seg)-1);
+    for(pos = FindUIntMapPos(map, first);pos < map->size;pos++)
+    {
+        if(map->array[pos].key-first >= count)
+            break;
+        ATOMIC_INIT(&slots[map->array[pos].key-first], map->array[pos].value);
+    }
+
+    ATOMIC_STORE(&map->slots[seg], slots);
+}
+
+
 void InitUIntMap(UIntMap *map, ALsizei limit)
 {
+    ALuint i;
+
     map->array = NULL;
     map->size = 0;
     map->maxsize = 0;
     map->limit = limit;
     RWLockInit(&map->lock);
+    for(i = 0;i < UINTMAP_SEGMENT_COUNT;i++)
+        ATOMIC_INIT(&map->slots[i], NULL);
 }
 
 void ResetUIntMap(UIntMap *map)
 {
+    ALuint i;
+
     WriteLock(&map->lock);
+    for(i = 0;i < UINTMAP_SEGMENT_COUNT;i++)
+    {
+        UIntMapSlot *slots = ATOMIC_EXCHANGE(UIntMapSlot*, &map->slots[i], NULL);
+        free(slots);
+    }
     free(map->array);
     map->array = NULL;
     map->size = 0;
@@ -34,26 +123,12 @@ void ResetUIntMap(UIntMap *map)
 
 ALenum InsertUIntMapEntry(UIntMap *map, ALuint key, ALvoid *value)
 {
-    ALsizei pos = 0;
+    UIntMapSlot *slots;
+    ALuint seg, idx;
+    ALsizei pos;
 
     WriteLock(&map->lock);
-    if(map->size > 0)
-    {
-        ALsizei low = 0;
-        ALsizei high = map->size - 1;
-        while(low < high)
-        {
-            ALsizei mid = low + (high-low)/2;
-            if(map->array[mid].key < key)
-                low = mid + 1;
-            else
-                high = mid;
-        }
-        if(map->array[low].key < key)
-            low++;
-        pos = low;
-    }
-
+    pos = FindUIntMapPos(map, key);
     if(pos == map->size || map->array[pos].key != key)
     {
         if(map->size == map->limit)
@@ -86,6 +161,15 @@ ALenum InsertUIntMapEntry(UIntMap *map, ALuint key, ALvoid *value)
     }
     map->array[pos].key = key;
     map->array[pos].value = value;
+
+    seg = GetSlotSegment(key, &idx);
+    if(seg < UINTMAP_SEGMENT_COUNT)
+    {
+        if((slots=ATOMIC_LOAD(&map->slots[seg])) != NULL)
+            ATOMIC_STORE(&slots[idx], value);
+        else
+            AddUIntMapSegment(map, key);
+    }
     WriteUnlock(&map->lock);
 
     return AL_NO_ERROR;
@@ -94,51 +178,45 @@ ALenum InsertUIntMapEntry(UIntMap *map, ALuint key, ALvoid *value)
 ALvoid *RemoveUIntMapKey(UIntMap *map, ALuint key)
 {
     ALvoid *ptr = NULL;
+    UIntMapSlot *slots;
+    ALuint seg, idx;
+    ALsizei pos;
+
     WriteLock(&map->lock);
-    if(map->size > 0)
+    pos = FindUIntMapPos(map, key);
+    if(pos < map->size && map->array[pos].key == key)
     {
-        ALsizei low = 0;
-        ALsizei high = map->size - 1;
-        while(low < high)
-        {
-            ALsizei mid = low + (high-low)/2;
-            if(map->array[mid].key < key)
-                low = mid + 1;
-            else
-                high = mid;
-        }
-        if(map->array[low].key == key)
-        {
-            ptr = map->array[low].value;
-            if(low < map->size-1)
-                memmove(&map->array[low], &map->array[low+1],
-                        (map->size-1-low)*sizeof(map->array[0]));
-            map->size--;
-        }
+        ptr = map->array[pos].value;
+        if(pos < map->size-1)
+            memmove(&map->array[pos], &map->array[pos+1],
+                    (map->size-1-pos)*sizeof(map->array[0]));
+        map->size--;
+
+        seg = GetSlotSegment(key, &idx);
+        if(seg < UINTMAP_SEGMENT_COUNT && (slots=ATOMIC_LOAD(&map->slots[seg])) != NULL)
+            ATOMIC_STORE(&slots[idx], NULL);
     }
     WriteUnlock(&map->lock);
     return ptr;
 }
 
+/* Keys in a segment's range are looked up straight from its slots, without
+ * taking the lock. Others need a search of the sorted array. */
 ALvoid *LookupUIntMapKey(UIntMap *map, ALuint key)
 {
     ALvoid *ptr = NULL;
+    UIntMapSlot *slots;
+    ALuint seg, idx;
+    ALsizei pos;
+
+    seg = GetSlotSegment(key, &idx);
+    if(seg < UINTMAP_SEGMENT_COUNT && (slots=ATOMIC_LOAD(&map->slots[seg])) != NULL)
+        return ATOMIC_LOAD(&slots[idx]);
+
     ReadLock(&map->lock);
-    if(map->size > 0)
-    {
-        ALsizei low = 0;
-        ALsizei high = map->size - 1;
-        while(low < high)
-        {
-            ALsizei mid = low + (high-low)/2;
-            if(map->array[mid].key < key)
-                low = mid + 1;
-            else
-                high = mid;
-        }
-        if(map->array[low].key == key)
-            ptr = map->array[low].value;
-    }
+    pos = FindUIntMapPos(map, key);
+    if(pos < map->size && map->array[pos].key == key)
+        ptr = map->array[pos].value;
     ReadUnlock(&map->lock);
     return ptr;
 }
@@ -8,6 +8,7 @@
 extern "C" {
 #endif
 
+#ifdef USE_SPIN_RWLOCK
 typedef struct {
     RefCount read_count;
     RefCount write_count;
@@ -18,6 +19,17 @@ typedef struct {
 #define RWLOCK_STATIC_INITIALIZE { ATOMIC_INIT_STATIC(0), ATOMIC_INIT_STATIC(0),         \
                                    ATOMIC_INIT_STATIC(false), ATOMIC_INIT_STATIC(false), \
                                    ATOMIC_INIT_STATIC(false) }
+#else
+typedef struct {
+    /* The number of readers holding the lock, with flags for whether a writer
+     * holds it and whether any thread is waiting on it. */
+    ATOMIC(int) state;
+    /* The number of writers waiting for the lock. New readers wait while
+     * there are any, so writers aren't starved. */
+    ATOMIC(int) write_waiters;
+} RWLock;
+#define RWLOCK_STATIC_INITIALIZE { ATOMIC_INIT_STATIC(0), ATOMIC_INIT_STATIC(0) }
+#endif
 
 void RWLockInit(RWLock *lock);
 void ReadLock(RWLock *lock);
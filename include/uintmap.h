@@ -8,6 +8,15 @@
 extern "C" {
 #endif
 
+/* Keys are also indexed directly in segments of slots, which can be read
+ * without locking. Segment n holds UINTMAP_SEGMENT_BASE<<n slots, and
+ * segments are only added for key ranges that are densely used. Keys beyond
+ * the last segment are only kept in the sorted array. */
+#define UINTMAP_SEGMENT_BASE  64
+#define UINTMAP_SEGMENT_COUNT 20
+
+typedef ATOMIC(ALvoid*) UIntMapSlot;
+
 typedef struct UIntMap {
     struct {
         ALuint key;
@@ -17,8 +26,10 @@ typedef struct UIntMap {
     ALsizei maxsize;
     ALsizei limit;
     RWLock lock;
+
+    ATOMIC(UIntMapSlot*) slots[UINTMAP_SEGMENT_COUNT];
 } UIntMap;
-#define UINTMAP_STATIC_INITIALIZE_N(_n) { NULL, 0, 0, (_n), RWLOCK_STATIC_INITIALIZE }
+#define UINTMAP_STATIC_INITIALIZE_N(_n) { NULL, 0, 0, (_n), RWLOCK_STATIC_INITIALIZE, { ATOMIC_INIT_STATIC(NULL) } }
 #define UINTMAP_STATIC_INITIALIZE UINTMAP_STATIC_INITIALIZE_N(~0)
 
 void InitUIntMap(UIntMap *map, ALsizei limit);
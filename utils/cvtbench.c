@@ -0,0 +1,175 @@
+/*
+ * Sample conversion benchmark
+ *
+ * Times ConvertData for every source and destination sample type pair, with
+ * and without the CPU extensions, and checks both give the same samples.
+ *
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alMain.h"
+#include "alu.h"
+#include "alBuffer.h"
+#include "sample_cvt.h"
+#include "threads.h"
+
+
+/* A multiple of both ADPCM block alignments used below. The other types
+ * convert a few samples less, so the vector kernels have a remainder to deal
+ * with. */
+#define IMA4_ALIGN    65
+#define MSADPCM_ALIGN 64
+#define NUM_SAMPLES   (IMA4_ALIGN*MSADPCM_ALIGN*16)
+#define NUM_REPEATS   20
+
+static const struct {
+    enum UserFmtType type;
+    const char name[8];
+} Types[] = {
+    { UserFmtByte,    "s8"      },
+    { UserFmtUByte,   "u8"      },
+    { UserFmtShort,   "s16"     },
+    { UserFmtUShort,  "u16"     },
+    { UserFmtInt,     "s32"     },
+    { UserFmtUInt,    "u32"     },
+    { UserFmtFloat,   "f32"     },
+    { UserFmtDouble,  "f64"     },
+    { UserFmtByte3,   "s24"     },
+    { UserFmtUByte3,  "u24"     },
+    { UserFmtMulaw,   "mulaw"   },
+    { UserFmtAlaw,    "alaw"    },
+    { UserFmtIMA4,    "ima4"    },
+    { UserFmtMSADPCM, "msadpcm" },
+};
+
+static alignas(16) ALfloat Noise[NUM_SAMPLES];
+static alignas(16) ALubyte Source[NUM_SAMPLES*8];
+static alignas(16) ALubyte Output[2][NUM_SAMPLES*8];
+
+
+static double GetTime(void)
+{
+    struct timespec ts;
+    altimespec_get(&ts, AL_TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec/1000000000.0;
+}
+
+static ALfloat RandomFloat(void)
+{
+    return (ALfloat)rand()/RAND_MAX*2.0f - 1.0f;
+}
+
+static ALboolean IsADPCM(enum UserFmtType type)
+{
+    return type == UserFmtIMA4 || type == UserFmtMSADPCM;
+}
+
+static ALsizei GetAlign(enum UserFmtType type)
+{
+    if(type == UserFmtIMA4) return IMA4_ALIGN;
+    if(type == UserFmtMSADPCM) return MSADPCM_ALIGN;
+    return 1;
+}
+
+static size_t GetByteSize(enum UserFmtType type, ALsizei len)
+{
+    if(type == UserFmtIMA4)
+        return (size_t)len/IMA4_ALIGN * ((IMA4_ALIGN-1)/2 + 4);
+    if(type == UserFmtMSADPCM)
+        return (size_t)len/MSADPCM_ALIGN * ((MSADPCM_ALIGN-2)/2 + 7);
+    return (size_t)len * BytesFromUserFmt(type);
+}
+
+
+static double TimeConvert(ALuint caps, ALubyte *out, enum UserFmtType dstType,
+                          enum UserFmtType srcType, ALsizei len, ALsizei align)
+{
+    double start;
+    ALuint n;
+
+    FillCPUCaps(caps);
+    start = GetTime();
+    for(n = 0;n < NUM_REPEATS;n++)
+        ConvertData(out, dstType, Source, srcType, 1, len, align);
+    return (GetTime() - start) / NUM_REPEATS / len * 1000000000.0;
+}
+
+
+int main(void)
+{
+    ALuint mismatches = 0;
+    size_t s, d, i;
+
+    for(i = 0;i < NUM_SAMPLES;i++)
+        Noise[i] = RandomFloat() * 1.1f;
+
+    printf("%d samples, ns per sample\n", NUM_SAMPLES);
+    for(s = 0;s < COUNTOF(Types);s++)
+    {
+        enum UserFmtType srcType = Types[s].type;
+
+        FillCPUCaps(0);
+        ConvertData(Source, srcType, Noise, UserFmtFloat, 1, NUM_SAMPLES, GetAlign(srcType));
+        /* Mix in some arbitrary bit patterns, to cover clipping, NaNs and
+         * every companded code. ADPCM blocks are left intact since their
+         * headers need to be valid. */
+        if(!IsADPCM(srcType))
+        {
+            for(i = 0;i < 4096;i++)
+                Source[i] = rand()&0xff;
+        }
+
+        for(d = 0;d < COUNTOF(Types);d++)
+        {
+            enum UserFmtType dstType = Types[d].type;
+            ALsizei align = maxi(GetAlign(srcType), GetAlign(dstType));
+            ALsizei len = (align > 1) ? NUM_SAMPLES : NUM_SAMPLES-3;
+            size_t size = GetByteSize(dstType, len);
+            double tc, tsimd;
+
+            /* Converting between ADPCM types isn't supported. */
+            if(IsADPCM(srcType) && IsADPCM(dstType) && srcType != dstType)
+                continue;
+
+            memset(Output, 0, sizeof(Output));
+            tc = TimeConvert(0, Output[0], dstType, srcType, len, align);
+            tsimd = TimeConvert(~0u, Output[1], dstType, srcType, len, align);
+
+            printf("%-7s -> %-7s  C %6.2f  default %6.2f  (%.2fx)", Types[s].name,
+                   Types[d].name, tc, tsimd, tc/tsimd);
+            if(memcmp(Output[0], Output[1], size) != 0)
+            {
+                printf("  MISMATCH");
+                mismatches++;
+            }
+            printf("\n");
+        }
+    }
+
+    if(mismatches > 0)
+    {
+        printf("%u conversion(s) did not match the C output\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
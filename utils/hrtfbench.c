@@ -0,0 +1,179 @@
+/*
+ * HRTF mixing benchmark
+ *
+ * Compares the time-domain HRTF mixer against the partitioned convolver used
+ * for the device's virtual HRTF channels, at a few HRIR lengths.
+ *
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alMain.h"
+#include "alu.h"
+#include "threads.h"
+
+#include "mixer_defs.h"
+
+
+/* Four virtual channels, as used for the B-Format HRTF decode. */
+#define NUM_CHANNELS 4
+#define UPDATE_SIZE  1024
+#define NUM_UPDATES  2000
+
+
+typedef struct BenchState {
+    HrtfParams Params[NUM_CHANNELS];
+    HrtfState State[NUM_CHANNELS];
+    HrtfConvolver *Conv;
+    ALuint Offset;
+} BenchState;
+
+static alignas(16) ALfloat Input[NUM_CHANNELS][BUFFERSIZE];
+static alignas(16) ALfloat Output[2][2][BUFFERSIZE];
+
+
+static double GetTime(void)
+{
+    struct timespec ts;
+    altimespec_get(&ts, AL_TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec/1000000000.0;
+}
+
+static ALfloat RandomFloat(void)
+{
+    return (ALfloat)rand()/RAND_MAX*2.0f - 1.0f;
+}
+
+
+static void InitState(BenchState *state, ALuint irsize, ALboolean useconv)
+{
+    ALuint c, i;
+
+    memset(state, 0, sizeof(*state));
+    srand(irsize);
+    for(c = 0;c < NUM_CHANNELS;c++)
+    {
+        /* A decaying noise response, with a small interaural delay. */
+        for(i = 0;i < irsize;i++)
+        {
+            ALfloat env = powf(0.001f, (ALfloat)i/irsize);
+            state->Params[c].Coeffs[i][0] = RandomFloat() * env;
+            state->Params[c].Coeffs[i][1] = RandomFloat() * env;
+        }
+        state->Params[c].Delay[0] = (rand()%32)<<HRTFDELAY_BITS;
+        state->Params[c].Delay[1] = (rand()%32)<<HRTFDELAY_BITS;
+    }
+    if(useconv)
+        state->Conv = CreateHrtfConvolver(state->Params, NUM_CHANNELS, irsize);
+}
+
+static void MixUpdate(BenchState *state, HrtfMixerFunc HrtfMix, ALuint irsize,
+                      ALfloat (*restrict out)[BUFFERSIZE])
+{
+    ALuint c;
+
+    if(state->Conv)
+        irsize = minu(irsize, HRTF_CONV_BLOCK_SIZE);
+    for(c = 0;c < NUM_CHANNELS;c++)
+        HrtfMix(out, Input[c], 0, state->Offset, 0, irsize, &state->Params[c],
+                &state->State[c], UPDATE_SIZE);
+    if(state->Conv)
+        MixHrtfConvolver(state->Conv, out, Input, UPDATE_SIZE);
+    state->Offset += UPDATE_SIZE;
+}
+
+static void RunBench(HrtfMixerFunc HrtfMix, ALuint irsize)
+{
+    BenchState direct, conv;
+    double start, tdirect, tconv;
+    ALfloat maxerr = 0.0f;
+    ALuint c, i, n;
+
+    InitState(&direct, irsize, AL_FALSE);
+    InitState(&conv, irsize, AL_TRUE);
+
+    /* Check both paths give the same output. */
+    for(n = 0;n < 16;n++)
+    {
+        for(c = 0;c < NUM_CHANNELS;c++)
+        {
+            for(i = 0;i < UPDATE_SIZE;i++)
+                Input[c][i] = RandomFloat();
+        }
+        memset(Output, 0, sizeof(Output));
+        MixUpdate(&direct, HrtfMix, irsize, Output[0]);
+        MixUpdate(&conv, HrtfMix, irsize, Output[1]);
+        for(i = 0;i < UPDATE_SIZE;i++)
+        {
+            maxerr = maxf(maxerr, fabsf(Output[0][0][i] - Output[1][0][i]));
+            maxerr = maxf(maxerr, fabsf(Output[0][1][i] - Output[1][1][i]));
+        }
+    }
+
+    start = GetTime();
+    for(n = 0;n < NUM_UPDATES;n++)
+        MixUpdate(&direct, HrtfMix, irsize, Output[0]);
+    tdirect = GetTime() - start;
+
+    start = GetTime();
+    for(n = 0;n < NUM_UPDATES;n++)
+        MixUpdate(&conv, HrtfMix, irsize, Output[1]);
+    tconv = GetTime() - start;
+
+    printf("%4u taps: time-domain %7.2f ms, %s %7.2f ms (%.2fx), max error %g\n",
+           irsize, tdirect*1000.0, conv.Conv ? "partitioned" : "(not used) ",
+           tconv*1000.0, tdirect/tconv, maxerr);
+
+    DestroyHrtfConvolver(conv.Conv);
+}
+
+
+int main(void)
+{
+    static const ALuint IrSizes[] = { 32, 64, 128 };
+    HrtfMixerFunc HrtfMix = MixHrtf_C;
+    const char *name = "C";
+    size_t i;
+
+    FillCPUCaps(~0u);
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+    {
+        HrtfMix = MixHrtf_SSE;
+        name = "SSE";
+    }
+#endif
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+    {
+        HrtfMix = MixHrtf_Neon;
+        name = "Neon";
+    }
+#endif
+
+    printf("%d channels, %d updates of %d samples, MixHrtf_%s\n", NUM_CHANNELS,
+           NUM_UPDATES, UPDATE_SIZE, name);
+    for(i = 0;i < COUNTOF(IrSizes);i++)
+        RunBench(HrtfMix, IrSizes[i]);
+
+    return 0;
+}
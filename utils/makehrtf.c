@@ -69,6 +69,11 @@
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
 #endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "threads.h"
 
 // Rely (if naively) on OpenAL's header for the types used for serialization.
 #include "AL/al.h"
@@ -171,6 +176,14 @@
 #define DEFAULT_TRUNCSIZE            (32)
 #define DEFAULT_HEAD_MODEL           (HM_DATASET)
 #define DEFAULT_CUSTOM_RADIUS        (0.0)
+#define DEFAULT_MHR_VERSION          (2)
+#define DEFAULT_THREADS              (0)
+
+// The maximum number of output rates that can be given on the command line.
+#define MAX_OUT_RATES                (8)
+
+// The maximum number of threads used for processing the HRIRs.
+#define MAX_THREADS                  (64)
 
 // The four-character-codes for RIFF/RIFX WAVE file chunks.
 #define FOURCC_RIFF                  (0x46464952) // 'RIFF'
@@ -190,9 +203,14 @@
 // The maximum propagation delay value supported by OpenAL Soft.
 #define MAX_HRTD                     (63.0)
 
-// The OpenAL Soft HRTF format marker.  It stands for minimum-phase head
-// response protocol 01.
+// The OpenAL Soft HRTF format markers.  They stand for minimum-phase head
+// response protocol 01 and 02.
 #define MHR_FORMAT                   ("MinPHR01")
+#define MHR_FORMAT_V2                ("MinPHR02")
+
+// The size of the v2 header, and the alignment of its coefficient table.
+#define MHR_V2_HEADER_SIZE           (32)
+#define MHR_V2_ALIGNMENT             (16)
 
 // Byte order for the serialization routines.
 enum ByteOrderT {
@@ -251,6 +269,7 @@ typedef struct TokenReaderT          TokenReaderT;
 typedef struct SourceRefT            SourceRefT;
 typedef struct HrirDataT             HrirDataT;
 typedef struct ResamplerT            ResamplerT;
+typedef struct HrirWorkerT           HrirWorkerT;
 
 // Token reader state for parsing the data set definition.
 struct TokenReaderT {
@@ -303,6 +322,21 @@ struct ResamplerT {
   double                           * mF;
 };
 
+/* A routine that processes one HRIR of a set, given the offset of the HRIR
+ * and a scratch buffer that's twice the FFT size (or the HRIR size, if
+ * larger).  Used to split the work on an HRIR set between threads.
+ */
+typedef void (* HrirFuncT) (const HrirDataT * hData, const uint j, double * scratch, void * arg);
+
+// The state for a thread processing a range of HRIRs.
+struct HrirWorkerT {
+  const HrirDataT                  * mData;
+  HrirFuncT                          mFunc;
+  void                             * mArg;
+  uint                               mStart,
+                                     mEnd;
+};
+
 /* Token reader routines for parsing text files.  Whitespace is not
  * significant.  It can process tokens as identifiers, numbers (integer and
  * floating-point), strings, and operators.  Strings must be encapsulated by
@@ -814,17 +848,64 @@ static void ComplexExp (const double inR, const double inI, double * outR, doubl
 /* Fast Fourier transform routines.  The number of points must be a power of
  * two.  In-place operation is possible only if both the real and imaginary
  * parts are in-place together.
+ *
+ * The bit-reversal and twiddle factor tables for the FFT size are made once by
+ * FftSetup, and are only read by the transforms.  This allows the transforms
+ * to be run from multiple threads at once (after the setup).
  */
 
+// The tables for the current FFT size.
+static uint FftSetupSize = 0;
+static uint * FftRevTable = NULL;
+static double * FftCosTable = NULL;
+
+// Prepares the tables for transforms of the given size.
+static void FftSetup (const uint n) {
+  uint k, rk, m;
+
+  if (n == FftSetupSize)
+     return;
+  free (FftRevTable);
+  DestroyArray (FftCosTable);
+  FftRevTable = (uint *) calloc (n, sizeof (uint));
+  // The cosine table covers a full period, so the sines can be found by
+  // offsetting it by a quarter.
+  FftCosTable = CreateArray (n);
+  if (FftRevTable == NULL) {
+     fprintf (stderr, "Error:  Out of memory.\n");
+     exit (-1);
+  }
+  rk = 0;
+  for (k = 0; k < n; k ++) {
+      FftRevTable [k] = rk;
+      m = n;
+      while (rk & (m >>= 1))
+        rk &= ~m;
+      rk |= m;
+  }
+  for (k = 0; k < n; k ++)
+      FftCosTable [k] = cos (2.0 * M_PI * k / n);
+  FftSetupSize = n;
+}
+
+// Frees the FFT tables.
+static void FftCleanup (void) {
+  free (FftRevTable);
+  DestroyArray (FftCosTable);
+  FftRevTable = NULL;
+  FftCosTable = NULL;
+  FftSetupSize = 0;
+}
+
 // Performs bit-reversal ordering.
 static void FftArrange (const uint n, const double * inR, const double * inI, double * outR, double * outI) {
-  uint rk, k, m;
+  uint rk, k;
   double tempR, tempI;
 
   if ((inR == outR) && (inI == outI)) {
      // Handle in-place arrangement.
-     rk = 0;
      for (k = 0; k < n; k ++) {
+         rk = FftRevTable [k];
          if (rk > k) {
             tempR = inR [rk];
             tempI = inI [rk];
@@ -833,61 +914,77 @@ static void FftArrange (const uint n, const double * inR, const double * inI, do
             outR [k] = tempR;
             outI [k] = tempI;
          }
-         m = n;
-         while (rk & (m >>= 1))
-           rk &= ~m;
-         rk |= m;
      }
   } else {
      // Handle copy arrangement.
-     rk = 0;
      for (k = 0; k < n; k ++) {
+         rk = FftRevTable [k];
          outR [rk] = inR [k];
          outI [rk] = inI [k];
-         m = n;
-         while (rk & (m >>= 1))
-           rk &= ~m;
-         rk |= m;
      }
   }
 }
 
-// Performs the summation.
+/* Performs the summation.  The first two passes are combined into radix-4
+ * butterflies, since their twiddle factors are all 1 or +/-i.  The rest are
+ * radix-2, with the twiddle factors taken from the table.  Each pass handles
+ * the butterflies of a block together, so the inner loop runs over sequential
+ * elements and can be vectorized by the compiler.
+ */
 static void FftSummation (const uint n, const double s, double * re, double * im) {
-  double pi;
-  uint m, m2;
-  double vR, vI, wR, wI;
-  uint i, k, mk;
-  double tR, tI;
-
-  pi = s * M_PI;
-  for (m = 1, m2 = 2; m < n; m <<= 1, m2 <<= 1) {
-      // v = Complex (-2.0 * sin (0.5 * pi / m) * sin (0.5 * pi / m), -sin (pi / m))
-      vR = sin (0.5 * pi / m);
-      vR = -2.0 * vR * vR;
-      vI = -sin (pi / m);
-      // w = Complex (1.0, 0.0)
-      wR = 1.0;
-      wI = 0.0;
-      for (i = 0; i < m; i ++) {
-          for (k = i; k < n; k += m2) {
-              mk = k + m;
-              // t = ComplexMul (w, out [km2])
+  const uint quarter = n / 4;
+  uint m, m2, step, i, k, mk;
+  double aR, aI, bR, bI, cR, cI, dR, dI;
+  double wR, wI, tR, tI;
+
+  if (n < 4) {
+     if (n == 2) {
+        tR = re [1];
+        tI = im [1];
+        re [1] = re [0] - tR;
+        im [1] = im [0] - tI;
+        re [0] += tR;
+        im [0] += tI;
+     }
+     return;
+  }
+  for (k = 0; k < n; k += 4) {
+      aR = re [k] + re [k + 1];
+      aI = im [k] + im [k + 1];
+      bR = re [k] - re [k + 1];
+      bI = im [k] - im [k + 1];
+      cR = re [k + 2] + re [k + 3];
+      cI = im [k + 2] + im [k + 3];
+      // d = (x[k + 2] - x[k + 3]) * Complex (0.0, -s)
+      dR = s * (im [k + 2] - im [k + 3]);
+      dI = -s * (re [k + 2] - re [k + 3]);
+      re [k] = aR + cR;
+      im [k] = aI + cI;
+      re [k + 2] = aR - cR;
+      im [k + 2] = aI - cI;
+      re [k + 1] = bR + dR;
+      im [k + 1] = bI + dI;
+      re [k + 3] = bR - dR;
+      im [k + 3] = bI - dI;
+  }
+  for (m = 4, m2 = 8; m < n; m <<= 1, m2 <<= 1) {
+      // w_i = Complex (cos (pi i / m), -s sin (pi i / m))
+      step = n / m2;
+      for (k = 0; k < n; k += m2) {
+          for (i = 0; i < m; i ++) {
+              wR = FftCosTable [i * step];
+              wI = -s * FftCosTable [((i * step) + (3 * quarter)) & (n - 1)];
+              mk = k + i + m;
+              // t = ComplexMul (w, out [mk])
               tR = (wR * re [mk]) - (wI * im [mk]);
               tI = (wR * im [mk]) + (wI * re [mk]);
-              // out [mk] = ComplexSub (out [k], t)
-              re [mk] = re [k] - tR;
-              im [mk] = im [k] - tI;
-              // out [k] = ComplexAdd (out [k], t)
-              re [k] += tR;
-              im [k] += tI;
+              // out [mk] = ComplexSub (out [k + i], t)
+              re [mk] = re [k + i] - tR;
+              im [mk] = im [k + i] - tI;
+              // out [k + i] = ComplexAdd (out [k + i], t)
+              re [k + i] += tR;
+              im [k + i] += tI;
           }
-          // t = ComplexMul (v, w)
-          tR = (vR * wR) - (vI * wI);
-          tI = (vR * wI) + (vI * wR);
-          // w = ComplexAdd (w, t)
-          wR += tR;
-          wI += tI;
       }
   }
 }
@@ -1843,40 +1940,116 @@ static void DiffuseFieldEqualize (const double * dfa, const HrirDataT * hData) {
   }
 }
 
-// Perform minimum-phase reconstruction using the magnitude responses of the
-// HRIR set.
-static void ReconstructHrirs (const HrirDataT * hData) {
-  double * re = NULL, * im = NULL;
-  uint step, start, end, n, j, i;
+// Get the number of processors available for running the HRIR processing
+// threads.
+static uint GetProcessorCount (void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+
+  GetSystemInfo (& info);
+  if (info . dwNumberOfProcessors > 0)
+     return (info . dwNumberOfProcessors);
+#elif defined (_SC_NPROCESSORS_ONLN)
+  long count;
+
+  count = sysconf (_SC_NPROCESSORS_ONLN);
+  if (count > 0)
+     return ((uint) count);
+#endif
+  return (1);
+}
+
+// Process a range of HRIRs on a worker thread.
+static int HrirWorkerProc (void * arg) {
+  const HrirWorkerT * worker = (const HrirWorkerT *) arg;
+  const HrirDataT * hData = worker -> mData;
+  double * scratch = NULL;
+  uint j;
+
+  scratch = CreateArray (2 * ((hData -> mFftSize > hData -> mIrSize) ? hData -> mFftSize : hData -> mIrSize));
+  for (j = worker -> mStart; j < worker -> mEnd; j += hData -> mIrSize)
+      worker -> mFunc (hData, j, scratch, worker -> mArg);
+  DestroyArray (scratch);
+  return (0);
+}
+
+/* Run the given routine on each HRIR of the set (from the starting
+ * elevation), splitting them evenly between the given number of threads.
+ * The routine must only modify the HRIR it's given.  If a thread can't be
+ * started, its HRIRs are processed on the calling thread instead.
+ */
+static void ProcessHrirs (const uint threads, const HrirDataT * hData, const HrirFuncT func, void * arg) {
+  HrirWorkerT workers [MAX_THREADS];
+  althrd_t thrds [MAX_THREADS];
+  int started [MAX_THREADS];
+  uint step, first, count, n, t;
 
   step = hData -> mIrSize;
-  start = hData -> mEvOffset [hData -> mEvStart] * step;
-  end = hData -> mIrCount * step;
-  n = hData -> mFftSize;
-  re = CreateArray (n);
-  im = CreateArray (n);
-  for (j = start; j < end; j += step) {
-      MinimumPhase (n, & hData -> mHrirs [j], re, im);
-      FftInverse (n, re, im, re, im);
-      for (i = 0; i < hData -> mIrPoints; i ++)
-          hData -> mHrirs [j + i] = re [i];
+  first = hData -> mEvOffset [hData -> mEvStart];
+  count = hData -> mIrCount - first;
+  n = threads;
+  if (n > MAX_THREADS)
+     n = MAX_THREADS;
+  if (n > count)
+     n = count;
+  if (n < 1)
+     n = 1;
+  for (t = 0; t < n; t ++) {
+      workers [t] . mData = hData;
+      workers [t] . mFunc = func;
+      workers [t] . mArg = arg;
+      workers [t] . mStart = (first + ((count * t) / n)) * step;
+      workers [t] . mEnd = (first + ((count * (t + 1)) / n)) * step;
+  }
+  // The first range is processed on the calling thread.
+  started [0] = 0;
+  for (t = 1; t < n; t ++)
+      started [t] = (althrd_create (& thrds [t], HrirWorkerProc, & workers [t]) == althrd_success);
+  HrirWorkerProc (& workers [0]);
+  for (t = 1; t < n; t ++) {
+      if (started [t])
+         althrd_join (thrds [t], NULL);
+      else
+         HrirWorkerProc (& workers [t]);
   }
-  DestroyArray (im);
-  DestroyArray (re);
+}
+
+// Perform minimum-phase reconstruction of one HRIR using its magnitude
+// response.
+static void ReconstructHrir (const HrirDataT * hData, const uint j, double * scratch, void * arg) {
+  const uint n = hData -> mFftSize;
+  double * re = scratch, * im = & scratch [n];
+  uint i;
+
+  (void) arg;
+  MinimumPhase (n, & hData -> mHrirs [j], re, im);
+  FftInverse (n, re, im, re, im);
+  for (i = 0; i < hData -> mIrPoints; i ++)
+      hData -> mHrirs [j + i] = re [i];
+}
+
+// Perform minimum-phase reconstruction using the magnitude responses of the
+// HRIR set.
+static void ReconstructHrirs (const uint threads, const HrirDataT * hData) {
+  ProcessHrirs (threads, hData, ReconstructHrir, NULL);
+}
+
+// Resample one HRIR with the given resampler.
+static void ResampleHrir (const HrirDataT * hData, const uint j, double * scratch, void * arg) {
+  const uint n = hData -> mIrPoints;
+  uint i;
+
+  ResamplerRun ((ResamplerT *) arg, n, & hData -> mHrirs [j], n, scratch);
+  for (i = 0; i < n; i ++)
+      hData -> mHrirs [j + i] = scratch [i];
 }
 
 // Resamples the HRIRs for use at the given sampling rate.
-static void ResampleHrirs (const uint rate, HrirDataT * hData) {
+static void ResampleHrirs (const uint threads, const uint rate, HrirDataT * hData) {
   ResamplerT rs;
-  uint n, step, start, end, j;
 
   ResamplerSetup (& rs, hData -> mIrRate, rate);
-  n = hData -> mIrPoints;
-  step = hData -> mIrSize;
-  start = hData -> mEvOffset [hData -> mEvStart] * step;
-  end = hData -> mIrCount * step;
-  for (j = start; j < end; j += step)
-      ResamplerRun (& rs, n, & hData -> mHrirs [j], n, & hData -> mHrirs [j]);
+  ProcessHrirs (threads, hData, ResampleHrir, & rs);
   ResamplerClear (& rs);
   hData -> mIrRate = rate;
 }
@@ -2089,6 +2262,96 @@ static int StoreMhr (const HrirDataT * hData, const char * filename) {
   return (1);
 }
 
+// Write the given number of zero bytes to a file, for padding.
+static int WritePadding (const uint bytes, FILE * fp, const char * filename) {
+  uint i;
+
+  for (i = 0; i < bytes; i ++) {
+      if (fputc (0, fp) == EOF) {
+         fprintf (stderr, "Error:  Bad write to file '%s'.\n", filename);
+         return (0);
+      }
+  }
+  return (1);
+}
+
+// Store the OpenAL Soft HRTF data set in the v2 format.  Unlike v1, the
+// tables are laid out so the library can map the file and use it in place:
+// the elevation offsets are stored rather than derived, and the coefficients
+// are aligned 32-bit floats.
+static int StoreMhrV2 (const HrirDataT * hData, const char * filename) {
+  FILE * fp = NULL;
+  uint e, step, end, n, j, i;
+  uint evOffsetPos, coeffPos, delayPos, offset;
+  union { float f; uint32 u; } coeff;
+  int v;
+
+  evOffsetPos = (MHR_V2_HEADER_SIZE + hData -> mEvCount + 1) & ~1u;
+  coeffPos = evOffsetPos + (2 * hData -> mEvCount);
+  coeffPos = (coeffPos + MHR_V2_ALIGNMENT - 1) & ~(MHR_V2_ALIGNMENT - 1);
+  delayPos = coeffPos + (4 * hData -> mIrCount * hData -> mIrPoints);
+  if ((fp = fopen (filename, "wb")) == NULL) {
+     fprintf (stderr, "Error:  Could not open MHR file '%s'.\n", filename);
+     return (0);
+  }
+  if (! WriteAscii (MHR_FORMAT_V2, fp, filename))
+     return (0);
+  if ((! WriteBin4 (BO_LITTLE, 4, (uint32) hData -> mIrRate, fp, filename)) ||
+      (! WriteBin4 (BO_LITTLE, 2, (uint32) hData -> mIrPoints, fp, filename)) ||
+      (! WriteBin4 (BO_LITTLE, 1, (uint32) hData -> mEvCount, fp, filename)) ||
+      (! WritePadding (1, fp, filename)) ||
+      (! WriteBin4 (BO_LITTLE, 4, (uint32) hData -> mIrCount, fp, filename)) ||
+      (! WriteBin4 (BO_LITTLE, 4, (uint32) coeffPos, fp, filename)) ||
+      (! WriteBin4 (BO_LITTLE, 4, (uint32) delayPos, fp, filename)) ||
+      (! WriteBin4 (BO_LITTLE, 4, (uint32) ((hData -> mDistance * 1000.0) + 0.5), fp, filename))) {
+     fclose (fp);
+     return (0);
+  }
+  for (e = 0; e < hData -> mEvCount; e ++) {
+      if (! WriteBin4 (BO_LITTLE, 1, (uint32) hData -> mAzCount [e], fp, filename)) {
+         fclose (fp);
+         return (0);
+      }
+  }
+  if (! WritePadding (evOffsetPos - MHR_V2_HEADER_SIZE - hData -> mEvCount, fp, filename)) {
+     fclose (fp);
+     return (0);
+  }
+  offset = 0;
+  for (e = 0; e < hData -> mEvCount; e ++) {
+      if (! WriteBin4 (BO_LITTLE, 2, (uint32) offset, fp, filename)) {
+         fclose (fp);
+         return (0);
+      }
+      offset += hData -> mAzCount [e];
+  }
+  if (! WritePadding (coeffPos - evOffsetPos - (2 * hData -> mEvCount), fp, filename)) {
+     fclose (fp);
+     return (0);
+  }
+  step = hData -> mIrSize;
+  end = hData -> mIrCount * step;
+  n = hData -> mIrPoints;
+  for (j = 0; j < end; j += step) {
+      for (i = 0; i < n; i ++) {
+          coeff . f = (float) hData -> mHrirs [j + i];
+          if (! WriteBin4 (BO_LITTLE, 4, coeff . u, fp, filename)) {
+             fclose (fp);
+             return (0);
+          }
+      }
+  }
+  for (j = 0; j < hData -> mIrCount; j ++) {
+      v = (int) fmin (round (hData -> mIrRate * hData -> mHrtds [j]), MAX_HRTD);
+      if (! WriteBin4 (BO_LITTLE, 1, (uint32) v, fp, filename)) {
+         fclose (fp);
+         return (0);
+      }
+  }
+  fclose (fp);
+  return (1);
+}
+
 // Store the OpenAL Soft built-in table.
 static int StoreTable (const HrirDataT * hData, const char * filename) {
   FILE * fp = NULL;
@@ -2504,16 +2767,69 @@ static int ProcessSources (const HeadModelT model, TokenReaderT * tr, HrirDataT
   return (0);
 }
 
+/* Produce the data set for the given output rate (0 to keep the source
+ * rate) from the reconstructed minimum-phase HRIRs, and store it.  The HRIRs
+ * are copied, so the same set can be used for each rate.
+ */
+static int ProcessOutputRate (const HrirDataT * srcData, const uint outRate, const uint truncSize, const HeadModelT model, const double radius, const OutputFormatT outFormat, const uint mhrVersion, const char * outName, const uint threads) {
+  HrirDataT hData;
+  char rateStr [8 + 1], expName [MAX_PATH_LEN];
+  int result;
+
+  hData = (* srcData);
+  hData . mHrirs = CreateArray (hData . mIrCount * hData . mIrSize);
+  hData . mHrtds = CreateArray (hData . mIrCount);
+  memcpy (hData . mHrirs, srcData -> mHrirs, hData . mIrCount * hData . mIrSize * sizeof (double));
+  memcpy (hData . mHrtds, srcData -> mHrtds, hData . mIrCount * sizeof (double));
+  if ((outRate != 0) && (outRate != hData . mIrRate)) {
+     fprintf (stdout, "Resampling HRIRs to %uhz...\n", outRate);
+     ResampleHrirs (threads, outRate, & hData);
+  }
+  fprintf (stdout, "Truncating minimum-phase HRIRs...\n");
+  hData . mIrPoints = truncSize;
+  fprintf (stdout, "Synthesizing missing elevations...\n");
+  if (model == HM_DATASET)
+     SynthesizeOnsets (& hData);
+  SynthesizeHrirs (& hData);
+  fprintf (stdout, "Normalizing final HRIRs...\n");
+  NormalizeHrirs (& hData);
+  fprintf (stdout, "Calculating impulse delays...\n");
+  CalculateHrtds (model, (radius > DEFAULT_CUSTOM_RADIUS) ? radius : hData . mRadius, & hData);
+  snprintf (rateStr, 8, "%u", hData . mIrRate);
+  StrSubst (outName, "%r", rateStr, MAX_PATH_LEN, expName);
+  result = 1;
+  switch (outFormat) {
+    case OF_MHR :
+      fprintf (stdout, "Creating MHR data set file (v%u)...\n", mhrVersion);
+      if (mhrVersion == 1)
+         result = StoreMhr (& hData, expName);
+      else
+         result = StoreMhrV2 (& hData, expName);
+    break;
+    case OF_TABLE :
+      fprintf (stderr, "Creating OpenAL Soft table file...\n");
+      result = StoreTable (& hData, expName);
+    break;
+    default :
+    break;
+  }
+  DestroyArray (hData . mHrtds);
+  DestroyArray (hData . mHrirs);
+  return (result);
+}
+
 /* Parse the data set definition and process the source data, storing the
- * resulting data set as desired.  If the input name is NULL it will read
- * from standard input.
+ * resulting data set for each of the given output rates (or the source rate
+ * if none are given).  If the input name is NULL it will read from standard
+ * input.
  */
-static int ProcessDefinition (const char * inName, const uint outRate, const uint fftSize, const int equalize, const int surface, const double limit, const uint truncSize, const HeadModelT model, const double radius, const OutputFormatT outFormat, const char * outName) {
+static int ProcessDefinition (const char * inName, const uint rateCount, const uint * outRates, const uint fftSize, const int equalize, const int surface, const double limit, const uint truncSize, const HeadModelT model, const double radius, const OutputFormatT outFormat, const uint mhrVersion, const char * outName, const uint threads) {
   FILE * fp = NULL;
   TokenReaderT tr;
   HrirDataT hData;
   double * dfa = NULL;
-  char rateStr [8 + 1], expName [MAX_PATH_LEN];
+  uint ri;
+  int result;
 
   hData . mIrRate = 0;
   hData . mIrPoints = 0;
@@ -2540,6 +2856,7 @@ static int ProcessDefinition (const char * inName, const uint outRate, const uin
         fclose (fp);
      return (0);
   }
+  FftSetup (hData . mFftSize);
   hData . mHrirs = CreateArray (hData . mIrCount * hData . mIrSize);
   hData . mHrtds = CreateArray (hData . mIrCount);
   if (! ProcessSources (model, & tr, & hData)) {
@@ -2559,41 +2876,16 @@ static int ProcessDefinition (const char * inName, const uint outRate, const uin
      DiffuseFieldEqualize (dfa, & hData);
      DestroyArray (dfa);
   }
-  fprintf (stdout, "Performing minimum phase reconstruction...\n");
-  ReconstructHrirs (& hData);
-  if ((outRate != 0) && (outRate != hData . mIrRate)) {
-     fprintf (stdout, "Resampling HRIRs...\n");
-     ResampleHrirs (outRate, & hData);
-  }
-  fprintf (stdout, "Truncating minimum-phase HRIRs...\n");
-  hData . mIrPoints = truncSize;
-  fprintf (stdout, "Synthesizing missing elevations...\n");
-  if (model == HM_DATASET)
-     SynthesizeOnsets (& hData);
-  SynthesizeHrirs (& hData);
-  fprintf (stdout, "Normalizing final HRIRs...\n");
-  NormalizeHrirs (& hData);
-  fprintf (stdout, "Calculating impulse delays...\n");
-  CalculateHrtds (model, (radius > DEFAULT_CUSTOM_RADIUS) ? radius : hData . mRadius, & hData);
-  snprintf (rateStr, 8, "%u", hData . mIrRate);
-  StrSubst (outName, "%r", rateStr, MAX_PATH_LEN, expName);
-  switch (outFormat) {
-    case OF_MHR :
-      fprintf (stdout, "Creating MHR data set file...\n");
-      if (! StoreMhr (& hData, expName))
-         return (0);
-    break;
-    case OF_TABLE :
-      fprintf (stderr, "Creating OpenAL Soft table file...\n");
-      if (! StoreTable (& hData, expName))
-         return (0);
-    break;
-    default :
-    break;
-  }
+  fprintf (stdout, "Performing minimum phase reconstruction (%u thread%s)...\n", threads, (threads == 1) ? "" : "s");
+  ReconstructHrirs (threads, & hData);
+  result = 1;
+  if (rateCount == 0)
+     result = ProcessOutputRate (& hData, 0, truncSize, model, radius, outFormat, mhrVersion, outName, threads);
+  for (ri = 0; (ri < rateCount) && result; ri ++)
+      result = ProcessOutputRate (& hData, outRates [ri], truncSize, model, radius, outFormat, mhrVersion, outName, threads);
   DestroyArray (hData . mHrtds);
   DestroyArray (hData . mHrirs);
-  return (1);
+  return (result);
 }
 
 // Standard command line dispatch.
@@ -2601,12 +2893,16 @@ int main (const int argc, const char * argv []) {
   const char * inName = NULL, * outName = NULL;
   OutputFormatT outFormat;
   int argi;
-  uint outRate, fftSize;
+  uint outRates [MAX_OUT_RATES], rateCount, fftSize;
   int equalize, surface;
   double limit;
   uint truncSize;
   HeadModelT model;
   double radius;
+  uint mhrVersion;
+  uint threads;
+  int result;
+  const char * str = NULL;
   char * end = NULL;
 
   if (argc < 2) {
@@ -2623,8 +2919,10 @@ int main (const int argc, const char * argv []) {
      fprintf (stdout, "                 Defaults output to: ./hrtf_tables.inc\n");
      fprintf (stdout, " -h, --help      Displays this help information.\n\n");
      fprintf (stdout, "Options:\n");
-     fprintf (stdout, " -r=<rate>       Change the data set sample rate to the specified value and\n");
-     fprintf (stdout, "                 resample the HRIRs accordingly.\n");
+     fprintf (stdout, " -r=<rate>[,...] Change the data set sample rate to the specified value and\n");
+     fprintf (stdout, "                 resample the HRIRs accordingly.  Up to %u comma-separated\n", MAX_OUT_RATES);
+     fprintf (stdout, "                 rates make a data set for each from one pass over the\n");
+     fprintf (stdout, "                 sources (the output name must then use '%%r').\n");
      fprintf (stdout, " -f=<points>     Override the FFT window size (defaults to the first power-\n");
      fprintf (stdout, "                 of-two that fits four times the number of HRIR points).\n");
      fprintf (stdout, " -e={on|off}     Toggle diffuse-field equalization (default: %s).\n", (DEFAULT_EQUALIZE ? "on" : "off"));
@@ -2636,6 +2934,11 @@ int main (const int argc, const char * argv []) {
      fprintf (stdout, " -d={dataset|    Specify the model used for calculating the head-delay timing\n");
      fprintf (stdout, "     sphere}     values (default: %s).\n", ((DEFAULT_HEAD_MODEL == HM_DATASET) ? "dataset" : "sphere"));
      fprintf (stdout, " -c=<size>       Use a customized head radius measured ear-to-ear in meters.\n");
+     fprintf (stdout, " -v={1|2}        Specify the MHR format version to write (default: %u).  Version\n", DEFAULT_MHR_VERSION);
+     fprintf (stdout, "                 2 is memory-mapped by the library, but older releases of\n");
+     fprintf (stdout, "                 OpenAL Soft can only read version 1.\n");
+     fprintf (stdout, " -j=<threads>    Specify the number of threads used to process the HRIRs\n");
+     fprintf (stdout, "                 (default: the number of processors).\n");
      fprintf (stdout, " -i=<filename>   Specify an HRIR definition file to use (defaults to stdin).\n");
      fprintf (stdout, " -o=<filename>   Specify an output file.  Overrides command-selected default.\n");
      fprintf (stdout, "                 Use of '%%r' will be substituted with the data set sample rate.\n");
@@ -2658,7 +2961,7 @@ int main (const int argc, const char * argv []) {
      return (-1);
   }
   argi = 2;
-  outRate = 0;
+  rateCount = 0;
   fftSize = 0;
   equalize = DEFAULT_EQUALIZE;
   surface = DEFAULT_SURFACE;
@@ -2666,12 +2969,26 @@ int main (const int argc, const char * argv []) {
   truncSize = DEFAULT_TRUNCSIZE;
   model = DEFAULT_HEAD_MODEL;
   radius = DEFAULT_CUSTOM_RADIUS;
+  mhrVersion = DEFAULT_MHR_VERSION;
+  threads = DEFAULT_THREADS;
   while (argi < argc) {
     if (strncmp (argv [argi], "-r=", 3) == 0) {
-       outRate = strtoul (& argv [argi] [3], & end, 10);
-       if ((end [0] != '\0') || (outRate < MIN_RATE) || (outRate > MAX_RATE)) {
-          fprintf (stderr, "Error:  Expected a value from %u to %u for '-r'.\n", MIN_RATE, MAX_RATE);
-          return (-1);
+       rateCount = 0;
+       str = & argv [argi] [3];
+       for (;;) {
+           outRates [rateCount] = strtoul (str, & end, 10);
+           if ((end == str) || ((end [0] != '\0') && (end [0] != ',')) || (outRates [rateCount] < MIN_RATE) || (outRates [rateCount] > MAX_RATE)) {
+              fprintf (stderr, "Error:  Expected values from %u to %u for '-r'.\n", MIN_RATE, MAX_RATE);
+              return (-1);
+           }
+           rateCount ++;
+           if (end [0] == '\0')
+              break;
+           if (rateCount >= MAX_OUT_RATES) {
+              fprintf (stderr, "Error:  Expected at most %u values for '-r'.\n", MAX_OUT_RATES);
+              return (-1);
+           }
+           str = end + 1;
        }
     } else if (strncmp (argv [argi], "-f=", 3) == 0) {
        fftSize = strtoul (& argv [argi] [3], & end, 10);
@@ -2728,6 +3045,18 @@ int main (const int argc, const char * argv []) {
           fprintf (stderr, "Error:  Expected a value from %.2f to %.2f for '-c'.\n", MIN_CUSTOM_RADIUS, MAX_CUSTOM_RADIUS);
           return (-1);
        }
+    } else if (strncmp (argv [argi], "-v=", 3) == 0) {
+       mhrVersion = strtoul (& argv [argi] [3], & end, 10);
+       if ((end [0] != '\0') || (mhrVersion < 1) || (mhrVersion > 2)) {
+          fprintf (stderr, "Error:  Expected 1 or 2 for '-v'.\n");
+          return (-1);
+       }
+    } else if (strncmp (argv [argi], "-j=", 3) == 0) {
+       threads = strtoul (& argv [argi] [3], & end, 10);
+       if ((end [0] != '\0') || (threads < 1) || (threads > MAX_THREADS)) {
+          fprintf (stderr, "Error:  Expected a value from 1 to %u for '-j'.\n", MAX_THREADS);
+          return (-1);
+       }
     } else if (strncmp (argv [argi], "-i=", 3) == 0) {
        inName = & argv [argi] [3];
     } else if (strncmp (argv [argi], "-o=", 3) == 0) {
@@ -2738,7 +3067,18 @@ int main (const int argc, const char * argv []) {
     }
     argi ++;
   }
-  if (! ProcessDefinition (inName, outRate, fftSize, equalize, surface, limit, truncSize, model, radius, outFormat, outName))
+  if ((rateCount > 1) && (strstr (outName, "%r") == NULL)) {
+     fprintf (stderr, "Error:  The output name must use '%%r' with multiple rates.\n");
+     return (-1);
+  }
+  if (threads == 0) {
+     threads = GetProcessorCount ();
+     if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+  }
+  result = ProcessDefinition (inName, rateCount, outRates, fftSize, equalize, surface, limit, truncSize, model, radius, outFormat, mhrVersion, outName, threads);
+  FftCleanup ();
+  if (! result)
      return (-1);
   fprintf (stdout, "Operation completed.\n");
   return (0);
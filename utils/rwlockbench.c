@@ -0,0 +1,239 @@
+/*
+ * Read-write lock contention benchmark
+ *
+ * Runs a number of threads that take an RWLock for reading and writing in
+ * different proportions, and reports the wall clock and CPU time they took.
+ * One case has the writer hold the lock for a long time, as if it were
+ * preempted, to show how much CPU time the waiting threads burn. The readers
+ * also check that they never see a writer's update half done. Last, a reader
+ * and a writer repeatedly lock once each, to check neither is left waiting
+ * after the other is done.
+ *
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "rwlock.h"
+#include "threads.h"
+
+
+#define MAX_THREADS 16
+#define NUM_OPS     200000
+
+#define HANDOFF_ROUNDS  10000
+/* How long a handoff round may take before a thread is taken as stuck, in
+ * milliseconds. */
+#define HANDOFF_TIMEOUT 2000
+
+typedef struct BenchCase {
+    const char *name;
+    /* One in this many operations is a write. */
+    unsigned int write_ratio;
+    /* How long writers hold the lock, in microseconds. */
+    long write_hold;
+    unsigned int num_ops;
+} BenchCase;
+
+static const BenchCase Cases[] = {
+    { "read only",              0, 0, NUM_OPS    },
+    { "1% writes",            100, 0, NUM_OPS    },
+    { "25% writes",             4, 0, NUM_OPS    },
+    { "all writes",             1, 0, NUM_OPS/4  },
+    { "1% writes, held 500us", 100, 500, NUM_OPS/400 },
+};
+
+static RWLock Lock;
+/* Writers update both values, and readers check they match. */
+static volatile unsigned int Values[2];
+static ATOMIC(unsigned int) Mismatches;
+static ATOMIC(int) Running;
+
+static const BenchCase *CurCase;
+
+static ATOMIC(int) HandoffDone;
+
+
+static double GetTime(void)
+{
+    struct timespec ts;
+    altimespec_get(&ts, AL_TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec/1000000000.0;
+}
+
+static int BenchProc(void *arg)
+{
+    unsigned int seed = (unsigned int)(size_t)arg*2654435761u + 1;
+    unsigned int i;
+
+    while(!ATOMIC_LOAD(&Running))
+        althrd_yield();
+
+    for(i = 0;i < CurCase->num_ops;i++)
+    {
+        seed = seed*1103515245u + 12345u;
+        if(CurCase->write_ratio > 0 && (seed>>8)%CurCase->write_ratio == 0)
+        {
+            WriteLock(&Lock);
+            Values[0]++;
+            if(CurCase->write_hold > 0)
+            {
+                struct timespec ts = { 0, CurCase->write_hold*1000 };
+                althrd_sleep(&ts, NULL);
+            }
+            Values[1]++;
+            WriteUnlock(&Lock);
+        }
+        else
+        {
+            ReadLock(&Lock);
+            if(Values[0] != Values[1])
+                ATOMIC_ADD(unsigned int, &Mismatches, 1);
+            ReadUnlock(&Lock);
+        }
+    }
+
+    return 0;
+}
+
+static void RunCase(const BenchCase *bench, int num_threads)
+{
+    althrd_t threads[MAX_THREADS];
+    clock_t cpu_start;
+    double start;
+    int i;
+
+    CurCase = bench;
+    ATOMIC_STORE(&Running, 0);
+    for(i = 0;i < num_threads;i++)
+        althrd_create(&threads[i], BenchProc, (void*)(size_t)i);
+
+    cpu_start = clock();
+    start = GetTime();
+    ATOMIC_STORE(&Running, 1);
+    for(i = 0;i < num_threads;i++)
+    {
+        int res;
+        althrd_join(threads[i], &res);
+    }
+
+    printf("%-22s %2d threads  %9.2f ms wall  %9.2f ms CPU  %8.1f ns/op\n", bench->name,
+           num_threads, (GetTime()-start) * 1000.0,
+           (double)(clock()-cpu_start) / CLOCKS_PER_SEC * 1000.0,
+           (GetTime()-start) * 1000000000.0 / ((double)bench->num_ops*num_threads));
+}
+
+
+static int HandoffReadProc(void *arg)
+{
+    (void)arg;
+    ReadLock(&Lock);
+    ReadUnlock(&Lock);
+    ATOMIC_ADD(int, &HandoffDone, 1);
+    return 0;
+}
+
+static int HandoffWriteProc(void *arg)
+{
+    (void)arg;
+    WriteLock(&Lock);
+    Values[0]++;
+    Values[1]++;
+    WriteUnlock(&Lock);
+    ATOMIC_ADD(int, &HandoffDone, 1);
+    return 0;
+}
+
+/* Returns 0 if a thread never finished. The stuck thread can't be joined, so
+ * the caller should exit right away. */
+static int RunHandoff(void)
+{
+    const struct timespec wait = { 0, 1000000 };
+    int round, waited, res;
+
+    for(round = 0;round < HANDOFF_ROUNDS;round++)
+    {
+        althrd_t reader, writer;
+
+        ATOMIC_STORE(&HandoffDone, 0);
+        althrd_create(&writer, HandoffWriteProc, NULL);
+        althrd_create(&reader, HandoffReadProc, NULL);
+
+        waited = 0;
+        while(ATOMIC_LOAD(&HandoffDone) < 2)
+        {
+            if(waited++ >= HANDOFF_TIMEOUT)
+            {
+                printf("Handoff round %d timed out\n", round);
+                return 0;
+            }
+            althrd_sleep(&wait, NULL);
+        }
+        althrd_join(writer, &res);
+        althrd_join(reader, &res);
+    }
+
+    printf("%-22s %d rounds ok\n", "reader/writer handoff", HANDOFF_ROUNDS);
+    return 1;
+}
+
+
+int main(int argc, char *argv[])
+{
+    int max_threads = 8;
+    int num_threads;
+    size_t i;
+
+    if(argc > 1)
+    {
+        max_threads = atoi(argv[1]);
+        if(max_threads < 1 || max_threads > MAX_THREADS)
+        {
+            fprintf(stderr, "Thread count must be between 1 and %d\n", MAX_THREADS);
+            return 1;
+        }
+    }
+
+    RWLockInit(&Lock);
+    ATOMIC_INIT(&Mismatches, 0);
+    ATOMIC_INIT(&Running, 0);
+    ATOMIC_INIT(&HandoffDone, 0);
+
+#ifdef USE_SPIN_RWLOCK
+    printf("Testing yielding spinlocks\n");
+#else
+    printf("Testing blocking locks\n");
+#endif
+    for(i = 0;i < sizeof(Cases)/sizeof(Cases[0]);i++)
+    {
+        for(num_threads = 1;num_threads <= max_threads;num_threads *= 2)
+            RunCase(&Cases[i], num_threads);
+    }
+    if(!RunHandoff())
+        return 1;
+
+    if(ATOMIC_LOAD(&Mismatches) > 0)
+    {
+        printf("Readers saw %u incomplete write(s)\n", ATOMIC_LOAD(&Mismatches));
+        return 1;
+    }
+    return 0;
+}